@@ -4,6 +4,8 @@
 option(BUILD_DOCUMENTATION "Build doxygen documentation" ON)
 option(BUILD_EXAMPLES "Build examples" ON)
 option(BUILD_TESTS "Build tests" ON)
+option(BUILD_BENCHMARKS "Build benchmarks" OFF)
+option(BUILD_CORE_CLI_TOOLS "Build core cli tools" ON)
 option(BUILD_SHARED_LIBS "Build shared libs" ON)
 option(BUILD_WITH_TIDY "Build with clang-tidy sanity check and code style" OFF)
 option(ITK_SUPPORT "Build ITK module" ON)
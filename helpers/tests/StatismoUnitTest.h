@@ -64,12 +64,15 @@
 #define STATISMO_ASSERT_LTE(a, b) _STATISMO_ASSERT_LTE(a, b, __FILE__, __LINE__);
 #define STATISMO_ASSERT_DOUBLE_EQ(a, b) _STATISMO_ASSERT_DOUBLE_EQ(a, b, __FILE__, __LINE__);
 
+// libstdc++ >= 9 already provides this overload (LWG 2221)
+#if !defined(_GLIBCXX_RELEASE) || _GLIBCXX_RELEASE < 9
 inline std::ostream &
 operator<<(std::ostream & os, std::nullptr_t)
 {
   os << "NULL";
   return os;
 }
+#endif
 
 namespace statismo::test
 {
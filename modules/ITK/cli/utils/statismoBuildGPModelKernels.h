@@ -268,6 +268,13 @@ public:
     return os.str();
   }
 
+  double
+  GetSupportRadius() const override
+  {
+    // the kernel vanishes as soon as the points are more than the support apart along one axis
+    return m_support * std::sqrt(static_cast<double>(TPoint::PointDimension));
+  }
+
 private:
   double m_support;
 };
@@ -317,6 +324,13 @@ public:
     return os.str();
   }
 
+  double
+  GetSupportRadius() const override
+  {
+    // the support of the levels decreases, the base level has the largest one
+    return m_kernels.empty() ? 0 : m_kernels.front()->GetSupportRadius();
+  }
+
 private:
   double                                              m_supportBaseLevel;
   unsigned                                            m_numberOfLevels;
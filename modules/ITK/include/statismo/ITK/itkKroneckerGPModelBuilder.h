@@ -0,0 +1,166 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __STATIMO_ITK_KRONECKER_GP_MODEL_BUILDER_H_
+#define __STATIMO_ITK_KRONECKER_GP_MODEL_BUILDER_H_
+
+#include "statismo/core/KroneckerGPModelBuilder.h"
+#include "statismo/core/Representer.h"
+#include "statismo/core/ImplWrapper.h"
+#include "statismo/ITK/itkStatisticalModel.h"
+#include "statismo/ITK/itkConfig.h"
+#include "statismo/ITK/itkUtils.h"
+
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+
+namespace itk
+{
+
+/**
+ * \brief ITK wrapper for statismo::KroneckerGPModelBuilder class
+ *
+ * The grid is taken from the reference image of the representer, so that the builder can
+ * be used in place of the LowRankGPModelBuilder for image (deformation) models.
+ *
+ * \warning The grid coordinates are computed along the image axes. For kernels that are not
+ * invariant under rotations (e.g. B-splines), the image direction should be the identity.
+ *
+ * \sa statismo::KroneckerGPModelBuilder for detailed documentation
+ * \ingroup ITK
+ * \ingroup ModelBuilders
+ */
+template <typename T>
+class KroneckerGPModelBuilder
+  : public Object
+  , public statismo::ImplWrapper<statismo::KroneckerGPModelBuilder<T>>
+{
+public:
+  using Self = KroneckerGPModelBuilder;
+  using RepresenterType = statismo::Representer<T>;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+  using ImplType = typename statismo::ImplWrapper<statismo::KroneckerGPModelBuilder<T>>::ImplType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(KroneckerGPModelBuilder, Object);
+
+  using StatisticalModelType = itk::StatisticalModel<T>;
+  using AxisKernelType = typename ImplType::AxisKernelType;
+  using AxisKernelListType = typename ImplType::AxisKernelListType;
+  using GridType = typename ImplType::GridType;
+
+  void
+  SetRepresenter(const RepresenterType * representer)
+  {
+    m_representer = representer;
+    this->SetStatismoImplObj(ImplType::SafeCreate(representer));
+  }
+
+  typename StatisticalModelType::Pointer
+  BuildNewZeroMeanModel(const AxisKernelListType & axisKernels, unsigned numComponents) const
+  {
+    if (!this->m_impl)
+    {
+      itkExceptionMacro(<< "Model not properly initialized. Maybe you forgot to call SetRepresenter");
+    }
+
+    auto itkModel = StatisticalModel<T>::New();
+    try
+    {
+      itkModel->SetStatismoImplObj(
+        this->m_impl->BuildNewZeroMeanModel(axisKernels, ComputeGrid(m_representer->GetReference()), numComponents));
+    }
+    catch (const statismo::StatisticalModelException & s)
+    {
+      itkExceptionMacro(<< s.what());
+    }
+
+    return itkModel;
+  }
+
+  typename StatisticalModelType::Pointer
+  BuildNewModel(typename RepresenterType::DatasetType * mean,
+                const AxisKernelListType &              axisKernels,
+                unsigned                                numComponents)
+  {
+    if (!this->m_impl)
+    {
+      itkExceptionMacro(<< "Model not properly initialized. Maybe you forgot to call SetRepresenter");
+    }
+
+    auto itkModel = StatisticalModel<T>::New();
+    try
+    {
+      itkModel->SetStatismoImplObj(
+        this->m_impl->BuildNewModel(mean, axisKernels, ComputeGrid(m_representer->GetReference()), numComponents));
+    }
+    catch (const statismo::StatisticalModelException & s)
+    {
+      itkExceptionMacro(<< s.what());
+    }
+
+    return itkModel;
+  }
+
+  /**
+   * \brief Compute the physical coordinates of the grid points along each axis of the image
+   */
+  static GridType
+  ComputeGrid(const T * image)
+  {
+    const auto & region = image->GetLargestPossibleRegion();
+    const auto & origin = image->GetOrigin();
+    const auto & spacing = image->GetSpacing();
+
+    GridType grid(T::ImageDimension);
+    for (unsigned a = 0; a < T::ImageDimension; ++a)
+    {
+      for (unsigned i = 0; i < region.GetSize()[a]; ++i)
+      {
+        grid[a].push_back(origin[a] + (region.GetIndex()[a] + i) * spacing[a]);
+      }
+    }
+    return grid;
+  }
+
+private:
+  const RepresenterType * m_representer{ nullptr };
+};
+
+} // namespace itk
+
+#endif
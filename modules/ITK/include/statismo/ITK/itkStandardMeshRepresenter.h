@@ -51,6 +51,7 @@
 #include <itkPointsLocator.h>
 
 #include <unordered_map>
+#include <vector>
 
 namespace statismo
 {
@@ -172,6 +173,13 @@ public:
   unsigned
   GetPointIdForPoint(const PointType & pt) const override;
 
+  /**
+   * The new reference has the given points and the cells of the reference whose points are all in the region,
+   * renumbered. The point data is kept.
+   */
+  StandardMeshRepresenter *
+  CloneForPoints(const std::vector<unsigned> & pointIds) const override;
+
 private:
   static unsigned
   GetDimensionsImpl()
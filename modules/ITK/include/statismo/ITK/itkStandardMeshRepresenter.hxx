@@ -49,6 +49,8 @@
 #include <itkTransformMeshFilter.h>
 #include <itkVector.h>
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -70,6 +72,58 @@ StandardMeshRepresenter<Pixel, MESH_DIMENSION>::CloneImpl() const
   return clone;
 }
 
+template <typename Pixel, unsigned MESH_DIMENSION>
+StandardMeshRepresenter<Pixel, MESH_DIMENSION> *
+StandardMeshRepresenter<Pixel, MESH_DIMENSION>::CloneForPoints(const std::vector<unsigned> & pointIds) const
+{
+  using CellAutoPointer = typename MeshType::CellType::CellAutoPointer;
+
+  // new id of each point of the reference, -1 for the points outside of the region
+  std::vector<long> newIds(m_reference->GetNumberOfPoints(), -1);
+
+  auto roi = MeshType::New();
+  for (unsigned i = 0; i < pointIds.size(); ++i)
+  {
+    newIds.at(pointIds[i]) = i;
+    roi->SetPoint(i, m_reference->GetPoint(pointIds[i]));
+
+    typename MeshType::PixelType value;
+    if (m_reference->GetPointData(pointIds[i], &value))
+    {
+      roi->SetPointData(i, value);
+    }
+  }
+
+  // the cells that are fully inside of the region
+  if (m_reference->GetCells())
+  {
+    typename MeshType::CellIdentifier numRoiCells = 0;
+    for (auto it = m_reference->GetCells()->Begin(); it != m_reference->GetCells()->End(); ++it)
+    {
+      const auto * cell = it.Value();
+      auto         cellPointIds = cell->PointIdsBegin();
+      unsigned     numCellPoints = cell->GetNumberOfPoints();
+      if (!std::all_of(cellPointIds, cellPointIds + numCellPoints, [&](auto id) { return newIds[id] >= 0; }))
+      {
+        continue;
+      }
+
+      CellAutoPointer roiCell;
+      cell->MakeCopy(roiCell);
+      for (unsigned d = 0; d < numCellPoints; ++d)
+      {
+        roiCell->SetPointId(d, newIds[cellPointIds[d]]);
+      }
+      roi->SetCell(numRoiCells++, roiCell);
+    }
+  }
+
+  auto clone = new StandardMeshRepresenter();
+  clone->SetReference(roi);
+  clone->SetLogger(this->GetLogger());
+  return clone;
+}
+
 template <typename Pixel, unsigned MESH_DIMENSION>
 void
 StandardMeshRepresenter<Pixel, MESH_DIMENSION>::Load(const H5::Group & fg)
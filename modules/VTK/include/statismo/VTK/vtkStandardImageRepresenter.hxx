@@ -201,19 +201,17 @@ template <class TScalar, unsigned PIXEL_DIMENSIONS>
 vtkSmartPointer<vtkStructuredPoints>
 vtkStandardImageRepresenter<TScalar, PIXEL_DIMENSIONS>::LoadRefLegacy(const H5::Group & fg) const
 {
-  auto tmpfilename = statismo::utils::CreateTmpName(".vtk");
-
-  auto uw = statismo::MakeStackUnwinder([=]() { statismo::utils::RemoveFile(tmpfilename); });
-
-  statismo::HDF5Utils::GetFileFromHDF5(fg, "./reference", tmpfilename.c_str());
+  // the reference is parsed directly from memory, so that no temporary file is needed
+  auto buffer = statismo::HDF5Utils::GetBufferFromHDF5(fg, "./reference");
 
   vtkNew<vtkStructuredPointsReader> reader;
-  reader->SetFileName(tmpfilename.c_str());
+  reader->ReadFromInputStringOn();
+  reader->SetInputString(buffer.data(), static_cast<int>(buffer.size()));
   reader->Update();
 
   if (reader->GetErrorCode() != 0)
   {
-    throw StatisticalModelException((std::string("Could not read file ") + tmpfilename).c_str(), Status::IO_ERROR);
+    throw StatisticalModelException("Could not read the legacy reference", Status::IO_ERROR);
   }
 
   return reader->GetOutput();
@@ -129,6 +129,13 @@ public:
   STATISMO_VTK_EXPORT unsigned
   GetPointIdForPoint(const PointType & pt) const override;
 
+  /**
+   * The new reference has the given points and the cells of the reference whose points are all in the region,
+   * renumbered. The point data is kept, the cell data is not.
+   */
+  STATISMO_VTK_EXPORT vtkStandardMeshRepresenter *
+                      CloneForPoints(const std::vector<unsigned> & pointIds) const override;
+
 private:
   STATISMO_VTK_EXPORT
   vtkStandardMeshRepresenter()
@@ -164,6 +164,10 @@ private:
   ReadDataset(const std::string & filename);
   static void
   WriteDataset(const std::string & filename, DatasetConstPointerType pd);
+  static DatasetPointerType
+  ReadDatasetFromString(const std::string & buffer);
+  static std::string
+  WriteDatasetToString(DatasetConstPointerType pd);
 
   STATISMO_VTK_EXPORT vtkUnstructuredGridRepresenter *
                       CloneImpl() const override;
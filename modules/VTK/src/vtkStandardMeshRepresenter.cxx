@@ -43,16 +43,100 @@
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
 #include <vtkDataSetAttributes.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
 #include <vtkPoints.h>
 #include <vtkPointData.h>
 #include <vtkPolyDataReader.h>
 #include <vtkNew.h>
+#include <vtkVersion.h>
 
 #include <memory>
+#include <type_traits>
 
 namespace statismo
 {
 
+namespace
+{
+using UIntMatrixType = statismo::GenericEigenTraits<unsigned int>::MatrixType;
+using IdMatrixType = Eigen::Matrix<vtkIdType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// The cells are stored as a cellDim x nCells matrix. The point ids of a cell are contiguous in the vtk arrays, hence
+// the matrix is the transpose of the connectivity of the cells.
+
+vtkSmartPointer<vtkCellArray>
+CreateCellArray(const UIntMatrixType & cellsMat)
+{
+  vtkIdType nCells = cellsMat.cols();
+  vtkIdType cellDim = cellsMat.rows();
+
+  auto cells = vtkSmartPointer<vtkCellArray>::New();
+#if VTK_MAJOR_VERSION >= 9
+  auto connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+  connectivity->SetNumberOfValues(nCells * cellDim);
+  Eigen::Map<IdMatrixType>(connectivity->GetPointer(0), nCells, cellDim) = cellsMat.transpose().cast<vtkIdType>();
+  cells->SetData(cellDim, connectivity);
+#else
+  // legacy layout, where each cell is given by its number of points followed by its point ids
+  auto legacyCells = vtkSmartPointer<vtkIdTypeArray>::New();
+  legacyCells->SetNumberOfValues(nCells * (cellDim + 1));
+  Eigen::Map<IdMatrixType> legacyCellsMat(legacyCells->GetPointer(0), nCells, cellDim + 1);
+  legacyCellsMat.col(0).setConstant(cellDim);
+  legacyCellsMat.rightCols(cellDim) = cellsMat.transpose().cast<vtkIdType>();
+  cells->SetCells(nCells, legacyCells);
+#endif
+  return cells;
+}
+
+// fill cellsMat with the cells if they all have the same number of points, and return false otherwise
+bool
+ExportHomogeneousCells(vtkCellArray * cells, UIntMatrixType & cellsMat)
+{
+  vtkIdType nCells = cells->GetNumberOfCells();
+#if VTK_MAJOR_VERSION >= 9
+  vtkIdType cellDim = cells->IsHomogeneous();
+  if (cellDim <= 0)
+  {
+    return false;
+  }
+
+  auto exportConnectivity = [&](auto * connectivity) {
+    using ValueType = std::remove_pointer_t<decltype(connectivity->GetPointer(0))>;
+    using ConnectivityMatrixType = Eigen::Matrix<ValueType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    cellsMat = Eigen::Map<const ConnectivityMatrixType>(connectivity->GetPointer(0), nCells, cellDim)
+                 .transpose()
+                 .template cast<unsigned int>();
+  };
+  if (cells->IsStorage64Bit())
+  {
+    exportConnectivity(cells->GetConnectivityArray64());
+  }
+  else
+  {
+    exportConnectivity(cells->GetConnectivityArray32());
+  }
+#else
+  vtkIdTypeArray * legacyCells = cells->GetData();
+  if (nCells == 0 || legacyCells->GetNumberOfValues() % nCells != 0)
+  {
+    return false;
+  }
+  vtkIdType cellDim = legacyCells->GetNumberOfValues() / nCells - 1;
+
+  Eigen::Map<const IdMatrixType> legacyCellsMat(legacyCells->GetPointer(0), nCells, cellDim + 1);
+  if ((legacyCellsMat.col(0).array() != cellDim).any())
+  {
+    return false;
+  }
+  cellsMat = legacyCellsMat.rightCols(cellDim).transpose().cast<unsigned int>();
+#endif
+  return true;
+}
+} // namespace
+
 vtkStandardMeshRepresenter::vtkStandardMeshRepresenter(DatasetConstPointerType reference)
   : vtkStandardMeshRepresenter()
 {
@@ -67,6 +151,49 @@ vtkStandardMeshRepresenter::CloneImpl() const
   return clone;
 }
 
+vtkStandardMeshRepresenter *
+vtkStandardMeshRepresenter::CloneForPoints(const std::vector<unsigned> & pointIds) const
+{
+  // new id of each point of the reference, -1 for the points outside of the region
+  std::vector<vtkIdType> newIds(m_reference->GetNumberOfPoints(), -1);
+
+  auto roi = DatasetPointerType::New();
+  auto points = vtkSmartPointer<vtkPoints>::New();
+  points->SetNumberOfPoints(pointIds.size());
+  roi->GetPointData()->CopyAllocate(m_reference->GetPointData(), pointIds.size());
+  for (std::size_t i = 0; i < pointIds.size(); ++i)
+  {
+    newIds.at(pointIds[i]) = static_cast<vtkIdType>(i);
+    points->SetPoint(i, m_reference->GetPoint(pointIds[i]));
+    roi->GetPointData()->CopyData(m_reference->GetPointData(), pointIds[i], i);
+  }
+  roi->SetPoints(points);
+
+  // the cells that are fully inside of the region
+  vtkIdType nCells = m_reference->GetNumberOfCells();
+  roi->Allocate(nCells);
+  vtkNew<vtkIdList> cellPointIds;
+  for (vtkIdType c = 0; c < nCells; ++c)
+  {
+    m_reference->GetCellPoints(c, cellPointIds);
+    bool isInside = true;
+    for (vtkIdType j = 0; j < cellPointIds->GetNumberOfIds() && isInside; ++j)
+    {
+      auto newId = newIds[cellPointIds->GetId(j)];
+      cellPointIds->SetId(j, newId);
+      isInside = newId >= 0;
+    }
+    if (isInside)
+    {
+      roi->InsertNextCell(m_reference->GetCellType(c), cellPointIds);
+    }
+  }
+
+  auto clone = Create(roi);
+  clone->SetLogger(this->GetLogger());
+  return clone;
+}
+
 void
 vtkStandardMeshRepresenter::Load(const H5::Group & fg)
 {
@@ -91,38 +218,26 @@ vtkStandardMeshRepresenter::LoadRef(const H5::Group & fg) const
   statismo::MatrixType vertexMat;
   HDF5Utils::ReadMatrix(fg, "./points", vertexMat);
 
-  using UIntMatrixType = statismo::GenericEigenTraits<unsigned int>::MatrixType;
   UIntMatrixType cellsMat;
   HDF5Utils::ReadMatrixOfType<unsigned int>(fg, "./cells", cellsMat);
 
   // create the reference from this information
   auto ref = DatasetPointerType::New();
 
+  // the points are stored as a 3 x nVertices matrix, the transpose of the vtk layout
   unsigned nVertices = vertexMat.cols();
-  unsigned nCells = cellsMat.cols();
-
-  auto pcoords = vtkSmartPointer<vtkFloatArray>::New();
+  auto     pcoords = vtkSmartPointer<vtkFloatArray>::New();
   pcoords->SetNumberOfComponents(3);
   pcoords->SetNumberOfTuples(nVertices);
-  for (unsigned i = 0; i < nVertices; i++)
-  {
-    pcoords->SetTuple3(i, vertexMat(0, i), vertexMat(1, i), vertexMat(2, i));
-  }
+  Eigen::Map<statismo::MatrixType>(pcoords->GetPointer(0), nVertices, 3) = vertexMat.transpose();
+
   auto points = vtkSmartPointer<vtkPoints>::New();
   points->SetData(pcoords);
 
   ref->SetPoints(points);
 
-  auto     cell = vtkSmartPointer<vtkCellArray>::New();
+  auto     cell = CreateCellArray(cellsMat);
   unsigned cellDim = cellsMat.rows();
-  for (unsigned i = 0; i < nCells; i++)
-  {
-    cell->InsertNextCell(cellDim);
-    for (unsigned d = 0; d < cellDim; d++)
-    {
-      cell->InsertCellPoint(cellsMat(d, i));
-    }
-  }
   if (cellDim == 2)
   {
     ref->SetLines(cell);
@@ -176,17 +291,16 @@ vtkStandardMeshRepresenter::LoadRef(const H5::Group & fg) const
 vtkStandardMeshRepresenter::DatasetPointerType
 vtkStandardMeshRepresenter::LoadRefLegacy(const H5::Group & fg) const
 {
-  std::string tmpfilename = statismo::utils::CreateTmpName(".vtk");
-
-  HDF5Utils::GetFileFromHDF5(fg, "./reference", tmpfilename.c_str());
+  // the reference is parsed directly from memory, so that no temporary file is needed
+  auto buffer = HDF5Utils::GetBufferFromHDF5(fg, "./reference");
 
   vtkNew<vtkPolyDataReader> reader;
-  reader->SetFileName(tmpfilename.c_str());
+  reader->ReadFromInputStringOn();
+  reader->SetInputString(buffer.data(), static_cast<int>(buffer.size()));
   reader->Update();
-  statismo::utils::RemoveFile(tmpfilename);
   if (reader->GetErrorCode() != 0)
   {
-    throw StatisticalModelException((std::string("Could not read file ") + tmpfilename).c_str(), Status::IO_ERROR);
+    throw StatisticalModelException("Could not read the legacy reference", Status::IO_ERROR);
   }
   return reader->GetOutput();
 }
@@ -196,34 +310,63 @@ vtkStandardMeshRepresenter::Save(const H5::Group & fg) const
 {
   using namespace H5;
 
-  statismo::MatrixType vertexMat = statismo::MatrixType::Zero(3, m_reference->GetNumberOfPoints());
-  for (unsigned i = 0; i < m_reference->GetNumberOfPoints(); i++)
+  // the points are copied in bulk when they are stored as floats or doubles, as usual
+  unsigned             nPoints = m_reference->GetNumberOfPoints();
+  statismo::MatrixType vertexMat(3, nPoints);
+  vtkDataArray *       pointsArray = m_reference->GetPoints() ? m_reference->GetPoints()->GetData() : nullptr;
+  if (auto * floatPoints = vtkArrayDownCast<vtkFloatArray>(pointsArray))
+  {
+    vertexMat = Eigen::Map<const statismo::MatrixType>(floatPoints->GetPointer(0), nPoints, 3).transpose();
+  }
+  else if (auto * doublePoints = vtkArrayDownCast<vtkDoubleArray>(pointsArray))
   {
-    PointType pt = m_reference->GetPoint(i);
-    for (unsigned d = 0; d < 3; d++)
+    vertexMat =
+      Eigen::Map<const MatrixTypeDoublePrecision>(doublePoints->GetPointer(0), nPoints, 3).transpose().cast<float>();
+  }
+  else
+  {
+    for (unsigned i = 0; i < nPoints; i++)
     {
-      vertexMat(d, i) = pt[d];
+      PointType pt = m_reference->GetPoint(i);
+      for (unsigned d = 0; d < 3; d++)
+      {
+        vertexMat(d, i) = pt[d];
+      }
     }
   }
   HDF5Utils::WriteMatrix(fg, "./points", vertexMat);
 
-  // check the dimensionality of a face (i.e. the number of points it has). We assume that
-  // all the cells are the same.
-  unsigned numPointsPerCell{ 0 };
-  if (m_reference->GetNumberOfCells() > 0)
+  // the cells are exported in bulk when they are all polygons or all lines, with the same number of points.
+  // Otherwise, we assume that all the cells have the number of points of the first one.
+  UIntMatrixType facesMat;
+  vtkIdType      nCells = m_reference->GetNumberOfCells();
+  vtkCellArray * cells = nullptr;
+  if (nCells > 0 && m_reference->GetNumberOfPolys() == nCells)
+  {
+    cells = m_reference->GetPolys();
+  }
+  else if (nCells > 0 && m_reference->GetNumberOfLines() == nCells)
   {
-    numPointsPerCell = m_reference->GetCell(0)->GetNumberOfPoints();
+    cells = m_reference->GetLines();
   }
 
-  using UIntMatrixType = statismo::GenericEigenTraits<unsigned int>::MatrixType;
-  UIntMatrixType facesMat = UIntMatrixType::Zero(numPointsPerCell, m_reference->GetNumberOfCells());
-  for (unsigned i = 0; i < m_reference->GetNumberOfCells(); i++)
+  if (!cells || !ExportHomogeneousCells(cells, facesMat))
   {
-    vtkCell * cell = m_reference->GetCell(i);
-    assert(numPointsPerCell == cell->GetNumberOfPoints());
-    for (unsigned d = 0; d < numPointsPerCell; d++)
+    unsigned numPointsPerCell{ 0 };
+    if (nCells > 0)
+    {
+      numPointsPerCell = m_reference->GetCell(0)->GetNumberOfPoints();
+    }
+
+    facesMat = UIntMatrixType::Zero(numPointsPerCell, nCells);
+    for (unsigned i = 0; i < nCells; i++)
     {
-      facesMat(d, i) = cell->GetPointIds()->GetId(d);
+      vtkCell * cell = m_reference->GetCell(i);
+      assert(numPointsPerCell == cell->GetNumberOfPoints());
+      for (unsigned d = 0; d < numPointsPerCell; d++)
+      {
+        facesMat(d, i) = cell->GetPointIds()->GetId(d);
+      }
     }
   }
 
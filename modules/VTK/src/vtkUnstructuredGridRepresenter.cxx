@@ -77,24 +77,14 @@ vtkUnstructuredGridRepresenter::CloneImpl() const
 void
 vtkUnstructuredGridRepresenter::Load(const H5::Group & fg)
 {
-  auto tmpfilename = statismo::utils::CreateTmpName(".vtk");
-  auto uw = statismo::MakeStackUnwinder([=]() { statismo::utils::RemoveFile(tmpfilename); });
-
-  statismo::HDF5Utils::GetFileFromHDF5(fg, "./reference", tmpfilename.c_str());
-
   m_alignment = static_cast<AlignmentType>(statismo::HDF5Utils::ReadInt(fg, "./alignment"));
-  this->SetReference(ReadDataset(tmpfilename));
+  this->SetReference(ReadDatasetFromString(statismo::HDF5Utils::GetBufferFromHDF5(fg, "./reference")));
 }
 
 void
 vtkUnstructuredGridRepresenter::Save(const H5::Group & fg) const
 {
-  std::string tmpfilename = statismo::utils::CreateTmpName(".vtk");
-  auto        uw = statismo::MakeStackUnwinder([=]() { statismo::utils::RemoveFile(tmpfilename); });
-
-  WriteDataset(tmpfilename, this->m_reference);
-
-  statismo::HDF5Utils::DumpFileToHDF5(tmpfilename.c_str(), fg, "./reference");
+  statismo::HDF5Utils::DumpBufferToHDF5(WriteDatasetToString(this->m_reference), fg, "./reference");
   statismo::HDF5Utils::WriteInt(fg, "./alignment", static_cast<int>(m_alignment));
 }
 
@@ -226,6 +216,36 @@ vtkUnstructuredGridRepresenter::WriteDataset(const std::string & filename, Datas
   }
 }
 
+vtkUnstructuredGridRepresenter::DatasetPointerType
+vtkUnstructuredGridRepresenter::ReadDatasetFromString(const std::string & buffer)
+{
+  vtkNew<vtkXMLUnstructuredGridReader> reader;
+  reader->ReadFromInputStringOn();
+  reader->SetInputString(buffer);
+  reader->Update();
+
+  if (reader->GetErrorCode() != 0)
+  {
+    throw statismo::StatisticalModelException("Could not read the reference dataset", Status::IO_ERROR);
+  }
+  return reader->GetOutput();
+}
+
+std::string
+vtkUnstructuredGridRepresenter::WriteDatasetToString(DatasetConstPointerType pd)
+{
+  vtkNew<vtkXMLUnstructuredGridWriter> writer;
+  writer->WriteToOutputStringOn();
+  writer->SetInputData(const_cast<vtkUnstructuredGrid *>(pd));
+  writer->Update();
+
+  if (writer->GetErrorCode() != 0)
+  {
+    throw statismo::StatisticalModelException("Could not write the reference dataset", Status::IO_ERROR);
+  }
+  return writer->GetOutputString();
+}
+
 void
 vtkUnstructuredGridRepresenter::SetReference(DatasetConstPointerType reference)
 {
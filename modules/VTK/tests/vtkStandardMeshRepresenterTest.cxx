@@ -36,13 +36,23 @@
  */
 
 #include "StatismoUnitTest.h"
+#include "statismo/core/DataManager.h"
 #include "statismo/core/Exceptions.h"
 #include "statismo/core/GenericRepresenterValidator.h"
+#include "statismo/core/HDF5Utils.h"
+#include "statismo/core/IO.h"
+#include "statismo/core/PCAModelBuilder.h"
+#include "statismo/core/Utils.h"
 #include "statismo/VTK/vtkStandardMeshRepresenter.h"
 
 #include "vtkTestHelper.h"
 
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+
+#include <cmath>
 #include <string>
+#include <vector>
 
 using namespace statismo::test;
 
@@ -73,6 +83,164 @@ TestRepresenterForMesh()
   return (validator.RunAllTests() ? EXIT_SUCCESS : EXIT_FAILURE);
 }
 
+int
+TestSaveLoadTopology()
+{
+  using RepresenterType = statismo::vtkStandardMeshRepresenter;
+
+  auto reference = LoadPolyData(g_dataDir + "/hand_polydata/hand-0.vtk");
+  auto representer = RepresenterType::SafeCreate(reference);
+
+  auto filename = statismo::utils::CreateTmpName(".rep");
+  {
+    H5::H5File file(filename.c_str(), H5F_ACC_TRUNC);
+    auto       representerGroup = file.createGroup("/representer");
+    representer->Save(representerGroup);
+    statismo::HDF5Utils::WriteStringAttribute(representerGroup, "name", representer->GetName());
+  }
+
+  auto newRepresenter = RepresenterType::SafeCreate();
+  {
+    H5::H5File file(filename.c_str(), H5F_ACC_RDONLY);
+    newRepresenter->Load(file.openGroup("/representer"));
+  }
+  statismo::utils::RemoveFile(filename);
+
+  const auto * newReference = newRepresenter->GetReference();
+  if (newReference->GetNumberOfPoints() != reference->GetNumberOfPoints() ||
+      newReference->GetNumberOfPolys() != reference->GetNumberOfPolys())
+  {
+    return EXIT_FAILURE;
+  }
+
+  for (vtkIdType i = 0; i < reference->GetNumberOfPoints(); ++i)
+  {
+    double pt[3];
+    double newPt[3];
+    reference->GetPoint(i, pt);
+    const_cast<vtkPolyData *>(newReference)->GetPoint(i, newPt);
+    for (unsigned d = 0; d < 3; ++d)
+    {
+      if (std::abs(pt[d] - newPt[d]) > 1e-5)
+      {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  vtkNew<vtkIdList> cellPoints;
+  vtkNew<vtkIdList> newCellPoints;
+  for (vtkIdType i = 0; i < reference->GetNumberOfCells(); ++i)
+  {
+    reference->GetCellPoints(i, cellPoints);
+    const_cast<vtkPolyData *>(newReference)->GetCellPoints(i, newCellPoints);
+    if (cellPoints->GetNumberOfIds() != newCellPoints->GetNumberOfIds())
+    {
+      return EXIT_FAILURE;
+    }
+    for (vtkIdType j = 0; j < cellPoints->GetNumberOfIds(); ++j)
+    {
+      if (cellPoints->GetId(j) != newCellPoints->GetId(j))
+      {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+int
+TestRegionOfInterestLoading()
+{
+  using RepresenterType = statismo::vtkStandardMeshRepresenter;
+  using DataManagerType = statismo::BasicDataManager<vtkPolyData>;
+  using ModelBuilderType = statismo::PCAModelBuilder<vtkPolyData>;
+  using IOType = statismo::IO<vtkPolyData>;
+
+  auto reference = LoadPolyData(g_dataDir + "/hand_polydata/hand-0.vtk");
+  auto representer = RepresenterType::SafeCreate(reference);
+  auto dataManager = DataManagerType::SafeCreate(representer.get());
+  for (unsigned i = 0; i < 4; ++i)
+  {
+    auto datasetFilename = g_dataDir + "/hand_polydata/hand-" + std::to_string(i) + ".vtk";
+    dataManager->AddDataset(LoadPolyData(datasetFilename), datasetFilename);
+  }
+  auto model = ModelBuilderType::SafeCreate()->BuildNewModel(dataManager->GetData(), 0);
+
+  auto filename = statismo::utils::CreateTmpName(".h5");
+  IOType::SaveStatisticalModel(model.get(), filename);
+
+  // the region is the lower half of the bounding box of the reference
+  double bounds[6];
+  reference->GetBounds(bounds);
+  statismo::VectorType lowerCorner(3);
+  statismo::VectorType upperCorner(3);
+  lowerCorner << bounds[0], bounds[2], bounds[4];
+  upperCorner << bounds[1], (bounds[2] + bounds[3]) / 2, bounds[5];
+
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto roiModel = IOType::LoadStatisticalModelInBox(newRepresenter.get(), filename, lowerCorner, upperCorner);
+  statismo::utils::RemoveFile(filename);
+
+  std::vector<vtkIdType> newIds(reference->GetNumberOfPoints(), -1);
+  vtkIdType              numRoiPoints = 0;
+  for (vtkIdType i = 0; i < reference->GetNumberOfPoints(); ++i)
+  {
+    statismo::VectorType pt = representer->PointToVector(statismo::vtkPoint(reference->GetPoint(i)));
+    if ((pt.array() >= lowerCorner.array()).all() && (pt.array() <= upperCorner.array()).all())
+    {
+      newIds[i] = numRoiPoints++;
+    }
+  }
+
+  // the points of the region keep their order, and the mean is the one of the full model
+  const auto * roiReference = roiModel->GetRepresenter()->GetReference();
+  STATISMO_ASSERT_GT(numRoiPoints, 0);
+  STATISMO_ASSERT_LT(numRoiPoints, reference->GetNumberOfPoints());
+  STATISMO_ASSERT_EQ(roiReference->GetNumberOfPoints(), numRoiPoints);
+  for (vtkIdType i = 0; i < reference->GetNumberOfPoints(); ++i)
+  {
+    if (newIds[i] >= 0)
+    {
+      STATISMO_ASSERT_LT(
+        (roiModel->GetMeanVector().segment(3 * newIds[i], 3) - model->GetMeanVector().segment(3 * i, 3)).norm(),
+        1e-4);
+    }
+  }
+
+  // the cells fully inside of the region are kept, with the new point ids
+  vtkIdType         numRoiCells = 0;
+  vtkNew<vtkIdList> cellPoints;
+  vtkNew<vtkIdList> roiCellPoints;
+  for (vtkIdType c = 0; c < reference->GetNumberOfCells(); ++c)
+  {
+    reference->GetCellPoints(c, cellPoints);
+    bool isInside = true;
+    for (vtkIdType j = 0; j < cellPoints->GetNumberOfIds(); ++j)
+    {
+      isInside = isInside && newIds[cellPoints->GetId(j)] >= 0;
+    }
+    if (!isInside)
+    {
+      continue;
+    }
+
+    STATISMO_ASSERT_LT(numRoiCells, roiReference->GetNumberOfCells());
+    const_cast<vtkPolyData *>(roiReference)->GetCellPoints(numRoiCells++, roiCellPoints);
+    STATISMO_ASSERT_EQ(roiCellPoints->GetNumberOfIds(), cellPoints->GetNumberOfIds());
+    for (vtkIdType j = 0; j < cellPoints->GetNumberOfIds(); ++j)
+    {
+      STATISMO_ASSERT_EQ(roiCellPoints->GetId(j), newIds[cellPoints->GetId(j)]);
+    }
+  }
+  STATISMO_ASSERT_GT(numRoiCells, 0);
+  STATISMO_ASSERT_EQ(roiReference->GetNumberOfCells(), numRoiCells);
+
+  return EXIT_SUCCESS;
+}
+
 } // namespace
 
 int
@@ -88,7 +256,9 @@ vtkStandardMeshRepresenterTest(int argc, char * argv[])
 
   auto res = statismo::Translate([]() {
     return statismo::test::RunAllTests("vtkStandardImageRepresenterTest",
-                                       { { "TestRepresenterForMesh", TestRepresenterForMesh } });
+                                       { { "TestRepresenterForMesh", TestRepresenterForMesh },
+                                         { "TestSaveLoadTopology", TestSaveLoadTopology },
+                                         { "TestRegionOfInterestLoading", TestRegionOfInterestLoading } });
   });
 
   return !statismo::CheckResultAndAssert(res, EXIT_SUCCESS);
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "statismo/core/DataManager.h"
+#include "statismo/core/IO.h"
+#include "statismo/core/RandUtils.h"
+#include "statismo/core/StatisticalModel.h"
+#include "statismo/core/ThreadPool.h"
+#include "statismo/core/TrivialVectorialRepresenter.h"
+#include "statismo/core/Utils.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Loading time of files made of many HDF5 groups: a data manager with many datasets, and a file holding several
+ * models, loaded one by one, with IO::LoadStatisticalModels and with IO::LoadStatisticalModels and a thread pool.
+ *
+ * Usage: hdf5LoadingBenchmark [numDatasets] [datasetSize] [numModels] [numPoints] [numComponents] [numRepetitions]
+ */
+
+using namespace statismo;
+
+namespace
+{
+using RepresenterType = TrivialVectorialRepresenter;
+using StatisticalModelType = StatisticalModel<VectorType>;
+
+template <typename F>
+double
+TimeIt(F && f, unsigned numRepetitions)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < numRepetitions; ++i)
+  {
+    f();
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / numRepetitions;
+}
+
+UniquePtrType<StatisticalModelType>
+CreateModel(const RepresenterType * representer, unsigned numPoints, unsigned numComponents)
+{
+  auto & gen = rand::RandGen();
+
+  std::normal_distribution<float> dis;
+  MatrixType basis = MatrixType::NullaryExpr(numPoints, numComponents, [&]() { return dis(gen); });
+  basis.colwise().normalize();
+
+  VectorType mean = VectorType::NullaryExpr(numPoints, [&]() { return dis(gen); });
+  VectorType variance = VectorType::NullaryExpr(numComponents, [](Eigen::Index i) { return 100.0f / (i + 1); });
+  return StatisticalModelType::SafeCreate(representer, mean, basis, variance, 0.1);
+}
+} // namespace
+
+int
+main(int argc, char * argv[])
+{
+  unsigned numDatasets = argc > 1 ? std::stoi(argv[1]) : 5000;
+  unsigned datasetSize = argc > 2 ? std::stoi(argv[2]) : 3000;
+  unsigned numModels = argc > 3 ? std::stoi(argv[3]) : 8;
+  unsigned numPoints = argc > 4 ? std::stoi(argv[4]) : 50000;
+  unsigned numComponents = argc > 5 ? std::stoi(argv[5]) : 100;
+  unsigned numRepetitions = argc > 6 ? std::stoi(argv[6]) : 3;
+
+  rand::RandGen(0);
+  auto & gen = rand::RandGen();
+
+  std::normal_distribution<float> dis;
+  const std::string               kDataFilename{ "hdf5LoadingBenchmarkData.h5" };
+  {
+    auto representer = RepresenterType::SafeCreate(datasetSize);
+    auto dataManager = BasicDataManager<VectorType>::SafeCreate(representer.get());
+    for (unsigned i = 0; i < numDatasets; ++i)
+    {
+      VectorType sample = VectorType::NullaryExpr(datasetSize, [&]() { return dis(gen); });
+      dataManager->AddDataset(sample, "sample" + std::to_string(i));
+    }
+    dataManager->Save(kDataFilename);
+  }
+
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto td = TimeIt([&]() { BasicDataManager<VectorType>::Load(newRepresenter.get(), kDataFilename); }, numRepetitions);
+  std::cout << "data manager\t" << numDatasets << " datasets: " << td << " ms" << std::endl;
+
+  const std::string        kModelsFilename{ "hdf5LoadingBenchmarkModels.h5" };
+  std::vector<std::string> groupNames;
+  {
+    auto       representer = RepresenterType::SafeCreate(numPoints);
+    H5::H5File file(kModelsFilename, H5F_ACC_TRUNC);
+    for (unsigned m = 0; m < numModels; ++m)
+    {
+      groupNames.push_back("/model" + std::to_string(m));
+      IO<VectorType>::SaveStatisticalModel(*CreateModel(representer.get(), numPoints, numComponents),
+                                           file.createGroup(groupNames.back()));
+    }
+  }
+
+  auto ts = TimeIt(
+    [&]() {
+      H5::H5File                                       file(kModelsFilename, H5F_ACC_RDONLY);
+      std::vector<UniquePtrType<StatisticalModelType>> models;
+      for (const auto & groupName : groupNames)
+      {
+        models.push_back(IO<VectorType>::LoadStatisticalModel(newRepresenter.get(), file.openGroup(groupName)));
+      }
+    },
+    numRepetitions);
+  auto tm = TimeIt([&]() { IO<VectorType>::LoadStatisticalModels(newRepresenter.get(), kModelsFilename, groupNames); },
+                   numRepetitions);
+  auto pool = std::make_shared<ThreadPool>(std::thread::hardware_concurrency(), ThreadPool::WaitingMode::BLOCK, 0);
+  auto tp = TimeIt(
+    [&]() {
+      IO<VectorType>::LoadStatisticalModels(
+        newRepresenter.get(), kModelsFilename, groupNames, std::numeric_limits<unsigned>::max(), pool);
+    },
+    numRepetitions);
+  std::cout << "models\t" << numModels << " models: one by one: " << ts << " ms\tLoadStatisticalModels: " << tm
+            << " ms\twith " << pool->GetNumberOfThreads() << " threads: " << tp << " ms" << std::endl;
+
+  utils::RemoveFile(kDataFilename);
+  utils::RemoveFile(kModelsFilename);
+
+  return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "statismo/core/KernelCombinators.h"
+#include "statismo/core/KernelExpressions.h"
+#include "statismo/core/LowRankGPModelBuilder.h"
+#include "statismo/core/RandUtils.h"
+#include "statismo/core/TrivialVectorialRepresenter.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+/*
+ * Compare the runtime kernel combinators with the compile-time kernel expressions,
+ * for raw kernel evaluations and within the LowRankGPModelBuilder.
+ *
+ * Usage: kernelExpressionBenchmark [numPoints] [numRepetitions]
+ */
+
+using namespace statismo;
+
+namespace
+{
+using RepresenterType = TrivialVectorialRepresenter;
+using PointType = RepresenterType::PointType;
+
+class IndexGaussianKernel final : public ScalarValuedKernel<PointType>
+{
+public:
+  explicit IndexGaussianKernel(double sigma)
+    : m_sigma2(sigma * sigma)
+  {}
+
+  double
+  operator()(const PointType & x, const PointType & y) const override
+  {
+    double d = static_cast<double>(x.ptId) - static_cast<double>(y.ptId);
+    return std::exp(-d * d / m_sigma2);
+  }
+
+  std::string
+  GetKernelInfo() const override
+  {
+    return "IndexGaussianKernel";
+  }
+
+private:
+  double m_sigma2;
+};
+
+template <typename F>
+double
+TimeIt(F && f, unsigned numRepetitions)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < numRepetitions; ++i)
+  {
+    f();
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / numRepetitions;
+}
+
+template <unsigned Dim>
+void
+BenchmarkEvaluation(const MatrixValuedKernel<PointType> & combinators,
+                    const MatrixValuedKernel<PointType> & expression,
+                    unsigned                              numPoints,
+                    unsigned                              numRepetitions)
+{
+  MatrixType res(Dim, Dim);
+  auto       evaluateAll = [&](const MatrixValuedKernel<PointType> & kernel) {
+    for (unsigned i = 0; i < numPoints; ++i)
+    {
+      for (unsigned j = 0; j < numPoints; j += 7)
+      {
+        kernel.Evaluate(PointType{ i }, PointType{ j }, res);
+      }
+    }
+  };
+
+  auto tc = TimeIt([&]() { evaluateAll(combinators); }, numRepetitions);
+  auto te = TimeIt([&]() { evaluateAll(expression); }, numRepetitions);
+  std::cout << "evaluation (d = " << Dim << ")\tcombinators: " << tc << " ms\texpressions: " << te
+            << " ms\tspeedup: " << tc / te << std::endl;
+}
+} // namespace
+
+int
+main(int argc, char * argv[])
+{
+  unsigned numPoints = argc > 1 ? std::stoi(argv[1]) : 2000;
+  unsigned numRepetitions = argc > 2 ? std::stoi(argv[2]) : 3;
+
+  rand::RandGen(0);
+
+  IndexGaussianKernel k1{ 10 };
+  IndexGaussianKernel k2{ 50 };
+  IndexGaussianKernel k3{ 200 };
+
+  // sum of three scaled kernels, once with the combinators and once as an expression
+  UncorrelatedMatrixValuedKernel<PointType> m1{ &k1, 3 };
+  UncorrelatedMatrixValuedKernel<PointType> m2{ &k2, 3 };
+  UncorrelatedMatrixValuedKernel<PointType> m3{ &k3, 3 };
+  ScaledKernel<PointType>                   s1{ &m1, 1.0 };
+  ScaledKernel<PointType>                   s2{ &m2, 0.5 };
+  ScaledKernel<PointType>                   s3{ &m3, 0.25 };
+  SumKernel<PointType>                      s12{ &s1, &s2 };
+  SumKernel<PointType>                      combinators3{ &s12, &s3 };
+
+  auto expression3 = MakeMatrixValuedKernel(1.0 * MakeUncorrelatedKernelExpression<3>(k1) +
+                                            0.5 * MakeUncorrelatedKernelExpression<3>(k2) +
+                                            0.25 * MakeUncorrelatedKernelExpression<3>(k3));
+
+  BenchmarkEvaluation<3>(combinators3, *expression3, numPoints, numRepetitions);
+
+  // the same kernel in one dimension, used to build a model
+  UncorrelatedMatrixValuedKernel<PointType> n1{ &k1, 1 };
+  UncorrelatedMatrixValuedKernel<PointType> n2{ &k2, 1 };
+  UncorrelatedMatrixValuedKernel<PointType> n3{ &k3, 1 };
+  ScaledKernel<PointType>                   t1{ &n1, 1.0 };
+  ScaledKernel<PointType>                   t2{ &n2, 0.5 };
+  ScaledKernel<PointType>                   t3{ &n3, 0.25 };
+  SumKernel<PointType>                      t12{ &t1, &t2 };
+  SumKernel<PointType>                      combinators1{ &t12, &t3 };
+
+  auto expression1 = MakeMatrixValuedKernel(1.0 * MakeUncorrelatedKernelExpression<1>(k1) +
+                                            0.5 * MakeUncorrelatedKernelExpression<1>(k2) +
+                                            0.25 * MakeUncorrelatedKernelExpression<1>(k3));
+
+  BenchmarkEvaluation<1>(combinators1, *expression1, numPoints, numRepetitions);
+
+  auto representer = RepresenterType::SafeCreate(numPoints);
+  auto builder = LowRankGPModelBuilder<VectorType>::SafeCreate(representer.get());
+  builder->SetNumberOfThreads(1);
+
+  auto tc = TimeIt([&]() { builder->BuildNewZeroMeanModel(combinators1, 50, 500); }, numRepetitions);
+  auto te = TimeIt([&]() { builder->BuildNewZeroMeanModel(*expression1, 50, 500); }, numRepetitions);
+  std::cout << "LowRankGPModelBuilder\tcombinators: " << tc << " ms\texpressions: " << te
+            << " ms\tspeedup: " << tc / te << std::endl;
+
+  return 0;
+}
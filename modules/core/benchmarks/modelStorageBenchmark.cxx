@@ -0,0 +1,161 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "statismo/core/IO.h"
+#include "statismo/core/RandUtils.h"
+#include "statismo/core/StatisticalModel.h"
+#include "statismo/core/TrivialVectorialRepresenter.h"
+#include "statismo/core/Utils.h"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Compare the file size, the save time, the load time and the time to load the leading components of a model
+ * for several storage options (see HDF5StorageOptions).
+ *
+ * Usage: modelStorageBenchmark [numPoints] [numComponents] [numRepetitions]
+ */
+
+using namespace statismo;
+
+namespace
+{
+using RepresenterType = TrivialVectorialRepresenter;
+using StatisticalModelType = StatisticalModel<VectorType>;
+
+template <typename F>
+double
+TimeIt(F && f, unsigned numRepetitions)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < numRepetitions; ++i)
+  {
+    f();
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / numRepetitions;
+}
+
+std::streamoff
+GetFileSize(const std::string & filename)
+{
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  return file.tellg();
+}
+
+// a model with smooth components, as the ones of shape models, with some noise in the last bits
+UniquePtrType<StatisticalModelType>
+CreateModel(const RepresenterType * representer, unsigned numPoints, unsigned numComponents)
+{
+  auto & gen = rand::RandGen();
+
+  std::normal_distribution<float> dis(0, 1e-4f);
+  MatrixType                      basis(numPoints, numComponents);
+  for (unsigned i = 0; i < numPoints; ++i)
+  {
+    for (unsigned j = 0; j < numComponents; ++j)
+    {
+      basis(i, j) = std::cos(gk_pi * (j + 1) * (i + 0.5) / numPoints) + dis(gen);
+    }
+  }
+  basis.colwise().normalize();
+
+  VectorType mean = VectorType::NullaryExpr(numPoints, [&](Eigen::Index i) { return std::sin(0.01 * i); });
+  VectorType variance = VectorType::NullaryExpr(numComponents, [](Eigen::Index i) { return 100.0f / (i + 1); });
+  return StatisticalModelType::SafeCreate(representer, mean, basis, variance, 0.1);
+}
+} // namespace
+
+int
+main(int argc, char * argv[])
+{
+  unsigned numPoints = argc > 1 ? std::stoi(argv[1]) : 100000;
+  unsigned numComponents = argc > 2 ? std::stoi(argv[2]) : 100;
+  unsigned numRepetitions = argc > 3 ? std::stoi(argv[3]) : 3;
+  unsigned numTruncatedComponents = std::max(1u, numComponents / 10);
+
+  rand::RandGen(0);
+
+  auto representer = RepresenterType::SafeCreate(numPoints);
+  auto model = CreateModel(representer.get(), numPoints, numComponents);
+
+  std::vector<std::pair<std::string, HDF5StorageOptions>> settings;
+  settings.emplace_back("contiguous", HDF5StorageOptions());
+
+  HDF5StorageOptions options;
+  options.chunkColumns = 16;
+  settings.emplace_back("chunked", options);
+  options.compression = HDF5Compression::DEFLATE;
+  settings.emplace_back("deflate", options);
+  options.shuffle = true;
+  settings.emplace_back("shuffle+deflate", options);
+  options.compression = HDF5Compression::LZ4;
+  settings.emplace_back("shuffle+lz4", options);
+  options.compression = HDF5Compression::ZSTD;
+  settings.emplace_back("shuffle+zstd", options);
+
+  const std::string kFilename{ "modelStorageBenchmark.h5" };
+  for (const auto & [name, storageOptions] : settings)
+  {
+    if (!HDF5Utils::IsCompressionAvailable(storageOptions.compression))
+    {
+      std::cout << name << "\tfilter not available" << std::endl;
+      continue;
+    }
+
+    auto ts = TimeIt([&]() { IO<VectorType>::SaveStatisticalModel(model.get(), kFilename, storageOptions); },
+                     numRepetitions);
+    auto size = GetFileSize(kFilename);
+
+    auto newRepresenter = RepresenterType::SafeCreate();
+    auto tl = TimeIt([&]() { IO<VectorType>::LoadStatisticalModel(newRepresenter.get(), kFilename); }, numRepetitions);
+    auto tt = TimeIt(
+      [&]() { IO<VectorType>::LoadStatisticalModel(newRepresenter.get(), kFilename, numTruncatedComponents); },
+      numRepetitions);
+
+    std::cout << name << "\tsize: " << size / (1024.0 * 1024.0) << " MB\tsave: " << ts << " ms\tload: " << tl
+              << " ms\tload " << numTruncatedComponents << " components: " << tt << " ms" << std::endl;
+  }
+  utils::RemoveFile(kFilename);
+
+  return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2015 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "statismo/core/BinaryModelIO.h"
+#include "statismo/core/Utils.h"
+
+#include "lpo.h"
+
+#include <H5Cpp.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace po = lpo;
+using namespace std;
+
+namespace
+{
+
+struct ProgramOptions
+{
+  string strInputFileName;
+  string strOutputFileName;
+  string strFormat;
+};
+
+bool
+IsOptionsConflictPresent(ProgramOptions & opt)
+{
+  statismo::utils::ToLower(opt.strFormat);
+
+  return (!opt.strFormat.empty() && opt.strFormat != "binary" && opt.strFormat != "hdf5") ||
+         opt.strInputFileName.empty() || opt.strOutputFileName.empty() ||
+         opt.strInputFileName == opt.strOutputFileName;
+}
+
+} // namespace
+
+int
+main(int argc, char ** argv)
+{
+  ProgramOptions                   poParameters;
+  po::program_options<std::string> parser{ argv[0], "Program help:" };
+
+  parser
+    .add_opt<std::string>({ "input-file", "i", "The path to the model file.", &poParameters.strInputFileName, "" },
+                          true)
+    .add_opt<std::string>({ "format",
+                            "f",
+                            "Format of the output file: binary or hdf5. By default, HDF5 models are converted to the "
+                            "binary format and binary models to the HDF5 format.",
+                            &poParameters.strFormat,
+                            "" })
+    .add_pos_opt<std::string>(
+      { "Name of the output file where the converted model will be written to.", &poParameters.strOutputFileName });
+
+  if (!parser.parse(argc, argv))
+  {
+    return EXIT_FAILURE;
+  }
+
+  if (IsOptionsConflictPresent(poParameters))
+  {
+    cerr << "A conflict in the options exists or insufficient options were set." << endl;
+    cout << parser << endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!ifstream(poParameters.strInputFileName))
+  {
+    cerr << "Could not open the model file " << poParameters.strInputFileName << endl;
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    bool isHDF5Input = H5::H5File::isHdf5(poParameters.strInputFileName.c_str());
+    if (poParameters.strFormat.empty())
+    {
+      poParameters.strFormat = isHDF5Input ? "binary" : "hdf5";
+    }
+
+    if (poParameters.strFormat == "binary" && isHDF5Input)
+    {
+      statismo::BinaryModelFormat::ConvertFromHDF5(poParameters.strInputFileName, poParameters.strOutputFileName);
+    }
+    else if (poParameters.strFormat == "hdf5" && !isHDF5Input)
+    {
+      statismo::BinaryModelFormat::ConvertToHDF5(poParameters.strInputFileName, poParameters.strOutputFileName);
+    }
+    else
+    {
+      cerr << "The model is already in the " << poParameters.strFormat << " format." << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch (const H5::Exception & e)
+  {
+    cerr << "Could not convert the model:" << endl;
+    cerr << e.getCDetailMsg() << endl;
+    return EXIT_FAILURE;
+  }
+  catch (const statismo::StatisticalModelException & e)
+  {
+    cerr << "Could not convert the model:" << endl;
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,575 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __STATIMO_CORE_BINARY_MODEL_IO_H_
+#define __STATIMO_CORE_BINARY_MODEL_IO_H_
+
+#include "statismo/core/CommonTypes.h"
+#include "statismo/core/Config.h"
+#include "statismo/core/Exceptions.h"
+#include "statismo/core/HDF5Utils.h"
+#include "statismo/core/MappedFile.h"
+#include "statismo/core/ModelInfo.h"
+#include "statismo/core/StatisticalModel.h"
+
+#include <H5Cpp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace statismo
+{
+
+/**
+ * \brief Block of a binary model file, given by its offset from the beginning of the file and its size in bytes
+ */
+struct BinaryModelBlock
+{
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+/**
+ * \brief Header of a binary model file
+ *
+ * The header is followed by the blocks it declares, whose offsets are multiples of BinaryModelFormat::kAlignment:
+ * - mean: the numberOfRows elements of the mean
+ * - pcaVariance: the numberOfComponents PCA variances
+ * - pcaBasis: the numberOfRows x numberOfComponents orthonormal PCA basis, in row major order
+ * - metadata: an HDF5 file image with the representer and modelinfo groups of the HDF5 model format
+ *
+ * The elements are floats of scalarSize bytes, in the byte order of the machine that wrote the file. This byte
+ * order is given by byteOrderMark.
+ */
+struct BinaryModelHeader
+{
+  char             magic[8];
+  std::uint32_t    majorVersion;
+  std::uint32_t    minorVersion;
+  std::uint32_t    byteOrderMark;
+  std::uint32_t    scalarSize;
+  std::uint64_t    numberOfRows;
+  std::uint64_t    numberOfComponents;
+  double           noiseVariance;
+  BinaryModelBlock mean;
+  BinaryModelBlock pcaVariance;
+  BinaryModelBlock pcaBasis;
+  BinaryModelBlock metadata;
+};
+
+static_assert(std::is_trivially_copyable_v<BinaryModelHeader>, "the header is written and mapped as is");
+
+/**
+ * \brief Reading, writing and conversion of binary model files
+ *
+ * The binary model format stores the arrays of a model (see BinaryModelHeader) such that they can be used
+ * directly from a memory mapping of the file, without parsing or conversion. It is a faster alternative to
+ * the HDF5 format, which remains the exchange format: the binary files are only readable on machines with
+ * the same byte order.
+ * \sa BinaryModelIO
+ * \ingroup Core
+ */
+class BinaryModelFormat
+{
+public:
+  static constexpr char          kMagic[8] = { 'S', 'T', 'A', 'T', 'I', 'S', 'M', 'O' };
+  static constexpr std::uint32_t kMajorVersion = 1;
+  static constexpr std::uint32_t kMinorVersion = 0;
+  static constexpr std::uint32_t kByteOrderMark = 0x01020304;
+  static constexpr std::uint64_t kAlignment = 64;
+
+  using BasisRowsFunctionType = std::function<void(unsigned, unsigned, Eigen::Ref<MatrixType>)>;
+  using MetadataFunctionType = std::function<void(const H5::Group &)>;
+
+  /**
+   * \brief Return the header of a mapped binary model file, after checking the header and its blocks
+   */
+  static const BinaryModelHeader &
+  ReadHeader(const MappedFile & file)
+  {
+    if (file.GetSize() < sizeof(BinaryModelHeader) ||
+        std::memcmp(file.GetData(), kMagic, sizeof(kMagic)) != 0)
+    {
+      throw StatisticalModelException("The file is not a binary model file", Status::INVALID_DATA_ERROR);
+    }
+
+    const auto & header = *reinterpret_cast<const BinaryModelHeader *>(file.GetData()); // NOLINT
+    if (header.majorVersion != kMajorVersion)
+    {
+      throw StatisticalModelException("Unsupported version of the binary model format", Status::BAD_VERSION_ERROR);
+    }
+    if (header.byteOrderMark != kByteOrderMark || header.scalarSize != sizeof(ScalarType))
+    {
+      throw StatisticalModelException("The binary model file was written with another byte order or scalar type",
+                                      Status::INVALID_DATA_ERROR);
+    }
+
+    const auto kMaxSize = std::numeric_limits<unsigned>::max();
+    if (header.numberOfRows > kMaxSize || header.numberOfComponents > kMaxSize)
+    {
+      throw StatisticalModelException("Invalid size in the binary model file", Status::INVALID_DATA_ERROR);
+    }
+
+    auto checkBlock = [&file](const BinaryModelBlock & block, std::uint64_t expectedSize) {
+      if (block.offset % kAlignment != 0 || block.offset > file.GetSize() ||
+          block.size > file.GetSize() - block.offset || block.size != expectedSize)
+      {
+        throw StatisticalModelException("Invalid block in the binary model file", Status::INVALID_DATA_ERROR);
+      }
+    };
+    checkBlock(header.mean, header.numberOfRows * sizeof(ScalarType));
+    checkBlock(header.pcaVariance, header.numberOfComponents * sizeof(ScalarType));
+    checkBlock(header.pcaBasis, header.numberOfRows * header.numberOfComponents * sizeof(ScalarType));
+    checkBlock(header.metadata, header.metadata.size);
+
+    return header;
+  }
+
+  /**
+   * \brief Return the elements of a block of a mapped binary model file
+   */
+  static const ScalarType *
+  GetElements(const MappedFile & file, const BinaryModelBlock & block)
+  {
+    return reinterpret_cast<const ScalarType *>(file.GetData() + block.offset); // NOLINT
+  }
+
+  /**
+   * \brief Create an HDF5 file image with the groups written by \a writeMetadata in its root
+   */
+  static std::vector<char>
+  CreateMetadata(const MetadataFunctionType & writeMetadata)
+  {
+    auto file = CreateMetadataFile(H5F_ACC_TRUNC, nullptr, 0);
+    writeMetadata(file.openGroup("/"));
+    file.flush(H5F_SCOPE_GLOBAL);
+
+    auto size = H5Fget_file_image(file.getId(), nullptr, 0);
+    if (size < 0)
+    {
+      throw StatisticalModelException("Could not create the metadata of the binary model", Status::IO_ERROR);
+    }
+    std::vector<char> image(size);
+    H5Fget_file_image(file.getId(), image.data(), image.size());
+    return image;
+  }
+
+  /**
+   * \brief Open the metadata of a mapped binary model file
+   */
+  static H5::H5File
+  OpenMetadata(const MappedFile & file, const BinaryModelHeader & header)
+  {
+    return CreateMetadataFile(H5F_ACC_RDONLY, file.GetData() + header.metadata.offset, header.metadata.size);
+  }
+
+  /**
+   * \brief Write a binary model file
+   * \param filename path to the file
+   * \param mean mean of the model
+   * \param pcaVariance PCA variances of the model
+   * \param noiseVariance noise variance of the model
+   * \param computeBasisRows function that writes the given rows of the orthonormal basis into its last argument
+   * \param metadata metadata created with CreateMetadata
+   */
+  static void
+  WriteModel(const std::string &           filename,
+             const VectorType &            mean,
+             const VectorType &            pcaVariance,
+             double                        noiseVariance,
+             const BasisRowsFunctionType & computeBasisRows,
+             const std::vector<char> &     metadata)
+  {
+    BinaryModelHeader header{};
+    std::copy(std::begin(kMagic), std::end(kMagic), std::begin(header.magic));
+    header.majorVersion = kMajorVersion;
+    header.minorVersion = kMinorVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.scalarSize = sizeof(ScalarType);
+    header.numberOfRows = mean.size();
+    header.numberOfComponents = pcaVariance.size();
+    header.noiseVariance = noiseVariance;
+
+    auto addBlock = [](BinaryModelBlock & block, std::uint64_t offset, std::uint64_t size) {
+      block.offset = (offset + kAlignment - 1) / kAlignment * kAlignment;
+      block.size = size;
+      return block.offset + block.size;
+    };
+    auto end = addBlock(header.mean, sizeof(header), header.numberOfRows * sizeof(ScalarType));
+    end = addBlock(header.pcaVariance, end, header.numberOfComponents * sizeof(ScalarType));
+    end = addBlock(header.pcaBasis, end, header.numberOfRows * header.numberOfComponents * sizeof(ScalarType));
+    addBlock(header.metadata, end, metadata.size());
+
+    std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+      throw StatisticalModelException(("Could not open file " + filename + " for writing").c_str(), Status::IO_ERROR);
+    }
+
+    std::uint64_t position = 0;
+    auto          write = [&](const BinaryModelBlock & block, const void * data) {
+      static const char kPadding[kAlignment] = {};
+      file.write(kPadding, block.offset - position);
+      file.write(static_cast<const char *>(data), block.size);
+      position = block.offset + block.size;
+    };
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header)); // NOLINT
+    position = sizeof(header);
+    write(header.mean, mean.data());
+    write(header.pcaVariance, pcaVariance.data());
+
+    // the basis is computed and written in blocks of rows, which bounds the memory needed to write it
+    write(BinaryModelBlock{ header.pcaBasis.offset, 0 }, nullptr);
+    const auto kNumRows = static_cast<unsigned>(header.numberOfRows);
+    const auto kNumColumns = static_cast<unsigned>(header.numberOfComponents);
+    if (kNumColumns > 0)
+    {
+      const unsigned kMaxBlockBytes = 1U << 24;
+      const auto     kRowBytes = static_cast<unsigned>(kNumColumns * sizeof(ScalarType));
+      auto           numBlockRows = std::max(1U, std::min(kNumRows, kMaxBlockBytes / kRowBytes));
+      MatrixType     rows(numBlockRows, kNumColumns);
+      for (unsigned firstRow = 0; firstRow < kNumRows; firstRow += numBlockRows)
+      {
+        auto numRows = std::min(numBlockRows, kNumRows - firstRow);
+        computeBasisRows(firstRow, numRows, rows.topRows(numRows));
+        file.write(reinterpret_cast<const char *>(rows.data()), numRows * kNumColumns * sizeof(ScalarType)); // NOLINT
+      }
+    }
+    position = header.pcaBasis.offset + header.pcaBasis.size;
+    write(header.metadata, metadata.data());
+
+    if (!file.flush())
+    {
+      throw StatisticalModelException(("Could not write file " + filename).c_str(), Status::IO_ERROR);
+    }
+  }
+
+  /**
+   * \brief Convert a model from the HDF5 format to the binary format
+   */
+  static void
+  ConvertFromHDF5(const std::string & hdf5Filename, const std::string & filename)
+  {
+    auto file = OpenHDF5File(hdf5Filename);
+    try
+    {
+      auto modelRoot = file.openGroup("/");
+      CheckHDF5Version(modelRoot);
+
+      auto       modelGroup = modelRoot.openGroup("./model");
+      VectorType mean;
+      VectorType pcaVariance;
+      MatrixType pcaBasis;
+      HDF5Utils::ReadVector(modelGroup, "./mean", mean);
+      HDF5Utils::ReadVector(modelGroup, "./pcaVariance", pcaVariance);
+      HDF5Utils::ReadMatrix(modelGroup, "./pcaBasis", pcaBasis);
+      auto noiseVariance = HDF5Utils::ReadFloat(modelGroup, "./noiseVariance");
+      if (pcaBasis.rows() != mean.size() || pcaBasis.cols() != pcaVariance.size())
+      {
+        throw StatisticalModelException("The arrays of the model have incompatible sizes",
+                                        Status::INVALID_DATA_ERROR);
+      }
+
+      auto metadata = CreateMetadata([&modelRoot](const H5::Group & metadataRoot) {
+        CopyMetadataGroups(modelRoot, metadataRoot);
+      });
+      WriteModel(
+        filename,
+        mean,
+        pcaVariance,
+        noiseVariance,
+        [&pcaBasis](unsigned firstRow, unsigned numRows, Eigen::Ref<MatrixType> rows) {
+          rows = pcaBasis.middleRows(firstRow, numRows);
+        },
+        metadata);
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("an exception occurred while reading HDF5 file \n") + e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::INVALID_DATA_ERROR);
+    }
+  }
+
+  /**
+   * \brief Convert a model from the binary format to the HDF5 format
+   * \param options chunking and compression of the model datasets (see HDF5StorageOptions)
+   */
+  static void
+  ConvertToHDF5(const std::string &        filename,
+                const std::string &        hdf5Filename,
+                const HDF5StorageOptions & options = HDF5StorageOptions())
+  {
+    MappedFile   file(filename);
+    const auto & header = ReadHeader(file);
+
+    auto hdf5File = CreateHDF5File(hdf5Filename);
+
+    try
+    {
+      auto modelRoot = hdf5File.openGroup("/");
+      auto versionGroup = modelRoot.createGroup("version");
+      HDF5Utils::WriteInt(versionGroup, "majorVersion", gk_currenFileVersionMajor);
+      HDF5Utils::WriteInt(versionGroup, "minorVersion", gk_currentFileVersionMinor);
+
+      auto metadata = OpenMetadata(file, header);
+      CopyMetadataGroups(metadata.openGroup("/"), modelRoot);
+
+      Eigen::Map<const VectorType> mean(GetElements(file, header.mean), header.numberOfRows);
+      Eigen::Map<const VectorType> pcaVariance(GetElements(file, header.pcaVariance), header.numberOfComponents);
+      Eigen::Map<const MatrixType> pcaBasis(
+        GetElements(file, header.pcaBasis), header.numberOfRows, header.numberOfComponents);
+
+      auto modelGroup = modelRoot.createGroup("./model");
+      HDF5Utils::WriteMatrixInRowBlocks(
+        modelGroup,
+        "./pcaBasis",
+        header.numberOfRows,
+        header.numberOfComponents,
+        [&pcaBasis](unsigned firstRow, unsigned numRows, Eigen::Ref<MatrixType> rows) {
+          rows = pcaBasis.middleRows(firstRow, numRows);
+        },
+        options);
+      HDF5Utils::WriteVector(modelGroup, "./pcaVariance", VectorType(pcaVariance), options);
+      HDF5Utils::WriteVector(modelGroup, "./mean", VectorType(mean), options);
+      HDF5Utils::WriteFloat(modelGroup, "./noiseVariance", header.noiseVariance);
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("an exception occurred while writing HDF5 file \n") + e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
+    }
+  }
+
+private:
+  // create an in-memory HDF5 file, initialized with the given image if it is set
+  static H5::H5File
+  CreateMetadataFile(unsigned flags, const char * image, std::size_t imageSize)
+  {
+    // in-memory files are identified by their name
+    static std::atomic<unsigned> fileCount{ 0 };
+    auto                         name = "statismo-binary-model-metadata-" + std::to_string(fileCount++);
+
+    const std::size_t   kIncrement = 1U << 16;
+    H5::FileAccPropList accessProperties;
+    H5Pset_fapl_core(accessProperties.getId(), kIncrement, false);
+    if (image)
+    {
+      H5Pset_file_image(accessProperties.getId(), const_cast<char *>(image), imageSize); // NOLINT
+    }
+    return H5::H5File(name.c_str(), flags, H5::FileCreatPropList::DEFAULT, accessProperties);
+  }
+
+  static H5::H5File
+  OpenHDF5File(const std::string & filename)
+  {
+    try
+    {
+      return H5::H5File(filename.c_str(), H5F_ACC_RDONLY);
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("could not open HDF5 file \n") + e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
+    }
+  }
+
+  static H5::H5File
+  CreateHDF5File(const std::string & filename)
+  {
+    try
+    {
+      return H5::H5File(filename.c_str(), H5F_ACC_TRUNC);
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("Could not open HDF5 file for writing \n") + e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
+    }
+  }
+
+  static void
+  CheckHDF5Version(const H5::Group & modelRoot)
+  {
+    // the model info of 0.9 files differs only in the layout of the builder info, which the reader detects
+    if (!HDF5Utils::ExistsObjectWithName(modelRoot, "version"))
+    {
+      throw StatisticalModelException("Only versioned HDF5 model files can be converted", Status::BAD_VERSION_ERROR);
+    }
+
+    auto majorVersion = HDF5Utils::ReadInt(modelRoot, "./version/majorVersion");
+    auto minorVersion = HDF5Utils::ReadInt(modelRoot, "./version/minorVersion");
+    if (!(majorVersion == gk_previousFileVersionMajor && minorVersion == gk_previousFileVersionMinor) &&
+        !(majorVersion == gk_currenFileVersionMajor && minorVersion == gk_currentFileVersionMinor))
+    {
+      throw StatisticalModelException("Only the two latest versions of the HDF5 model format can be converted",
+                                      Status::BAD_VERSION_ERROR);
+    }
+  }
+
+  // copy the representer and the model info, which are stored in the same way in both formats
+  static void
+  CopyMetadataGroups(const H5::Group & source, const H5::Group & destination)
+  {
+    for (const auto * name : { "representer", "modelinfo" })
+    {
+      if (HDF5Utils::ExistsObjectWithName(source, name) &&
+          H5Ocopy(source.getId(), name, destination.getId(), name, H5P_DEFAULT, H5P_DEFAULT) < 0)
+      {
+        throw StatisticalModelException("Could not copy the metadata of the model", Status::IO_ERROR);
+      }
+    }
+  }
+};
+
+/**
+ * \brief Load/Save a StatisticalModel in the binary model format
+ *
+ * The file is mapped in memory and the model is created directly from the mapped arrays, whose only copy is
+ * the one into the model. Only the small metadata (representer and model info) are read with HDF5.
+ * \sa BinaryModelFormat, IO
+ * \ingroup Core
+ */
+template <typename T>
+class BinaryModelIO
+{
+private:
+  BinaryModelIO() = default;
+
+public:
+  using StatisticalModelType = StatisticalModel<T>;
+  using RepresenterType = typename StatisticalModelType::RepresenterType;
+
+  /**
+   * \brief Load statistical model from a binary model file
+   * \param representer representer bound to the model
+   * \param filename path to the binary model file
+   * \param maxNumberOfPCAComponents maximal number of pca components loaded to create the model
+   */
+  static UniquePtrType<StatisticalModelType>
+  LoadStatisticalModel(RepresenterType *   representer,
+                       const std::string & filename,
+                       unsigned            maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max())
+  {
+    MappedFile   file(filename);
+    const auto & header = BinaryModelFormat::ReadHeader(file);
+
+    ModelInfo modelInfo;
+    try
+    {
+      auto metadata = BinaryModelFormat::OpenMetadata(file, header);
+      auto metadataRoot = metadata.openGroup("/");
+      representer->Load(metadataRoot.openGroup("./representer"));
+      if (HDF5Utils::ExistsObjectWithName(metadataRoot, "modelinfo"))
+      {
+        modelInfo.Load(metadataRoot);
+      }
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("an exception occurred while reading the metadata of the binary model \n") +
+                      e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::INVALID_DATA_ERROR);
+    }
+
+    auto numComponents =
+      static_cast<unsigned>(std::min<std::uint64_t>(header.numberOfComponents, maxNumberOfPCAComponents));
+    Eigen::Map<const VectorType> mean(BinaryModelFormat::GetElements(file, header.mean), header.numberOfRows);
+    Eigen::Map<const VectorType> pcaVariance(BinaryModelFormat::GetElements(file, header.pcaVariance),
+                                             numComponents);
+    Eigen::Map<const MatrixType> pcaBasis(
+      BinaryModelFormat::GetElements(file, header.pcaBasis), header.numberOfRows, header.numberOfComponents);
+
+    // the basis is passed by reference to the model, which reads it from the mapping
+    auto model = StatisticalModelType::SafeCreate(
+      representer, VectorType(mean), pcaBasis.leftCols(numComponents), VectorType(pcaVariance), header.noiseVariance);
+    model->SetModelInfo(modelInfo);
+    return model;
+  }
+
+  /**
+   * \brief Save statistical model to a binary model file
+   * \param model model to save
+   * \param filename path to the binary model file
+   */
+  static void
+  SaveStatisticalModel(const StatisticalModelType & model, const std::string & filename)
+  {
+    std::vector<char> metadata;
+    try
+    {
+      metadata = BinaryModelFormat::CreateMetadata([&model](const H5::Group & metadataRoot) {
+        const auto * representer = model.GetRepresenter();
+        auto         representerGroup = metadataRoot.createGroup("./representer");
+        HDF5Utils::WriteStringAttribute(representerGroup, "name", representer->GetName());
+        HDF5Utils::WriteStringAttribute(representerGroup, "version", representer->GetVersion());
+        HDF5Utils::WriteStringAttribute(
+          representerGroup, "datasetType", RepresenterType::TypeToString(representer->GetType()));
+        representer->Save(representerGroup);
+
+        model.GetModelInfo().Save(metadataRoot);
+      });
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("an exception occurred while writing the metadata of the binary model \n") +
+                      e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
+    }
+
+    BinaryModelFormat::WriteModel(
+      filename,
+      model.GetMeanVector(),
+      model.GetPCAVarianceVector(),
+      model.GetNoiseVariance(),
+      [&model](unsigned firstRow, unsigned numRows, Eigen::Ref<MatrixType> rows) {
+        model.ComputeOrthonormalPCABasisRows(firstRow, numRows, rows);
+      },
+      metadata);
+  }
+};
+
+} // namespace statismo
+
+#endif
@@ -0,0 +1,372 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __STATIMO_CORE_BUILD_CHECKPOINT_H_
+#define __STATIMO_CORE_BUILD_CHECKPOINT_H_
+
+#include "statismo/core/CommonTypes.h"
+#include "statismo/core/Exceptions.h"
+#include "statismo/core/GenericFactory.h"
+#include "statismo/core/Hash.h"
+#include "statismo/core/HDF5Utils.h"
+#include "statismo/core/NonCopyable.h"
+
+#include <H5Cpp.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace statismo
+{
+
+/**
+ * \brief Scratch file that holds the intermediate state of a model build
+ *
+ * Builders to which a checkpoint is given (e.g. LowRankGPModelBuilder::SetCheckpoint) periodically
+ * store their partial results in it. If the build is interrupted, running the same build again with
+ * the same checkpoint file resumes from the stored state and produces the same model as an
+ * uninterrupted build.
+ *
+ * A build is identified by a key computed by the builder from its inputs. The content of the file is
+ * discarded when it belongs to another build or cannot be read (e.g. when the process was killed
+ * while writing).
+ *
+ * \warning The checkpoint is not thread-safe. The builders only access it from the thread calling
+ * the build method.
+ * \ingroup Core
+ */
+class BuildCheckpoint
+  : public GenericFactory<BuildCheckpoint>
+  , public NonCopyable
+{
+public:
+  using ObjectFactoryType = GenericFactory<BuildCheckpoint>;
+  using ClockType = std::chrono::steady_clock;
+
+  friend ObjectFactoryType;
+
+  /**
+   * \brief Start a build
+   * \param buildKey key identifying the build
+   * \return true if the file holds the state of the same build, which can be resumed
+   */
+  bool
+  Begin(const std::string & buildKey)
+  {
+    if (m_file.getId() >= 0 && ReadBuildKey() == buildKey)
+    {
+      m_lastFlush = ClockType::now();
+      return true;
+    }
+
+    Translate([&]() {
+      // the file cannot be truncated while it is open, and is reopened in place once it is empty
+      m_file.close();
+      H5::H5File(m_filename.c_str(), H5F_ACC_TRUNC).close();
+      m_file.openFile(m_filename.c_str(), H5F_ACC_RDWR);
+      HDF5Utils::WriteStringAttribute(m_file.openGroup("/"), sk_buildKeyName, buildKey);
+    });
+    Flush();
+    return false;
+  }
+
+  /**
+   * \brief Check whether an entry was stored
+   */
+  bool
+  Exists(const std::string & name) const
+  {
+    return Translate([&]() { return HDF5Utils::ExistsObjectWithName(m_file, name); });
+  }
+
+  /**
+   * \brief Store a matrix, replacing the entry \a name if it exists
+   */
+  template <typename Scalar>
+  void
+  WriteMatrix(const std::string & name, const typename GenericEigenTraits<Scalar>::MatrixType & matrix)
+  {
+    Translate([&]() {
+      auto ds = OpenDataSet<Scalar>(name, { static_cast<hsize_t>(matrix.rows()), static_cast<hsize_t>(matrix.cols()) });
+      ds.write(matrix.data(), details::HDF5PredTypeTraits<Scalar>::GetPredRef());
+    });
+  }
+
+  /**
+   * \brief Read a matrix stored with WriteMatrix
+   */
+  template <typename Scalar>
+  void
+  ReadMatrix(const std::string & name, typename GenericEigenTraits<Scalar>::MatrixType & matrix) const
+  {
+    Translate([&]() { HDF5Utils::ReadMatrixOfType<Scalar>(m_file, name.c_str(), matrix); });
+  }
+
+  /**
+   * \brief Store a vector, replacing the entry \a name if it exists
+   */
+  template <typename Scalar>
+  void
+  WriteVector(const std::string & name, const typename GenericEigenTraits<Scalar>::VectorType & vector)
+  {
+    Translate([&]() {
+      auto ds = OpenDataSet<Scalar>(name, { static_cast<hsize_t>(vector.rows()) });
+      ds.write(vector.data(), details::HDF5PredTypeTraits<Scalar>::GetPredRef());
+    });
+  }
+
+  /**
+   * \brief Read a vector stored with WriteVector
+   */
+  template <typename Scalar>
+  void
+  ReadVector(const std::string & name, typename GenericEigenTraits<Scalar>::VectorType & vector) const
+  {
+    Translate([&]() { HDF5Utils::ReadVectorOfType<Scalar>(m_file, name.c_str(), vector); });
+  }
+
+  /**
+   * \brief Store a list of indices, replacing the entry \a name if it exists
+   */
+  void
+  WriteIndices(const std::string & name, const std::vector<unsigned> & indices)
+  {
+    Translate([&]() {
+      auto ds = OpenDataSet<unsigned>(name, { static_cast<hsize_t>(indices.size()) });
+      if (!indices.empty())
+      {
+        ds.write(indices.data(), details::HDF5PredTypeTraits<unsigned>::GetPredRef());
+      }
+    });
+  }
+
+  /**
+   * \brief Read a list of indices stored with WriteIndices
+   */
+  void
+  ReadIndices(const std::string & name, std::vector<unsigned> & indices) const
+  {
+    Translate([&]() {
+      auto    ds = m_file.openDataSet(name.c_str());
+      hsize_t dims[1];
+      ds.getSpace().getSimpleExtentDims(dims, nullptr);
+      indices.resize(dims[0]);
+      if (!indices.empty())
+      {
+        ds.read(indices.data(), details::HDF5PredTypeTraits<unsigned>::GetPredRef());
+      }
+    });
+  }
+
+  /**
+   * \brief Store the rows \a firstRow to \a firstRow + rows.rows() of a matrix with \a numRows rows
+   *
+   * The entry is created at the first call, the rows that were not written are undefined.
+   */
+  void
+  WriteRows(const std::string & name, Eigen::Index numRows, Eigen::Index firstRow, const MatrixType & rows)
+  {
+    Translate([&]() {
+      auto ds = OpenDataSet<ScalarType>(name, { static_cast<hsize_t>(numRows), static_cast<hsize_t>(rows.cols()) });
+      hsize_t       offset[2] = { static_cast<hsize_t>(firstRow), 0 };
+      hsize_t       count[2] = { static_cast<hsize_t>(rows.rows()), static_cast<hsize_t>(rows.cols()) };
+      H5::DataSpace fileSpace = ds.getSpace();
+      fileSpace.selectHyperslab(H5S_SELECT_SET, count, offset);
+      H5::DataSpace memSpace(2, count);
+      ds.write(rows.data(), details::HDF5PredTypeTraits<ScalarType>::GetPredRef(), memSpace, fileSpace);
+    });
+  }
+
+  /**
+   * \brief Read the rows \a firstRow to \a firstRow + rows.rows() stored with WriteRows into \a rows
+   */
+  void
+  ReadRows(const std::string & name, Eigen::Index firstRow, Eigen::Ref<MatrixType> rows) const
+  {
+    Translate([&]() {
+      auto          ds = m_file.openDataSet(name.c_str());
+      hsize_t       offset[2] = { static_cast<hsize_t>(firstRow), 0 };
+      hsize_t       count[2] = { static_cast<hsize_t>(rows.rows()), static_cast<hsize_t>(rows.cols()) };
+      H5::DataSpace fileSpace = ds.getSpace();
+      fileSpace.selectHyperslab(H5S_SELECT_SET, count, offset);
+      H5::DataSpace memSpace(2, count);
+      MatrixType    buffer(rows.rows(), rows.cols());
+      ds.read(buffer.data(), details::HDF5PredTypeTraits<ScalarType>::GetPredRef(), memSpace, fileSpace);
+      rows = buffer;
+    });
+  }
+
+  /**
+   * \brief Write the stored entries to disk
+   */
+  void
+  Flush()
+  {
+    Translate([&]() { m_file.flush(H5F_SCOPE_GLOBAL); });
+    m_lastFlush = ClockType::now();
+  }
+
+  /**
+   * \brief Check whether the state should be stored again, i.e. whether the interval has
+   * elapsed since the last flush
+   */
+  bool
+  IsDue() const
+  {
+    return ClockType::now() - m_lastFlush >= m_interval;
+  }
+
+  const std::string &
+  GetFilename() const
+  {
+    return m_filename;
+  }
+
+  /**
+   * \brief Compute a key from the raw content of a matrix, to identify the data of a build
+   *
+   * The matrix is hashed column by column. A column is only copied when the expression has no
+   * contiguous storage for it, so the data matrix of a build is never duplicated.
+   */
+  template <typename Derived>
+  static std::size_t
+  HashMatrix(const Eigen::DenseBase<Derived> & matrix)
+  {
+    using ScalarType = typename Derived::Scalar;
+    using ColumnRefType = Eigen::Ref<const Eigen::Matrix<ScalarType, Eigen::Dynamic, 1>>;
+
+    std::size_t seed = 0;
+    for (Eigen::Index j = 0; j < matrix.cols(); ++j)
+    {
+      ColumnRefType col = matrix.col(j);
+      details::HashCombine(seed,
+                           std::hash<std::string_view>{}(std::string_view{
+                             reinterpret_cast<const char *>(col.data()), col.size() * sizeof(ScalarType) }));
+    }
+    return seed;
+  }
+
+private:
+  /**
+   * \param filename path of the scratch file
+   * \param interval minimal time between two writes of the state
+   */
+  explicit BuildCheckpoint(std::string filename, std::chrono::milliseconds interval = std::chrono::seconds(60))
+    : m_filename(std::move(filename))
+    , m_file(OpenFile(m_filename))
+    , m_interval(interval)
+    , m_lastFlush(ClockType::now())
+  {}
+
+  // an unreadable file is replaced at the beginning of the build
+  static H5::H5File
+  OpenFile(const std::string & filename)
+  {
+    try
+    {
+      return HDF5Utils::OpenOrCreateFile(filename);
+    }
+    catch (const H5::Exception &)
+    {
+      return H5::H5File{};
+    }
+  }
+
+  std::string
+  ReadBuildKey() const
+  {
+    try
+    {
+      auto root = m_file.openGroup("/");
+      return root.attrExists(sk_buildKeyName) ? HDF5Utils::ReadStringAttribute(root, sk_buildKeyName) : "";
+    }
+    catch (const H5::Exception &)
+    {
+      return "";
+    }
+  }
+
+  template <typename Scalar>
+  H5::DataSet
+  OpenDataSet(const std::string & name, const std::vector<hsize_t> & dims)
+  {
+    if (HDF5Utils::ExistsObjectWithName(m_file, name))
+    {
+      auto                 ds = m_file.openDataSet(name.c_str());
+      auto                 space = ds.getSpace();
+      std::vector<hsize_t> storedDims(space.getSimpleExtentNdims());
+      space.getSimpleExtentDims(storedDims.data(), nullptr);
+      if (storedDims == dims)
+      {
+        return ds;
+      }
+      m_file.unlink(name.c_str());
+    }
+
+    return m_file.createDataSet(name.c_str(),
+                                details::HDF5PredTypeTraits<Scalar>::GetPredRef(),
+                                H5::DataSpace(static_cast<int>(dims.size()), dims.data()));
+  }
+
+  template <typename F>
+  static std::invoke_result_t<F>
+  Translate(F && f)
+  {
+    try
+    {
+      return f();
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("checkpoint error \n") + e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
+    }
+  }
+
+  static constexpr const char * sk_buildKeyName = "buildKey";
+
+  std::string               m_filename;
+  H5::H5File                m_file;
+  std::chrono::milliseconds m_interval;
+  ClockType::time_point     m_lastFlush;
+};
+
+} // namespace statismo
+
+#endif
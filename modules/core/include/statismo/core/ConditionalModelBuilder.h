@@ -40,7 +40,10 @@
 
 #include "statismo/core/CommonTypes.h"
 #include "statismo/core/DataManagerWithSurrogates.h"
+#include "statismo/core/GenericFactory.h"
 #include "statismo/core/ModelBuilder.h"
+#include "statismo/core/ModelInfo.h"
+#include "statismo/core/NonCopyable.h"
 #include "statismo/core/StatisticalModel.h"
 
 #include <vector>
@@ -49,6 +52,108 @@
 namespace statismo
 {
 
+/**
+ * \brief Conditional models of a PCA model for varying values of the continuous surrogates
+ *
+ * The engine is created by ConditionalModelBuilder::BuildConditionalModelEngine for a set of samples and
+ * conditioning variables. It factors the joint covariance of the PCA scores b and the continuous surrogates x once.
+ * As the conditional covariance of b given x does not depend on the value of x, the basis of the conditional models
+ * is also computed once.
+ *
+ * For each new value of the surrogates, only the conditional mean
+ * \f$\mu_b + \Sigma_{bx} \Sigma_{xx}^{-1} (x - \mu_x)\f$ has to be computed, and the conditional model is derived
+ * from the PCA model (see StatisticalModel::IsDerived). Both operations cost O(k^2) for a model with k components.
+ *
+ * \sa ConditionalModelBuilder
+ * \ingroup Core
+ */
+template <typename T>
+class ConditionalModelEngine
+  : public GenericFactory<ConditionalModelEngine<T>>
+  , public NonCopyable
+{
+public:
+  using ObjectFactoryType = GenericFactory<ConditionalModelEngine<T>>;
+  using StatisticalModelType = StatisticalModel<T>;
+  using CondVariableValuePair = std::pair<bool, statismo::ScalarType>;
+  using CondVariableValueVectorType = std::vector<CondVariableValuePair>;
+
+  friend ObjectFactoryType;
+
+  /**
+   * \brief Destroy the object.
+   */
+  void
+  Delete()
+  {
+    delete this;
+  }
+
+  /**
+   * \brief Return the number of continuous surrogates used for conditioning
+   */
+  unsigned
+  GetNumberOfConditioningVariables() const
+  {
+    return m_meanConditions.size();
+  }
+
+  /**
+   * \brief Return the PCA model of the selected samples, from which the conditional models are derived
+   */
+  const StatisticalModelType *
+  GetPCAModel() const
+  {
+    return m_pcaModel.get();
+  }
+
+  /**
+   * \brief Compute the conditional mean of the PCA coefficients
+   * \param conditions values of the continuous surrogates used for conditioning, in the order of the surrogates
+   */
+  VectorType
+  ComputeConditionalMean(const VectorType & conditions) const;
+
+  /**
+   * \brief Return the conditional covariance of the PCA coefficients, which does not depend on the conditions
+   */
+  const MatrixTypeDoublePrecision &
+  GetConditionalCovariance() const
+  {
+    return m_conditionalCovariance;
+  }
+
+  /**
+   * \brief Build the conditional model for the given values of the continuous surrogates
+   * \param conditions values of the continuous surrogates used for conditioning, in the order of the surrogates
+   */
+  UniquePtrType<StatisticalModelType>
+  BuildModel(const VectorType & conditions) const;
+
+private:
+  ConditionalModelEngine(UniquePtrType<StatisticalModelType> pcaModel,
+                         const MatrixType &                  surrogates,
+                         CondVariableValueVectorType         conditioningInfo,
+                         std::vector<unsigned>               continuousIndices,
+                         float                               noiseVariance,
+                         double                              modelVarianceRetained,
+                         BuilderInfo::DataInfoList           dataInfo);
+
+  UniquePtrType<StatisticalModelType> m_pcaModel;
+  CondVariableValueVectorType         m_conditioningInfo;
+  std::vector<unsigned>               m_continuousIndices;
+  float                               m_noiseVariance;
+  BuilderInfo::DataInfoList           m_dataInfo;
+  VectorTypeDoublePrecision           m_meanScores;
+  VectorTypeDoublePrecision           m_meanConditions;
+  // regression matrix Sbx Sxx^-1
+  MatrixTypeDoublePrecision m_regression;
+  MatrixTypeDoublePrecision m_conditionalCovariance;
+  // the conditional basis is U m_basisTransform, where U is the orthonormal basis of the PCA model
+  MatrixType m_basisTransform;
+  VectorType m_pcaVariance;
+};
+
 /**
  * \brief Creates a statistical model conditioned on some external data
  *
@@ -62,6 +167,8 @@ namespace statismo
  * Categorical surrogates (e.g. gender) are taken into account by selecting the subset of samples that fit in the
  * requested categories.
  *
+ * To build conditional models for many values of the continuous surrogates, use BuildConditionalModelEngine.
+ *
  * \warning Conditioning on too many categories may lead to small or empty training sets
  * \warning Using more surrogate variables than training samples may cause instabilities
  *
@@ -106,6 +213,20 @@ public:
                 float                               noiseVariance,
                 double                              modelVarianceRetained = 1.0f) const;
 
+  /**
+   * \brief Prepare the conditioning of the model on the continuous surrogates
+   *
+   * The parameters are the same as for BuildNewModel. The values of the categorical surrogates select the samples,
+   * while the values of the continuous surrogates are ignored: they are given for each model built by the engine.
+   * \return engine that builds the conditional models for given values of the continuous surrogates
+   */
+  UniquePtrType<ConditionalModelEngine<T>>
+  BuildConditionalModelEngine(const DataItemListType &            sampleSet,
+                              const SurrogateTypeInfoType &       surrogateTypesInfo,
+                              const CondVariableValueVectorType & conditioningInfo,
+                              float                               noiseVariance,
+                              double                              modelVarianceRetained = 1.0f) const;
+
 private:
   std::size_t
   PrepareData(const DataItemListType &            DataItemList,
@@ -113,7 +234,22 @@ private:
               const CondVariableValueVectorType & conditioningInfo,
               DataItemListType &                  acceptedSamples,
               MatrixType &                        surrogateMatrix,
-              VectorType &                        conditions) const;
+              VectorType &                        conditions,
+              std::vector<unsigned> &             continuousIndices) const;
+
+  // selects the samples and builds their PCA model
+  UniquePtrType<StatisticalModelType>
+  BuildPCAModel(const DataItemListType &               sampleSet,
+                const SurrogateTypeInfoType &          surrogateTypesInfo,
+                const CondVariableValueVectorType &    conditioningInfo,
+                float                                  noiseVariance,
+                const details::BuildProgressReporter & progress,
+                MatrixType &                           surrogateMatrix,
+                VectorType &                           conditions,
+                std::vector<unsigned> &                continuousIndices) const;
+
+  BuilderInfo::DataInfoList
+  GetDataInfo(const DataItemListType & sampleSet, const SurrogateTypeInfoType & surrogateTypesInfo) const;
 
   CondVariableValueVectorType m_conditioningInfo;
 };
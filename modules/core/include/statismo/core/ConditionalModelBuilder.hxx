@@ -43,8 +43,11 @@
 #include "statismo/core/PCAModelBuilder.h"
 #include "statismo/core/Logger.h"
 
+#include <Eigen/Cholesky>
 #include <Eigen/SVD>
 
+#include <sstream>
+
 
 namespace statismo
 {
@@ -56,14 +59,16 @@ ConditionalModelBuilder<T>::PrepareData(const DataItemListType &            samp
                                         const CondVariableValueVectorType & conditioningInfo,
                                         DataItemListType &                  acceptedSamples,
                                         MatrixType &                        surrogateMatrix,
-                                        VectorType &                        conditions) const
+                                        VectorType &                        conditions,
+                                        std::vector<unsigned> &             continuousIndices) const
 {
   STATISMO_LOG_INFO("Preparing data");
   assert(conditioningInfo.size() == surrogateTypesInfo.types.size());
 
   // 1- identify the continuous and categorical variables, which are used for conditioning and which are not
-  std::vector<unsigned> indicesContinuousSurrogatesInUse;
-  std::vector<unsigned> indicesCategoricalSurrogatesInUse;
+  std::vector<unsigned> & indicesContinuousSurrogatesInUse = continuousIndices;
+  std::vector<unsigned>   indicesCategoricalSurrogatesInUse;
+  indicesContinuousSurrogatesInUse.clear();
   for (unsigned i = 0; i < conditioningInfo.size(); i++)
   {
     if (conditioningInfo[i].first)
@@ -127,152 +132,257 @@ ConditionalModelBuilder<T>::PrepareData(const DataItemListType &            samp
 
 template <typename T>
 UniquePtrType<typename ConditionalModelBuilder<T>::StatisticalModelType>
-ConditionalModelBuilder<T>::BuildNewModel(const DataItemListType &            sampleDataList,
-                                          const SurrogateTypeInfoType &       surrogateTypesInfo,
-                                          const CondVariableValueVectorType & conditioningInfo,
-                                          float                               noiseVariance,
-                                          double                              modelVarianceRetained) const
+ConditionalModelBuilder<T>::BuildPCAModel(const DataItemListType &               sampleDataList,
+                                          const SurrogateTypeInfoType &          surrogateTypesInfo,
+                                          const CondVariableValueVectorType &    conditioningInfo,
+                                          float                                  noiseVariance,
+                                          const details::BuildProgressReporter & progress,
+                                          MatrixType &                           X,
+                                          VectorType &                           x0,
+                                          std::vector<unsigned> &                continuousIndices) const
 {
-  STATISMO_LOG_INFO("Building new model");
-
   if (conditioningInfo.size() != surrogateTypesInfo.types.size())
   {
     throw StatisticalModelException("mismatch between conditioning info size and surrogates info size",
                                     Status::BAD_INPUT_ERROR);
   }
 
+  progress.Report("Sample selection", 0, 1);
+
   DataItemListType acceptedSamples;
-  MatrixType       X;
-  VectorType       x0;
-  auto             nSamples = PrepareData(sampleDataList, surrogateTypesInfo, conditioningInfo, acceptedSamples, X, x0);
+  auto             nSamples =
+    PrepareData(sampleDataList, surrogateTypesInfo, conditioningInfo, acceptedSamples, X, x0, continuousIndices);
   assert(nSamples == acceptedSamples.size());
-
-  unsigned nCondVariables = X.rows();
+  progress.Report("Sample selection", 1, 1);
 
   // build a normal PCA model
   using PCAModelBuilderType = PCAModelBuilder<T>;
   auto modelBuilder = PCAModelBuilderType::SafeCreate();
   modelBuilder->SetLogger(this->GetLogger());
+  modelBuilder->SetProgressCallback(this->GetProgressCallback());
+
+  return modelBuilder->BuildNewModel(acceptedSamples, noiseVariance);
+}
 
-  auto pcaModel = modelBuilder->BuildNewModel(acceptedSamples, noiseVariance);
+template <typename T>
+BuilderInfo::DataInfoList
+ConditionalModelBuilder<T>::GetDataInfo(const DataItemListType &      sampleDataList,
+                                        const SurrogateTypeInfoType & surrogateTypesInfo) const
+{
+  BuilderInfo::DataInfoList di;
+  for (const auto & item : sampleDataList)
+  {
+    const auto * sampleData = dynamic_cast<const DataItemWithSurrogatesType *>(item.get());
+
+    std::ostringstream os;
+    os << "URI_" << (di.size() / 2);
+    di.emplace_back(os.str().c_str(), sampleData->GetDatasetURI());
+
+    os << "_surrogates";
+    di.emplace_back(os.str().c_str(), sampleData->GetSurrogateFilename());
+  }
+
+  di.emplace_back("surrogates_types", surrogateTypesInfo.typeFilename);
+  return di;
+}
+
+template <typename T>
+UniquePtrType<typename ConditionalModelBuilder<T>::StatisticalModelType>
+ConditionalModelBuilder<T>::BuildNewModel(const DataItemListType &            sampleDataList,
+                                          const SurrogateTypeInfoType &       surrogateTypesInfo,
+                                          const CondVariableValueVectorType & conditioningInfo,
+                                          float                               noiseVariance,
+                                          double                              modelVarianceRetained) const
+{
+  STATISMO_LOG_INFO("Building new model");
 
-  unsigned nPCAComponents = pcaModel->GetNumberOfPrincipalComponents();
+  auto                  progress = this->CreateProgressReporter();
+  MatrixType            X;
+  VectorType            x0;
+  std::vector<unsigned> continuousIndices;
+  auto                  pcaModel = BuildPCAModel(
+    sampleDataList, surrogateTypesInfo, conditioningInfo, noiseVariance, progress, X, x0, continuousIndices);
 
   if (X.cols() == 0 || X.rows() == 0)
   {
     return pcaModel;
   }
-  else
-  {
-    // the scores in the pca model correspond to the parameters of each sample in the model.
-    MatrixType B = pcaModel->GetModelInfo().GetScoresMatrix().transpose();
-
-    assert(static_cast<std::size_t>(B.rows()) == nSamples);
-    assert(B.cols() == nPCAComponents);
-
-    // A is the joint data matrix B, X, where X contains the conditional information for each sample
-    // Thus the i-th row of A contains the PCA parameters b of the i-th sample,
-    // together with the conditional information for each sample
-    MatrixType A(nSamples, nPCAComponents + nCondVariables);
-    A << B, X.transpose();
-
-    // Compute the mean and the covariance of the joint data matrix
-    auto mu = A.colwise().mean().transpose(); // colwise returns a row vector
-    assert(mu.rows() == nPCAComponents + nCondVariables);
-
-    auto A0 = A.rowwise() - mu.transpose();
-    auto cov = 1.0 / (nSamples - 1) * A0.transpose() * A0;
-
-    assert(cov.rows() == cov.cols());
-    assert(cov.rows() == (nPCAComponents + nCondVariables));
-
-    // extract the submatrices involving the conditionals x
-    // note that since the matrix is symmetric, Sbx = Sxb.transpose(), hence we only store one
-    auto Sbx = cov.topRightCorner(nPCAComponents, nCondVariables);
-    auto Sxx = cov.bottomRightCorner(nCondVariables, nCondVariables);
-    auto Sbb = cov.topLeftCorner(nPCAComponents, nPCAComponents);
-
-    // compute the conditional mean
-    auto condMean = mu.topRows(nPCAComponents) + Sbx * Sxx.inverse() * (x0 - mu.bottomRows(nCondVariables));
-
-    // compute the conditional covariance
-    MatrixType condCov = Sbb - Sbx * Sxx.inverse() * Sbx.transpose();
-
-    // get the sample mean corresponding the conditional given mean of the parameter vectors
-    auto condMeanSample = pcaModel->GetRepresenter()->SampleToSampleVector(pcaModel->DrawSample(condMean));
-
-    // so far all the computation have been done in parameter (latent) space. Go back to sample space.
-    // (see PartiallyFixedModelBuilder for a detailed documentation)
-    // TODO: we should factor this out into the base class, as it is the same code as it is used in
-    // the partially fixed model builder
-    const VectorType &        pcaVariance = pcaModel->GetPCAVarianceVector();
-    VectorTypeDoublePrecision pcaSdev = pcaVariance.cast<double>().array().sqrt();
-
-    using SVDType = Eigen::JacobiSVD<MatrixTypeDoublePrecision>;
-    auto    innerMatrix = pcaSdev.asDiagonal() * condCov.cast<double>() * pcaSdev.asDiagonal();
-    SVDType svd(innerMatrix, Eigen::ComputeThinU);
-    auto    singularValues = svd.singularValues().cast<ScalarType>();
-
-    // keep only the necessary number of modes, wrt modelVarianceRetained...
-    double totalRemainingVariance = singularValues.sum(); //
-
-    // and count the number of modes required for the model
-    double   cumulatedVariance = singularValues(0);
-    unsigned numComponentsToReachPrescribedVariance{ 1 };
-    while ((cumulatedVariance / totalRemainingVariance) < modelVarianceRetained)
-    {
-      numComponentsToReachPrescribedVariance++;
-      if (numComponentsToReachPrescribedVariance == singularValues.size())
-      {
-        break;
-      }
-      cumulatedVariance += singularValues(numComponentsToReachPrescribedVariance - 1);
-    }
 
-    unsigned numComponentsToKeep = std::min<unsigned>(numComponentsToReachPrescribedVariance, singularValues.size());
+  progress.Report("Conditioning", 0, 1);
+  auto engine = ConditionalModelEngine<T>::SafeCreate(std::move(pcaModel),
+                                                      X,
+                                                      conditioningInfo,
+                                                      continuousIndices,
+                                                      noiseVariance,
+                                                      modelVarianceRetained,
+                                                      GetDataInfo(sampleDataList, surrogateTypesInfo));
+  auto model = engine->BuildModel(x0);
+  progress.Report("Conditioning", 1, 1);
+
+  return model;
+}
 
-    auto newPCAVariance = singularValues.topRows(numComponentsToKeep);
-    auto newPCABasisMatrix =
-      (pcaModel->GetOrthonormalPCABasisMatrix() * svd.matrixU().cast<ScalarType>()).leftCols(numComponentsToKeep);
+template <typename T>
+UniquePtrType<ConditionalModelEngine<T>>
+ConditionalModelBuilder<T>::BuildConditionalModelEngine(const DataItemListType &            sampleDataList,
+                                                        const SurrogateTypeInfoType &       surrogateTypesInfo,
+                                                        const CondVariableValueVectorType & conditioningInfo,
+                                                        float                               noiseVariance,
+                                                        double modelVarianceRetained) const
+{
+  STATISMO_LOG_INFO("Building conditional model engine");
+
+  auto                  progress = this->CreateProgressReporter();
+  MatrixType            X;
+  VectorType            x0;
+  std::vector<unsigned> continuousIndices;
+  auto                  pcaModel = BuildPCAModel(
+    sampleDataList, surrogateTypesInfo, conditioningInfo, noiseVariance, progress, X, x0, continuousIndices);
+
+  progress.Report("Conditioning", 0, 1);
+  auto engine = ConditionalModelEngine<T>::SafeCreate(std::move(pcaModel),
+                                                      X,
+                                                      conditioningInfo,
+                                                      continuousIndices,
+                                                      noiseVariance,
+                                                      modelVarianceRetained,
+                                                      GetDataInfo(sampleDataList, surrogateTypesInfo));
+  progress.Report("Conditioning", 1, 1);
+
+  return engine;
+}
 
-    auto model = StatisticalModelType::SafeCreate(
-      pcaModel->GetRepresenter(), condMeanSample, newPCABasisMatrix, newPCAVariance, noiseVariance);
+//
+// ConditionalModelEngine
+//
 
-    // add builder info and data info to the info list
-    MatrixType                     scores(0, 0);
-    BuilderInfo::ParameterInfoList bi;
-    bi.emplace_back("NoiseVariance ", std::to_string(noiseVariance));
+template <typename T>
+ConditionalModelEngine<T>::ConditionalModelEngine(UniquePtrType<StatisticalModelType> pcaModel,
+                                                  const MatrixType &                  X,
+                                                  CondVariableValueVectorType         conditioningInfo,
+                                                  std::vector<unsigned>               continuousIndices,
+                                                  float                               noiseVariance,
+                                                  double                              modelVarianceRetained,
+                                                  BuilderInfo::DataInfoList           dataInfo)
+  : m_pcaModel{ std::move(pcaModel) }
+  , m_conditioningInfo{ std::move(conditioningInfo) }
+  , m_continuousIndices{ std::move(continuousIndices) }
+  , m_noiseVariance{ noiseVariance }
+  , m_dataInfo{ std::move(dataInfo) }
+{
+  unsigned nPCAComponents = m_pcaModel->GetNumberOfPrincipalComponents();
+  unsigned nCondVariables = X.rows();
+
+  // the scores in the pca model correspond to the parameters of each sample in the model.
+  MatrixTypeDoublePrecision B = m_pcaModel->GetModelInfo().GetScoresMatrix().transpose().template cast<double>();
+  auto                      nSamples = B.rows();
+  assert(B.cols() == nPCAComponents);
+  assert(X.cols() == nSamples);
 
-    // generate a matrix ; first column = boolean (yes/no, this variable is used) ; second: conditioning value.
-    MatrixType conditioningInfoMatrix(conditioningInfo.size(), 2);
-    for (unsigned i = 0; i < conditioningInfo.size(); i++)
+  if (nSamples < 2)
+  {
+    throw StatisticalModelException("At least two samples are needed to condition a model", Status::BAD_INPUT_ERROR);
+  }
+
+  // A is the joint data matrix B, X, where X contains the conditional information for each sample
+  // Thus the i-th row of A contains the PCA parameters b of the i-th sample,
+  // together with the conditional information for each sample
+  MatrixTypeDoublePrecision A(nSamples, nPCAComponents + nCondVariables);
+  A << B, X.transpose().cast<double>();
+
+  // Compute the mean and the covariance of the joint data matrix
+  VectorTypeDoublePrecision mu = A.colwise().mean().transpose(); // colwise returns a row vector
+  A.rowwise() -= mu.transpose();
+  MatrixTypeDoublePrecision cov = (A.transpose() * A) / (nSamples - 1);
+
+  m_meanScores = mu.topRows(nPCAComponents);
+  m_meanConditions = mu.bottomRows(nCondVariables);
+
+  // extract the submatrices involving the conditionals x
+  // note that since the matrix is symmetric, Sbx = Sxb.transpose(), hence we only store one
+  MatrixTypeDoublePrecision Sbx = cov.topRightCorner(nPCAComponents, nCondVariables);
+  MatrixTypeDoublePrecision Sxx = cov.bottomRightCorner(nCondVariables, nCondVariables);
+  MatrixTypeDoublePrecision Sbb = cov.topLeftCorner(nPCAComponents, nPCAComponents);
+
+  // Sxx is factored once: the conditional mean is mu_b + Sbx Sxx^-1 (x0 - mu_x) and the conditional covariance
+  // Sbb - Sbx Sxx^-1 Sbx^T does not depend on x0
+  m_regression = Sxx.ldlt().solve(Sbx.transpose()).transpose();
+  m_conditionalCovariance = Sbb - m_regression * Sbx.transpose();
+
+  // so far all the computation have been done in parameter (latent) space. Go back to sample space.
+  // (see PartiallyFixedModelBuilder for a detailed documentation)
+  VectorTypeDoublePrecision pcaSdev = m_pcaModel->GetPCAVarianceVector().template cast<double>().array().sqrt();
+
+  using SVDType = Eigen::JacobiSVD<MatrixTypeDoublePrecision>;
+  MatrixTypeDoublePrecision innerMatrix = pcaSdev.asDiagonal() * m_conditionalCovariance * pcaSdev.asDiagonal();
+  SVDType                   svd(innerMatrix, Eigen::ComputeThinU);
+  VectorType                singularValues = svd.singularValues().cast<ScalarType>();
+
+  // keep only the necessary number of modes, wrt modelVarianceRetained...
+  double totalRemainingVariance = singularValues.sum(); //
+
+  // and count the number of modes required for the model
+  double   cumulatedVariance = singularValues(0);
+  unsigned numComponentsToReachPrescribedVariance{ 1 };
+  while ((cumulatedVariance / totalRemainingVariance) < modelVarianceRetained)
+  {
+    numComponentsToReachPrescribedVariance++;
+    if (numComponentsToReachPrescribedVariance == singularValues.size())
     {
-      conditioningInfoMatrix(i, 0) = conditioningInfo[i].first;
-      conditioningInfoMatrix(i, 1) = conditioningInfo[i].second;
+      break;
     }
-    bi.emplace_back("ConditioningInfo ", std::to_string(conditioningInfoMatrix));
+    cumulatedVariance += singularValues(numComponentsToReachPrescribedVariance - 1);
+  }
 
-    typename BuilderInfo::DataInfoList di;
-    for (const auto & item : sampleDataList)
-    {
-      const auto * sampleData = dynamic_cast<const DataItemWithSurrogatesType *>(item.get());
+  unsigned numComponentsToKeep = std::min<unsigned>(numComponentsToReachPrescribedVariance, singularValues.size());
 
-      std::ostringstream os;
-      os << "URI_" << (di.size() / 2);
-      di.emplace_back(os.str().c_str(), sampleData->GetDatasetURI());
+  m_pcaVariance = singularValues.topRows(numComponentsToKeep);
+  m_basisTransform = svd.matrixU().leftCols(numComponentsToKeep).cast<ScalarType>();
+}
 
-      os << "_surrogates";
-      di.emplace_back(os.str().c_str(), sampleData->GetSurrogateFilename());
-    }
+template <typename T>
+VectorType
+ConditionalModelEngine<T>::ComputeConditionalMean(const VectorType & conditions) const
+{
+  if (conditions.size() != m_meanConditions.size())
+  {
+    throw StatisticalModelException("Wrong number of conditioning values", Status::BAD_INPUT_ERROR);
+  }
+  return (m_meanScores + m_regression * (conditions.cast<double>() - m_meanConditions)).cast<ScalarType>();
+}
 
-    di.emplace_back("surrogates_types", surrogateTypesInfo.typeFilename);
+template <typename T>
+UniquePtrType<typename ConditionalModelEngine<T>::StatisticalModelType>
+ConditionalModelEngine<T>::BuildModel(const VectorType & conditions) const
+{
+  // the conditional model shares the basis of the PCA model: its mean is the sample corresponding to the
+  // conditional mean of the parameter vectors, and its orthonormal basis U svd.matrixU()
+  auto model = StatisticalModelType::SafeCreate(
+    m_pcaModel.get(), ComputeConditionalMean(conditions), m_basisTransform, m_pcaVariance, m_noiseVariance);
+
+  // add builder info and data info to the info list
+  MatrixType                     scores(0, 0);
+  BuilderInfo::ParameterInfoList bi;
+  bi.emplace_back("NoiseVariance ", std::to_string(m_noiseVariance));
+
+  // generate a matrix ; first column = boolean (yes/no, this variable is used) ; second: conditioning value.
+  MatrixType conditioningInfoMatrix(m_conditioningInfo.size(), 2);
+  for (unsigned i = 0; i < m_conditioningInfo.size(); i++)
+  {
+    conditioningInfoMatrix(i, 0) = m_conditioningInfo[i].first;
+    conditioningInfoMatrix(i, 1) = m_conditioningInfo[i].second;
+  }
+  for (unsigned i = 0; i < m_continuousIndices.size(); i++)
+  {
+    conditioningInfoMatrix(m_continuousIndices[i], 1) = conditions(i);
+  }
+  bi.emplace_back("ConditioningInfo ", std::to_string(conditioningInfoMatrix));
 
-    ModelInfo::BuilderInfoList biList;
-    biList.emplace_back("ConditionalModelBuilder", di, bi);
-    model->SetModelInfo(ModelInfo{ scores, biList });
+  ModelInfo::BuilderInfoList biList;
+  biList.emplace_back("ConditionalModelBuilder", m_dataInfo, bi);
+  model->SetModelInfo(ModelInfo{ scores, biList });
 
-    return model;
-  }
+  return model;
 }
 
 } // namespace statismo
@@ -44,8 +44,11 @@
 
 static constexpr unsigned gk_oldFileVersionMajor = 0;
 static constexpr unsigned gk_oldFileVersionMinor = 8;
+// files of version 0.9 store the builder info lists as one group of strings per list
+static constexpr unsigned gk_previousFileVersionMajor = 0;
+static constexpr unsigned gk_previousFileVersionMinor = 9;
 static constexpr unsigned gk_currenFileVersionMajor = 0;
-static constexpr unsigned gk_currentFileVersionMinor = 9;
+static constexpr unsigned gk_currentFileVersionMinor = 10;
 
 // gccxml (as used by e.g. wrapitk) does not compile with vectorization enabled.
 #if defined(__GCCXML__)
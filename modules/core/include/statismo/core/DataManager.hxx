@@ -65,6 +65,8 @@ DataManagerBase<T, Derived>::Load(RepresenterType * representer, const std::stri
 {
   using namespace H5;
 
+  // the data managers can be loaded while models are loaded in the background (see IO::LoadStatisticalModelAsync)
+  auto   lock = HDF5Utils::LockLibrary();
   H5File file;
   try
   {
@@ -40,6 +40,7 @@
 #define __STATISMO_EXCEPTIONS_
 
 #include <exception>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <optional>
@@ -67,7 +68,8 @@ enum class Status
   INVALID_H5DATA_ERROR,
   NOT_IMPLEMENTED_ERROR,
   INTERNAL_ERROR,
-  UNKNOWN_ERROR
+  UNKNOWN_ERROR,
+  CANCELLED
 };
 
 class IException : public virtual std::exception
@@ -40,6 +40,11 @@
 
 #include "statismo/core/CommonTypes.h"
 
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
 namespace H5
 {
 class H5Location;
@@ -52,6 +57,44 @@ class DataSet;
 namespace statismo
 {
 
+/**
+ * \brief Compression filters for the datasets written by HDF5Utils
+ *
+ * LZ4 and ZSTD are not part of HDF5, they require the corresponding filter plugins (see HDF5_PLUGIN_PATH)
+ * when the file is written and when it is read.
+ */
+enum class HDF5Compression
+{
+  NONE,
+  DEFLATE,
+  LZ4,
+  ZSTD
+};
+
+/**
+ * \brief Storage layout and filters of the datasets written by HDF5Utils
+ *
+ * By default, the datasets are stored contiguously and without filters. Compressed datasets are always chunked.
+ * Matrices are chunked in blocks of columns, such that reading the leading columns of a matrix (e.g. when a model
+ * is loaded with fewer components) only reads and decompresses the leading chunks.
+ */
+struct HDF5StorageOptions
+{
+  // number of rows and columns of a chunk, 0 selects a default value when the dataset is chunked
+  unsigned        chunkRows{ 0 };
+  unsigned        chunkColumns{ 0 };
+  bool            shuffle{ false };
+  HDF5Compression compression{ HDF5Compression::NONE };
+  // compression level, or 0 for the default level of the filter
+  int compressionLevel{ 0 };
+
+  bool
+  IsChunked() const
+  {
+    return chunkRows > 0 || chunkColumns > 0 || shuffle || compression != HDF5Compression::NONE;
+  }
+};
+
 /**
  * \brief Wrapper class that gathers HDF5 utilities
  * \ingroup Core
@@ -95,6 +138,23 @@ public:
   static void
   ReadMatrix(const H5::H5Location & fg, const char * name, unsigned maxNumColumns, MatrixType & matrix);
 
+  /**
+   * \brief Read the given rows of a matrix, with the given number of columns
+   *
+   * Only the selected rows are read from the file (the selection is a union of hyperslabs).
+   * \param fg hdf5 group
+   * \param name name of the entry
+   * \param rows indices of the rows to be read, without duplicates. Row i of the output is the row rows[i]
+   * \param maxNumColumns number of columns to be read
+   * \param matrix output matrix
+   */
+  static void
+  ReadMatrixRows(const H5::H5Location &        fg,
+                 const char *                  name,
+                 const std::vector<unsigned> & rows,
+                 unsigned                      maxNumColumns,
+                 MatrixType &                  matrix);
+
   /**
    * \brief Read a Matrix of a given type from a HDF5 File
    * \param fg hdf5 group
@@ -110,22 +170,50 @@ public:
    * \param fg hdf5 group
    * \param name name of the entry
    * \param matrix to be written
+   * \param options storage layout and filters of the dataset
    */
   static H5::DataSet
-  WriteMatrix(const H5::H5Location & fg, const char * name, const MatrixType & matrix);
+  WriteMatrix(const H5::H5Location &     fg,
+              const char *               name,
+              const MatrixType &         matrix,
+              const HDF5StorageOptions & options = HDF5StorageOptions());
 
   /**
    * \brief Write a Matrix of the given type to the HDF5 File
    * \param fg hdf5 group
    * \param name name of the entry
    * \param matrix to be written
+   * \param options storage layout and filters of the dataset
    */
   template <class T>
   static H5::DataSet
   WriteMatrixOfType(const H5::H5Location &                             fg,
                     const char *                                       name,
-                    const typename GenericEigenTraits<T>::MatrixType & matrix);
+                    const typename GenericEigenTraits<T>::MatrixType & matrix,
+                    const HDF5StorageOptions &                         options = HDF5StorageOptions());
+
 
+  /**
+   * \brief Write a matrix that is computed in blocks of rows to the HDF5 File
+   *
+   * The matrix is never held in memory: \a computeRows(firstRow, numRows, block) computes the given rows of the
+   * matrix into block, a staging buffer that is written to the file before the next rows are computed. The memory
+   * used is bounded by the size of the buffer, which is aligned with the chunks of the dataset.
+   * \param fg hdf5 group
+   * \param name name of the entry
+   * \param numRows, numColumns size of the matrix
+   * \param computeRows function that computes the rows of the matrix
+   * \param options storage layout and filters of the dataset
+   * \param maxNumBlockRows number of rows of the buffer (rounded to whole chunks), or 0 for a buffer of a few MB
+   */
+  static H5::DataSet
+  WriteMatrixInRowBlocks(const H5::H5Location &                                                 fg,
+                         const char *                                                           name,
+                         unsigned                                                               numRows,
+                         unsigned                                                               numColumns,
+                         const std::function<void(unsigned, unsigned, Eigen::Ref<MatrixType>)> & computeRows,
+                         const HDF5StorageOptions & options = HDF5StorageOptions(),
+                         unsigned                   maxNumBlockRows = 0);
 
   /**
    * \brief Read a Vector from a HDF5 File with the given number of elements
@@ -146,6 +234,20 @@ public:
   static void
   ReadVector(const H5::H5Location & fg, const char * name, VectorType & vector);
 
+  /**
+   * \brief Read the given elements of a vector
+   * \param fg hdf5 group
+   * \param name name of the entry
+   * \param indices indices of the elements to be read, without duplicates
+   * \param vector output vector
+   * \sa ReadMatrixRows
+   */
+  static void
+  ReadVectorElements(const H5::H5Location &        fg,
+                     const char *                  name,
+                     const std::vector<unsigned> & indices,
+                     VectorType &                  vector);
+
   template <class T>
   static void
   ReadVectorOfType(const H5::H5Location & fg, const char * name, typename GenericEigenTraits<T>::VectorType & vector);
@@ -155,15 +257,36 @@ public:
    * \param fg hdf5 group
    * \param name name of the entry
    * \param vector to be written
+   * \param options storage layout and filters of the dataset
    */
   static H5::DataSet
-  WriteVector(const H5::H5Location & fg, const char * name, const VectorType & vector);
+  WriteVector(const H5::H5Location &     fg,
+              const char *               name,
+              const VectorType &         vector,
+              const HDF5StorageOptions & options = HDF5StorageOptions());
 
   template <class T>
   static H5::DataSet
   WriteVectorOfType(const H5::H5Location &                             fg,
                     const char *                                       name,
-                    const typename GenericEigenTraits<T>::VectorType & vector);
+                    const typename GenericEigenTraits<T>::VectorType & vector,
+                    const HDF5StorageOptions &                         options = HDF5StorageOptions());
+
+  /**
+   * \brief Return true if the filter used for \a compression is available in this HDF5 library
+   */
+  static bool
+  IsCompressionAvailable(HDF5Compression compression);
+
+  /**
+   * \brief Lock the HDF5 library for the calling thread if the library is not thread-safe
+   *
+   * A thread-safe HDF5 library serializes its calls itself and the returned lock does not own any mutex.
+   * Otherwise, threads that use the library concurrently must hold this lock during all their HDF5 calls,
+   * including the destruction of the HDF5 objects.
+   */
+  static std::unique_lock<std::mutex>
+  LockLibrary();
 
 
   /**
@@ -184,6 +307,24 @@ public:
   static void
   GetFileFromHDF5(const H5::H5Location & fg, const char * name, const char * filename);
 
+  /**
+   * \brief Save a byte buffer (e.g. the content of a serialized file) as a byte array in the hdf5 file.
+   * \param buffer bytes to be stored
+   * \param fg hdf5 group
+   * \param name name of the entry
+   */
+  static void
+  DumpBufferToHDF5(const std::string & buffer, const H5::H5Location & fg, const char * name);
+
+  /**
+   * \brief Read an entry from an HDF5 byte array into memory
+   * \param fg hdf5 group
+   * \param name name of the entry
+   * \return the bytes of the entry
+   */
+  static std::string
+  GetBufferFromHDF5(const H5::H5Location & fg, const char * name);
+
   /**
    * \brief Write a string to the hdf5 file
    * \param fg hdf5 group
@@ -201,6 +342,23 @@ public:
   static std::string
   ReadString(const H5::H5Location & fg, const char * name);
 
+  /**
+   * \brief Write a list of strings as a one dimensional array of variable length strings
+   * \param fg hdf5 group
+   * \param name name of the entry in the group
+   * \param strings strings to be written
+   */
+  static H5::DataSet
+  WriteStringList(const H5::H5Location & fg, const char * name, const std::vector<std::string> & strings);
+
+  /**
+   * \brief Read a list of strings written by WriteStringList
+   * \param fg hdf5 group
+   * \param name name of the entry in the group
+   */
+  static std::vector<std::string>
+  ReadStringList(const H5::H5Location & fg, const char * name);
+
   /**
    * \brief Write a string attribute for the given group
    * \param fg hdf5 group
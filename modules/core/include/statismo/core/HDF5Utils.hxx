@@ -47,6 +47,8 @@
 #include <algorithm>
 #include <fstream>
 #include <iterator>
+#include <numeric>
+#include <sstream>
 #include <vector>
 
 namespace statismo
@@ -95,6 +97,171 @@ struct HDF5PredTypeTraits<int>
     return H5::PredType::NATIVE_INT;
   }
 };
+
+inline H5Z_filter_t
+GetCompressionFilter(HDF5Compression compression)
+{
+  // ids of the LZ4 and Zstandard filters registered with the HDF Group
+  constexpr H5Z_filter_t kLZ4Filter = 32004;
+  constexpr H5Z_filter_t kZstdFilter = 32015;
+
+  switch (compression)
+  {
+    case HDF5Compression::DEFLATE:
+      return H5Z_FILTER_DEFLATE;
+    case HDF5Compression::LZ4:
+      return kLZ4Filter;
+    case HDF5Compression::ZSTD:
+      return kZstdFilter;
+    default:
+      return H5Z_FILTER_NONE;
+  }
+}
+
+inline H5::DSetCreatPropList
+CreateDataSetProperties(const HDF5StorageOptions & options, int rank, const hsize_t * dims, std::size_t elementSize)
+{
+  // about 1MB per chunk, which is the default size of the chunk cache of HDF5
+  constexpr hsize_t kDefaultChunkBytes = 1 << 20;
+  constexpr hsize_t kDefaultChunkColumns = 16;
+
+  H5::DSetCreatPropList properties;
+  if (!options.IsChunked() || std::any_of(dims, dims + rank, [](hsize_t d) { return d == 0; }))
+  {
+    return properties;
+  }
+
+  if (!HDF5Utils::IsCompressionAvailable(options.compression))
+  {
+    throw StatisticalModelException("The HDF5 filter of the requested compression is not available",
+                                    Status::NOT_IMPLEMENTED_ERROR);
+  }
+
+  hsize_t chunk[2];
+  if (rank == 1)
+  {
+    chunk[0] = options.chunkRows > 0 ? options.chunkRows : kDefaultChunkBytes / elementSize;
+  }
+  else
+  {
+    chunk[1] = std::min(options.chunkColumns > 0 ? options.chunkColumns : kDefaultChunkColumns, dims[1]);
+    chunk[0] = options.chunkRows > 0 ? options.chunkRows : kDefaultChunkBytes / (elementSize * chunk[1]);
+    if (options.chunkRows == 0 && chunk[0] > 0 && chunk[0] < dims[0])
+    {
+      // balance the rows of the chunks, as the last chunk is allocated completely
+      auto numChunkRows = (dims[0] + chunk[0] - 1) / chunk[0];
+      chunk[0] = (dims[0] + numChunkRows - 1) / numChunkRows;
+    }
+  }
+  for (int i = 0; i < rank; ++i)
+  {
+    chunk[i] = std::max<hsize_t>(1, std::min(chunk[i], dims[i]));
+  }
+  properties.setChunk(rank, chunk);
+
+  if (options.shuffle)
+  {
+    properties.setShuffle();
+  }
+
+  switch (options.compression)
+  {
+    case HDF5Compression::NONE:
+      break;
+    case HDF5Compression::DEFLATE:
+      properties.setDeflate(options.compressionLevel > 0 ? options.compressionLevel : 6);
+      break;
+    case HDF5Compression::LZ4:
+      // the parameter of the LZ4 filter is the block size, and not a level
+      properties.setFilter(GetCompressionFilter(options.compression), H5Z_FLAG_MANDATORY);
+      break;
+    default:
+    {
+      unsigned level = options.compressionLevel;
+      properties.setFilter(
+        GetCompressionFilter(options.compression), H5Z_FLAG_MANDATORY, options.compressionLevel > 0 ? 1 : 0, &level);
+    }
+  }
+  return properties;
+}
+
+// Read the given rows, in increasing order, of a dataset of rank 1 or 2 into the row major buffer. The rows are
+// selected as a union of hyperslabs of consecutive rows. As the cost of adding a hyperslab to a selection grows
+// with the number of hyperslabs in the selection, the rows are read in batches of a bounded number of hyperslabs.
+template <typename T>
+void
+ReadSortedRows(const H5::DataSet & ds, const std::vector<unsigned> & sortedRows, hsize_t numColumns, T * buffer)
+{
+  constexpr unsigned kMaxHyperslabsPerRead = 64;
+
+  H5::DataSpace fileSpace = ds.getSpace();
+  for (std::size_t batchBegin = 0; batchBegin < sortedRows.size();)
+  {
+    fileSpace.selectNone();
+    auto i = batchBegin;
+    for (unsigned numHyperslabs = 0; i < sortedRows.size() && numHyperslabs < kMaxHyperslabsPerRead; ++numHyperslabs)
+    {
+      auto j = i + 1;
+      while (j < sortedRows.size() && sortedRows[j] == sortedRows[j - 1] + 1)
+      {
+        ++j;
+      }
+      hsize_t offset[2] = { sortedRows[i], 0 };
+      hsize_t count[2] = { j - i, numColumns };
+      fileSpace.selectHyperslab(H5S_SELECT_OR, count, offset);
+      i = j;
+    }
+
+    hsize_t       memDims[2] = { i - batchBegin, numColumns };
+    H5::DataSpace memSpace(fileSpace.getSimpleExtentNdims(), memDims);
+    ds.read(buffer + batchBegin * numColumns, HDF5PredTypeTraits<T>::GetPredRef(), memSpace, fileSpace);
+    batchBegin = i;
+  }
+}
+
+// read the given rows of a dataset of rank 1 or 2 into the row major buffer
+template <typename T>
+void
+ReadRows(const H5::DataSet & ds, const std::vector<unsigned> & rows, hsize_t numColumns, T * buffer)
+{
+  if (rows.empty())
+  {
+    return;
+  }
+
+  // HDF5 reads a selection in the order of the file, the rows are permuted afterwards if needed
+  std::vector<std::size_t> order(rows.size());
+  std::iota(std::begin(order), std::end(order), 0);
+  std::sort(std::begin(order), std::end(order), [&rows](std::size_t a, std::size_t b) { return rows[a] < rows[b]; });
+  std::vector<unsigned> sortedRows;
+  sortedRows.reserve(rows.size());
+  std::transform(
+    std::cbegin(order), std::cend(order), std::back_inserter(sortedRows), [&rows](std::size_t i) { return rows[i]; });
+
+  hsize_t dims[2];
+  ds.getSpace().getSimpleExtentDims(dims, nullptr);
+  if (sortedRows.back() >= dims[0])
+  {
+    throw StatisticalModelException("Row index out of range", Status::OUT_OF_RANGE_ERROR);
+  }
+  if (std::adjacent_find(std::cbegin(sortedRows), std::cend(sortedRows)) != std::cend(sortedRows))
+  {
+    throw StatisticalModelException("Duplicated row index", Status::BAD_INPUT_ERROR);
+  }
+
+  if (std::is_sorted(std::cbegin(rows), std::cend(rows)))
+  {
+    ReadSortedRows(ds, sortedRows, numColumns, buffer);
+    return;
+  }
+
+  std::vector<T> sortedBuffer(rows.size() * numColumns);
+  ReadSortedRows(ds, sortedRows, numColumns, sortedBuffer.data());
+  for (std::size_t i = 0; i < order.size(); ++i)
+  {
+    std::copy_n(&sortedBuffer[i * numColumns], numColumns, buffer + order[i] * numColumns);
+  }
+}
 } // namespace details
 
 template <class T>
@@ -116,7 +283,8 @@ template <class T>
 inline H5::DataSet
 HDF5Utils::WriteMatrixOfType(const H5::H5Location &                             fg,
                              const char *                                       name,
-                             const typename GenericEigenTraits<T>::MatrixType & matrix)
+                             const typename GenericEigenTraits<T>::MatrixType & matrix,
+                             const HDF5StorageOptions &                         options)
 {
   // HDF5 does not like empty matrices.
   //
@@ -126,7 +294,10 @@ HDF5Utils::WriteMatrixOfType(const H5::H5Location &
   }
 
   hsize_t     dims[2] = { static_cast<hsize_t>(matrix.rows()), static_cast<hsize_t>(matrix.cols()) };
-  H5::DataSet ds = fg.createDataSet(name, details::HDF5PredTypeTraits<T>::GetPredRef(), H5::DataSpace(2, dims));
+  H5::DataSet ds = fg.createDataSet(name,
+                                    details::HDF5PredTypeTraits<T>::GetPredRef(),
+                                    H5::DataSpace(2, dims),
+                                    details::CreateDataSetProperties(options, 2, dims, sizeof(T)));
   ds.write(matrix.data(), details::HDF5PredTypeTraits<T>::GetPredRef());
   return ds;
 }
@@ -148,10 +319,14 @@ template <class T>
 inline H5::DataSet
 HDF5Utils::WriteVectorOfType(const H5::H5Location &                             fg,
                              const char *                                       name,
-                             const typename GenericEigenTraits<T>::VectorType & vector)
+                             const typename GenericEigenTraits<T>::VectorType & vector,
+                             const HDF5StorageOptions &                         options)
 {
   hsize_t     dims[1] = { static_cast<hsize_t>(vector.size()) };
-  H5::DataSet ds = fg.createDataSet(name, details::HDF5PredTypeTraits<T>::GetPredRef(), H5::DataSpace(1, dims));
+  H5::DataSet ds = fg.createDataSet(name,
+                                    details::HDF5PredTypeTraits<T>::GetPredRef(),
+                                    H5::DataSpace(1, dims),
+                                    details::CreateDataSetProperties(options, 1, dims, sizeof(T)));
   ds.write(vector.data(), details::HDF5PredTypeTraits<T>::GetPredRef());
   return ds;
 }
@@ -299,9 +474,78 @@ HDF5Utils::ReadMatrix(const H5::H5Location & fg, const char * name, unsigned max
 }
 
 inline H5::DataSet
-HDF5Utils::WriteMatrix(const H5::H5Location & fg, const char * name, const MatrixType & matrix)
+HDF5Utils::WriteMatrix(const H5::H5Location &     fg,
+                       const char *               name,
+                       const MatrixType &         matrix,
+                       const HDF5StorageOptions & options)
+{
+  return WriteMatrixOfType<ScalarType>(fg, name, matrix, options);
+}
+
+inline void
+HDF5Utils::ReadMatrixRows(const H5::H5Location &        fg,
+                          const char *                  name,
+                          const std::vector<unsigned> & rows,
+                          unsigned                      maxNumColumns,
+                          MatrixType &                  matrix)
 {
-  return WriteMatrixOfType<ScalarType>(fg, name, matrix);
+  auto    ds = fg.openDataSet(name);
+  hsize_t dims[2];
+  ds.getSpace().getSimpleExtentDims(dims, nullptr);
+
+  auto nCols = std::min(dims[1], static_cast<hsize_t>(maxNumColumns));
+  matrix.resize(rows.size(), nCols);
+  details::ReadRows(ds, rows, nCols, matrix.data());
+}
+
+inline H5::DataSet
+HDF5Utils::WriteMatrixInRowBlocks(const H5::H5Location &                                                 fg,
+                                  const char *                                                           name,
+                                  unsigned                                                               numRows,
+                                  unsigned                                                               numColumns,
+                                  const std::function<void(unsigned, unsigned, Eigen::Ref<MatrixType>)> & computeRows,
+                                  const HDF5StorageOptions &                                             options,
+                                  unsigned maxNumBlockRows)
+{
+  // about 16MB for the staging buffer
+  constexpr hsize_t kDefaultBlockBytes = 1 << 24;
+
+  if (numRows == 0 || numColumns == 0)
+  {
+    throw StatisticalModelException("Empty matrix provided to writeMatrix", Status::INVALID_DATA_ERROR);
+  }
+
+  const auto & predType = details::HDF5PredTypeTraits<ScalarType>::GetPredRef();
+  hsize_t      dims[2] = { numRows, numColumns };
+  auto         properties = details::CreateDataSetProperties(options, 2, dims, sizeof(ScalarType));
+  H5::DataSet  ds = fg.createDataSet(name, predType, H5::DataSpace(2, dims), properties);
+
+  hsize_t blockRows = maxNumBlockRows;
+  if (blockRows == 0)
+  {
+    blockRows = std::max<hsize_t>(1, kDefaultBlockBytes / (sizeof(ScalarType) * numColumns));
+  }
+  if (properties.getLayout() == H5D_CHUNKED)
+  {
+    // write whole chunks, such that each chunk is filtered once
+    hsize_t chunk[2];
+    properties.getChunk(2, chunk);
+    blockRows = std::max(chunk[0], blockRows / chunk[0] * chunk[0]);
+  }
+  blockRows = std::min<hsize_t>(blockRows, numRows);
+
+  MatrixType    block(blockRows, numColumns);
+  H5::DataSpace fileSpace = ds.getSpace();
+  for (hsize_t firstRow = 0; firstRow < numRows; firstRow += blockRows)
+  {
+    hsize_t count[2] = { std::min<hsize_t>(blockRows, numRows - firstRow), numColumns };
+    hsize_t offset[2] = { firstRow, 0 };
+    computeRows(firstRow, count[0], block.topRows(count[0]));
+
+    fileSpace.selectHyperslab(H5S_SELECT_SET, count, offset);
+    ds.write(block.data(), predType, H5::DataSpace(2, count), fileSpace);
+  }
+  return ds;
 }
 
 inline void
@@ -310,6 +554,17 @@ HDF5Utils::ReadVector(const H5::H5Location & fg, const char * name, VectorType &
   ReadVectorOfType<ScalarType>(fg, name, vector);
 }
 
+inline void
+HDF5Utils::ReadVectorElements(const H5::H5Location &        fg,
+                              const char *                  name,
+                              const std::vector<unsigned> & indices,
+                              VectorType &                  vector)
+{
+  auto ds = fg.openDataSet(name);
+  vector.resize(indices.size());
+  details::ReadRows(ds, indices, 1, vector.data());
+}
+
 inline void
 HDF5Utils::ReadVector(const H5::H5Location & fg, const char * name, unsigned maxNumElements, VectorType & vector)
 {
@@ -344,9 +599,34 @@ HDF5Utils::ReadVector(const H5::H5Location & fg, const char * name, unsigned max
 }
 
 inline H5::DataSet
-HDF5Utils::WriteVector(const H5::H5Location & fg, const char * name, const VectorType & vector)
+HDF5Utils::WriteVector(const H5::H5Location &     fg,
+                       const char *               name,
+                       const VectorType &         vector,
+                       const HDF5StorageOptions & options)
+{
+  return WriteVectorOfType<ScalarType>(fg, name, vector, options);
+}
+
+inline bool
+HDF5Utils::IsCompressionAvailable(HDF5Compression compression)
+{
+  return compression == HDF5Compression::NONE || H5Zfilter_avail(details::GetCompressionFilter(compression)) > 0;
+}
+
+inline std::unique_lock<std::mutex>
+HDF5Utils::LockLibrary()
 {
-  return WriteVectorOfType<ScalarType>(fg, name, vector);
+  static std::mutex libraryMutex;
+  static const bool kIsThreadSafe = []() {
+    hbool_t isThreadSafe = false;
+    return H5is_library_threadsafe(&isThreadSafe) >= 0 && isThreadSafe;
+  }();
+
+  if (kIsThreadSafe)
+  {
+    return std::unique_lock<std::mutex>{};
+  }
+  return std::unique_lock<std::mutex>{ libraryMutex };
 }
 
 inline H5::DataSet
@@ -361,12 +641,70 @@ HDF5Utils::WriteString(const H5::H5Location & fg, const char * name, const std::
 inline std::string
 HDF5Utils::ReadString(const H5::H5Location & fg, const char * name)
 {
-  H5std_string outputString;
-  H5::DataSet  ds = fg.openDataSet(name);
-  ds.read(outputString, ds.getStrType());
+  H5::DataSet ds = fg.openDataSet(name);
+  H5::StrType type = ds.getStrType();
+  if (type.isVariableStr())
+  {
+    H5std_string outputString;
+    ds.read(outputString, type);
+    return outputString;
+  }
+
+  // fixed length strings (see WriteString) are read in place, without the intermediate buffer of H5std_string
+  std::string outputString(type.getSize(), '\0');
+  ds.read(outputString.data(), type);
+  auto end = outputString.find('\0');
+  if (end != std::string::npos)
+  {
+    outputString.resize(end);
+  }
   return outputString;
 }
 
+inline H5::DataSet
+HDF5Utils::WriteStringList(const H5::H5Location & fg, const char * name, const std::vector<std::string> & strings)
+{
+  std::vector<const char *> buffer(strings.size());
+  std::transform(
+    std::cbegin(strings), std::cend(strings), std::begin(buffer), [](const std::string & s) { return s.c_str(); });
+
+  H5::StrType type(H5::PredType::C_S1, H5T_VARIABLE);
+  hsize_t     dims[] = { strings.size() };
+  H5::DataSet ds = fg.createDataSet(name, type, H5::DataSpace(1, dims));
+  if (!buffer.empty())
+  {
+    ds.write(buffer.data(), type);
+  }
+  return ds;
+}
+
+inline std::vector<std::string>
+HDF5Utils::ReadStringList(const H5::H5Location & fg, const char * name)
+{
+  H5::DataSet   ds = fg.openDataSet(name);
+  H5::DataSpace space = ds.getSpace();
+  hsize_t       dims[1];
+  space.getSimpleExtentDims(dims, nullptr);
+
+  std::vector<std::string> strings;
+  if (dims[0] == 0)
+  {
+    return strings;
+  }
+
+  // the strings are allocated by HDF5, and released once they are copied
+  H5::StrType         type(H5::PredType::C_S1, H5T_VARIABLE);
+  std::vector<char *> buffer(dims[0], nullptr);
+  ds.read(buffer.data(), type);
+  strings.reserve(buffer.size());
+  for (const char * s : buffer)
+  {
+    strings.emplace_back(s ? s : "");
+  }
+  H5::DataSet::vlenReclaim(buffer.data(), type, space);
+  return strings;
+}
+
 inline void
 HDF5Utils::WriteStringAttribute(const H5::H5Object & fg, const char * name, const std::string & s)
 {
@@ -454,26 +792,15 @@ HDF5Utils::DumpFileToHDF5(const char * filename, const H5::H5Location & fg, cons
     throw StatisticalModelException(s.c_str(), Status::IO_ERROR);
   }
 
-  std::vector<char> buffer;
-  ifile >> std::noskipws;
-  std::copy(std::istream_iterator<char>(ifile), std::istream_iterator<char>(), std::back_inserter(buffer));
-
-  hsize_t     dims[] = { buffer.size() };
-  H5::DataSet ds = fg.createDataSet(name, H5::PredType::NATIVE_CHAR, H5::DataSpace(1, dims));
-  ds.write(&buffer[0], H5::PredType::NATIVE_CHAR);
+  std::ostringstream buffer;
+  buffer << ifile.rdbuf();
+  DumpBufferToHDF5(buffer.str(), fg, name);
 }
 
 inline void
 HDF5Utils::GetFileFromHDF5(const H5::H5Location & fg, const char * name, const char * filename)
 {
-  H5::DataSet ds = fg.openDataSet(name);
-  hsize_t     dims[1];
-  ds.getSpace().getSimpleExtentDims(dims, nullptr);
-  std::vector<char> buffer(dims[0]);
-  if (!buffer.empty())
-  {
-    ds.read(&buffer[0], H5::PredType::NATIVE_CHAR);
-  }
+  auto buffer = GetBufferFromHDF5(fg, name);
 
   std::ofstream ofile(filename, std::ios::binary);
   if (!ofile)
@@ -482,7 +809,32 @@ HDF5Utils::GetFileFromHDF5(const H5::H5Location & fg, const char * name, const c
     throw StatisticalModelException(s.c_str(), Status::IO_ERROR);
   }
 
-  std::copy(std::begin(buffer), std::end(buffer), std::ostream_iterator<char>(ofile));
+  ofile.write(buffer.data(), buffer.size());
+}
+
+inline void
+HDF5Utils::DumpBufferToHDF5(const std::string & buffer, const H5::H5Location & fg, const char * name)
+{
+  hsize_t     dims[] = { buffer.size() };
+  H5::DataSet ds = fg.createDataSet(name, H5::PredType::NATIVE_CHAR, H5::DataSpace(1, dims));
+  if (!buffer.empty())
+  {
+    ds.write(buffer.data(), H5::PredType::NATIVE_CHAR);
+  }
+}
+
+inline std::string
+HDF5Utils::GetBufferFromHDF5(const H5::H5Location & fg, const char * name)
+{
+  H5::DataSet ds = fg.openDataSet(name);
+  hsize_t     dims[1];
+  ds.getSpace().getSimpleExtentDims(dims, nullptr);
+  std::string buffer(dims[0], '\0');
+  if (!buffer.empty())
+  {
+    ds.read(buffer.data(), H5::PredType::NATIVE_CHAR);
+  }
+  return buffer;
 }
 
 } // namespace statismo
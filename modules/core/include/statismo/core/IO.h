@@ -40,6 +40,13 @@
 
 #include "statismo/core/StatisticalModel.h"
 #include "statismo/core/Logger.h"
+#include "statismo/core/ThreadPool.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <future>
+#include <vector>
 
 namespace H5
 {
@@ -69,183 +76,292 @@ public:
 
   /**
    * \brief Load statistical model from file
+   *
+   * The file is read under the HDF5 library lock (see HDF5Utils::LockLibrary), such that models can be loaded
+   * from several threads, and the model is created after the lock is released.
    * \param representer representer bound to the model
    * \param filename path to hdf5 file
    * \param maxNumberOfPCAComponents maximal number of pca components loaded
    * to create the model.
+   * \param modelInfoFlags parts of the model info that are loaded (see ModelInfo::Load)
    */
   static UniquePtrType<StatisticalModelType>
   LoadStatisticalModel(typename StatisticalModelType::RepresenterType * representer,
                        const std::string &                              filename,
-                       unsigned maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max())
+                       unsigned maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max(),
+                       ModelInfoLoadFlags modelInfoFlags = ModelInfoLoadFlags::ALL)
   {
+    return LoadModelFromFile(representer, filename, maxNumberOfPCAComponents, nullptr, modelInfoFlags);
+  }
 
-    UniquePtrType<StatisticalModelType> newModel;
+  /**
+   * \brief Load the model of a region of interest, given by a set of points, from a file
+   *
+   * Only the rows of the mean and of the PCA basis that belong to the points are read from the file, such that
+   * the memory and the time needed to load the model scale with the size of the region. The returned model is the
+   * marginal of the model on these points: its principal components are those of the full model, restricted to the
+   * region, and the coefficients of both models are interchangeable.
+   * The point i of the new model is the i-th point id, in increasing order. Its representer is created with
+   * Representer::CloneForPoints, which not all representers support.
+   * \param representer representer bound to the full model
+   * \param filename path to hdf5 file
+   * \param pointIds ids of the points of the region
+   * \param maxNumberOfPCAComponents maximal number of pca components loaded
+   */
+  static UniquePtrType<StatisticalModelType>
+  LoadStatisticalModelForPoints(typename StatisticalModelType::RepresenterType * representer,
+                                const std::string &                              filename,
+                                const std::vector<unsigned> &                    pointIds,
+                                unsigned maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max())
+  {
+    return LoadModelFromFile(
+      representer, filename, maxNumberOfPCAComponents, [&pointIds](const RepresenterType &) { return pointIds; });
+  }
 
-    H5::H5File file;
-    try
-    {
-      file = H5::H5File(filename.c_str(), H5F_ACC_RDONLY);
-    }
-    catch (const H5::Exception & e)
+  /**
+   * \brief Load the model of a region of interest, given by an axis aligned box, from a file
+   *
+   * The region is made of the points of the domain of the model that lie in the box (see PointToVector).
+   * \sa LoadStatisticalModelForPoints
+   * \param representer representer bound to the full model
+   * \param filename path to hdf5 file
+   * \param lowerCorner, upperCorner corners of the box
+   * \param maxNumberOfPCAComponents maximal number of pca components loaded
+   */
+  static UniquePtrType<StatisticalModelType>
+  LoadStatisticalModelInBox(typename StatisticalModelType::RepresenterType * representer,
+                            const std::string &                              filename,
+                            const VectorType &                               lowerCorner,
+                            const VectorType &                               upperCorner,
+                            unsigned maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max())
+  {
+    if (lowerCorner.size() != upperCorner.size())
     {
-      std::string msg(std::string("could not open HDF5 file \n") + e.getCDetailMsg());
-      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
+      throw StatisticalModelException("The corners of the box have different dimensions", Status::BAD_INPUT_ERROR);
     }
 
-    return LoadStatisticalModel(representer, file.openGroup("/"), maxNumberOfPCAComponents);
+    auto selectPoints = [&](const typename StatisticalModelType::RepresenterType & fullRepresenter) {
+      std::vector<unsigned> pointIds;
+      const auto &          points = fullRepresenter.GetDomain().GetDomainPoints();
+      for (unsigned i = 0; i < points.size(); ++i)
+      {
+        VectorType pt = fullRepresenter.PointToVector(points[i]);
+        if (pt.size() != lowerCorner.size())
+        {
+          throw StatisticalModelException("The dimension of the box does not match the dimension of the points",
+                                          Status::BAD_INPUT_ERROR);
+        }
+        if ((pt.array() >= lowerCorner.array()).all() && (pt.array() <= upperCorner.array()).all())
+        {
+          pointIds.push_back(i);
+        }
+      }
+      return pointIds;
+    };
+
+    return LoadModelFromFile(representer, filename, maxNumberOfPCAComponents, selectPoints);
   }
 
   /**
    * \brief Load statistical model from group
+   *
+   * The caller owns the HDF5 objects, hence it holds the HDF5 library lock if other threads use HDF5.
    * \param representer representer bound to the model
    * \param modelRoot H5 group where the model is saved
    * \param maxNumberOfPCAComponents maximal number of pca components loaded
    * to create the model.
+   * \param modelInfoFlags parts of the model info that are loaded (see ModelInfo::Load)
    */
   static UniquePtrType<StatisticalModelType>
   LoadStatisticalModel(typename StatisticalModelType::RepresenterType * representer,
                        const H5::Group &                                modelRoot,
-                       unsigned maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max())
+                       unsigned maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max(),
+                       ModelInfoLoadFlags modelInfoFlags = ModelInfoLoadFlags::ALL)
   {
+    return LoadModel(representer, modelRoot, maxNumberOfPCAComponents, nullptr, modelInfoFlags);
+  }
 
-    UniquePtrType<StatisticalModelType> newModel;
-    ModelInfo                           modelInfo;
+  /**
+   * \brief Load statistical model from file in the background
+   *
+   * The file is read by a task of \a pool, or by a new thread if no pool is given, and the model is returned
+   * through the future. Several models can thus be loaded concurrently, and the loading time of a set of models
+   * is bounded by the slowest one rather than by their sum.
+   * The HDF5 reads of a task are serialized with those of the other tasks if the HDF5 library is not thread-safe
+   * (see HDF5Utils::LockLibrary), while the creation of the models, which is the other costly part of the loading,
+   * runs concurrently.
+   * \warning The representer is loaded by the task: it must not be used, and must not be shared with another
+   * load, until the future is ready.
+   * \param representer representer bound to the model
+   * \param filename path to hdf5 file
+   * \param maxNumberOfPCAComponents maximal number of pca components loaded
+   * \param pool thread pool running the load
+   */
+  static std::future<UniquePtrType<StatisticalModelType>>
+  LoadStatisticalModelAsync(typename StatisticalModelType::RepresenterType * representer,
+                            const std::string &                              filename,
+                            unsigned maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max(),
+                            const SharedPtrType<ThreadPool> & pool = nullptr)
+  {
+    if (!representer)
+    {
+      throw StatisticalModelException("invalid null representer", Status::BAD_INPUT_ERROR);
+    }
 
-    try
+    auto load = [representer, filename, maxNumberOfPCAComponents]() {
+      return LoadModelFromFile(representer, filename, maxNumberOfPCAComponents, nullptr);
+    };
+
+    if (pool)
     {
-      representer->Load(modelRoot.openGroup("./representer"));
+      return pool->Submit(load);
+    }
+    return std::async(std::launch::async, load);
+  }
 
-      int minorVersion = 0;
-      int majorVersion = 0;
+  /**
+   * \brief Load the models stored in several groups of a file
+   *
+   * The file is opened once and the groups are read one after another by the calling thread. If a \a pool is
+   * given, each model is created by a task of the pool while the next groups are read, such that the HDF5 reads
+   * overlap with the creation of the models. At most two models per thread of the pool are read ahead, which
+   * bounds the memory held by the pipeline.
+   * The calling thread holds the HDF5 library lock (see HDF5Utils::LockLibrary) while it reads, the tasks of the
+   * pool never use HDF5.
+   * \param representer representer bound to the models. It holds the representer of the last group on return.
+   * \param filename path to hdf5 file
+   * \param groupNames paths of the model groups in the file, as passed to SaveStatisticalModel(model, group)
+   * \param maxNumberOfPCAComponents maximal number of pca components loaded
+   * \param pool thread pool creating the models
+   * \return the models, in the order of \a groupNames
+   */
+  static std::vector<UniquePtrType<StatisticalModelType>>
+  LoadStatisticalModels(typename StatisticalModelType::RepresenterType * representer,
+                        const std::string &                              filename,
+                        const std::vector<std::string> &                 groupNames,
+                        unsigned maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max(),
+                        const SharedPtrType<ThreadPool> & pool = nullptr)
+  {
+    if (!representer)
+    {
+      throw StatisticalModelException("invalid null representer", Status::BAD_INPUT_ERROR);
+    }
 
-      if (!HDF5Utils::ExistsObjectWithName(modelRoot, "version"))
+    std::vector<UniquePtrType<StatisticalModelType>>              models;
+    std::deque<std::future<UniquePtrType<StatisticalModelType>>> pendingModels;
+    const std::size_t kMaxReadAhead = pool ? 2 * std::size_t{ pool->GetNumberOfThreads() } : 0;
+
+    {
+      auto lock = HDF5Utils::LockLibrary();
+      auto file = OpenFile(filename);
+      for (const auto & groupName : groupNames)
       {
-        // This is an old statismo format, that was versioned.
-        // We set the version to 0.8 as this is the last
-        // version that stores the old format.
-        if (representer->GetLogger())
+        // ReadModel translates the HDF5 errors of the model itself
+        ModelData data;
+        try
         {
-          representer->GetLogger()->Log(LogEntry{ "version attribute does not exist in hdf5 file. Assuming version 0.8",
-                                                  __FILE__,
-                                                  std::to_string(__LINE__) },
-                                        LogLevel::LOG_WARNING);
+          auto modelRoot = file.openGroup(groupName.c_str());
+          data = ReadModel(representer, modelRoot, maxNumberOfPCAComponents, nullptr);
+        }
+        catch (const H5::Exception & e)
+        {
+          std::string msg(std::string("could not open the model group ") + groupName + "\n" + e.getCDetailMsg());
+          throw StatisticalModelException(msg.c_str(), Status::INVALID_DATA_ERROR);
         }
 
-        minorVersion = gk_oldFileVersionMinor;
-        majorVersion = gk_oldFileVersionMajor;
-      }
-      else
-      {
-        auto versionGroup = modelRoot.openGroup("./version");
-        minorVersion = HDF5Utils::ReadInt(versionGroup, "./minorVersion");
-        majorVersion = HDF5Utils::ReadInt(versionGroup, "./majorVersion");
-      }
-
-      auto       modelGroup = modelRoot.openGroup("./model");
-      VectorType mean;
-      HDF5Utils::ReadVector(modelGroup, "./mean", mean);
-      VectorType pcaVariance;
-      HDF5Utils::ReadVector(modelGroup, "./pcaVariance", maxNumberOfPCAComponents, pcaVariance);
+        if (!pool)
+        {
+          models.push_back(CreateModel(representer, std::move(data)));
+          continue;
+        }
 
-      auto noiseVariance = HDF5Utils::ReadFloat(modelGroup, "./noiseVariance");
+        // the representer is reloaded by the next group, hence the task creates the model with a copy of it
+        if (!data.roiRepresenter)
+        {
+          data.roiRepresenter = representer->SafeCloneSelf();
+        }
+        auto sharedData = std::make_shared<ModelData>(std::move(data));
+        pendingModels.push_back(
+          pool->Submit([representer, sharedData]() { return CreateModel(representer, std::move(*sharedData)); }));
 
-      // Depending on the statismo version, the pcaBasis matrix was stored as U*D or U (where U are the orthonormal PCA
-      // Basis functions and D the standard deviations). Here we make sure that we fill the pcaBasisMatrix (which
-      // statismo stores as U*D) with the right values.
-      MatrixType pcaBasisMatrix;
-      if (majorVersion == gk_oldFileVersionMinor && minorVersion == gk_oldFileVersionMajor)
-      {
-        HDF5Utils::ReadMatrix(modelGroup, "./pcaBasis", maxNumberOfPCAComponents, pcaBasisMatrix);
-        VectorType D = pcaVariance.array().sqrt(); // NOLINT
-        MatrixType orthonormalPCABasisMatrix = pcaBasisMatrix * DiagMatrixType(D).inverse();
-        newModel =
-          StatisticalModelType::SafeCreate(representer, mean, orthonormalPCABasisMatrix, pcaVariance, noiseVariance);
-      }
-      else if (majorVersion == gk_currenFileVersionMajor && minorVersion == gk_currentFileVersionMinor)
-      {
-        HDF5Utils::ReadMatrix(modelGroup, "./pcaBasis", maxNumberOfPCAComponents, pcaBasisMatrix);
-        newModel = StatisticalModelType::SafeCreate(representer, mean, pcaBasisMatrix, pcaVariance, noiseVariance);
-      }
-      else
-      {
-        std::ostringstream os;
-        os << "an invalid statismo version was provided (" << majorVersion << "." << minorVersion << ")";
-        throw StatisticalModelException(os.str().c_str(), Status::BAD_VERSION_ERROR);
+        if (pendingModels.size() > kMaxReadAhead)
+        {
+          models.push_back(pendingModels.front().get());
+          pendingModels.pop_front();
+        }
       }
-
-      modelInfo.Load(modelRoot);
     }
-    catch (H5::Exception & e)
+
+    for (auto & pendingModel : pendingModels)
     {
-      std::string msg(std::string("an exeption occured while reading HDF5 file") +
-                      "The most likely cause is that the hdf5 file does not contain the required objects. \n" +
-                      e.getCDetailMsg());
-      throw StatisticalModelException(msg.c_str(), Status::INVALID_DATA_ERROR);
+      models.push_back(pendingModel.get());
     }
-
-    newModel->SetModelInfo(modelInfo);
-    return newModel;
+    return models;
   }
 
 
+
   /**
    * \brief Saves the statistical model to a HDF5 file
    * \param model pointer to the model
    * \param filename filename (preferred extension is .h5)
+   * \param options chunking and compression of the model datasets (see HDF5StorageOptions)
    * */
   static void
-  SaveStatisticalModel(const StatisticalModelType * const model, const std::string & filename)
+  SaveStatisticalModel(const StatisticalModelType * const model,
+                       const std::string &                filename,
+                       const HDF5StorageOptions &         options = HDF5StorageOptions())
   {
     if (!model)
     {
       throw StatisticalModelException("invalid null model", Status::BAD_INPUT_ERROR);
     }
-    SaveStatisticalModel(*model, filename);
+    SaveStatisticalModel(*model, filename, options);
   }
 
   /**
    * \brief Save statistical model
+   *
+   * The file is written under the HDF5 library lock (see HDF5Utils::LockLibrary).
    * \param model model to save
    * \param filename filename (preferred extension is .h5)
+   * \param options chunking and compression of the model datasets (see HDF5StorageOptions)
    * */
   static void
-  SaveStatisticalModel(const StatisticalModelType & model, const std::string & filename)
+  SaveStatisticalModel(const StatisticalModelType & model,
+                       const std::string &          filename,
+                       const HDF5StorageOptions &   options = HDF5StorageOptions())
   {
     using namespace H5;
 
-    H5File        file;
+    // the file must be closed before the lock is released
+    auto          lock = HDF5Utils::LockLibrary();
     std::ifstream ifile(filename.c_str());
+    auto          file = OpenFileForWriting(filename);
 
-    try
-    {
-      file = H5::H5File(filename.c_str(), H5F_ACC_TRUNC);
-    }
-    catch (H5::FileIException & e)
-    {
-      std::string msg(std::string("Could not open HDF5 file for writing \n") + e.getCDetailMsg());
-      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
-    }
-
-    auto modelRoot = file.openGroup("/");
-    auto versionGroup = modelRoot.createGroup("version");
-
-    HDF5Utils::WriteInt(versionGroup, "majorVersion", 0);
-    HDF5Utils::WriteInt(versionGroup, "minorVersion", 9);
-
-    SaveStatisticalModel(model, modelRoot);
+    SaveStatisticalModel(model, file.openGroup("/"), options);
   };
 
   /**
    * \brief Save statistical model to the given HDF5 group.
+   *
+   * The group holds a complete model, with its version, such that several models can be stored in the groups of a
+   * file and loaded with LoadStatisticalModels.
    * \param model model to save
    * \param modelRoot group where to store the model
+   * \param options chunking and compression of the model datasets (see HDF5StorageOptions)
    * */
   static void
-  SaveStatisticalModel(const StatisticalModelType & model, const H5::Group & modelRoot)
+  SaveStatisticalModel(const StatisticalModelType & model,
+                       const H5::Group &            modelRoot,
+                       const HDF5StorageOptions &   options = HDF5StorageOptions())
   {
     try
     {
+      auto versionGroup = modelRoot.createGroup("./version");
+      HDF5Utils::WriteInt(versionGroup, "majorVersion", gk_currenFileVersionMajor);
+      HDF5Utils::WriteInt(versionGroup, "minorVersion", gk_currentFileVersionMinor);
+
       // create the group structure
       using RepresenterType = typename StatisticalModelType::RepresenterType;
       auto dataTypeStr = RepresenterType::TypeToString(model.GetRepresenter()->GetType());
@@ -258,9 +374,18 @@ public:
       model.GetRepresenter()->Save(representerGroup);
 
       auto modelGroup = modelRoot.createGroup("./model");
-      HDF5Utils::WriteMatrix(modelGroup, "./pcaBasis", model.GetOrthonormalPCABasisMatrix());
-      HDF5Utils::WriteVector(modelGroup, "./pcaVariance", model.GetPCAVarianceVector());
-      HDF5Utils::WriteVector(modelGroup, "./mean", model.GetMeanVector());
+      // the orthonormal basis is computed and written in blocks of rows, which bounds the memory needed to save
+      HDF5Utils::WriteMatrixInRowBlocks(
+        modelGroup,
+        "./pcaBasis",
+        model.GetMeanVector().size(),
+        model.GetNumberOfPrincipalComponents(),
+        [&model](unsigned firstRow, unsigned numRows, Eigen::Ref<MatrixType> rows) {
+          model.ComputeOrthonormalPCABasisRows(firstRow, numRows, rows);
+        },
+        options);
+      HDF5Utils::WriteVector(modelGroup, "./pcaVariance", model.GetPCAVarianceVector(), options);
+      HDF5Utils::WriteVector(modelGroup, "./mean", model.GetMeanVector(), options);
       HDF5Utils::WriteFloat(modelGroup, "./noiseVariance", model.GetNoiseVariance());
 
       model.GetModelInfo().Save(modelRoot);
@@ -271,6 +396,207 @@ public:
       throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
     }
   }
+
+private:
+  using RepresenterType = typename StatisticalModelType::RepresenterType;
+  using PointSelectorType = std::function<std::vector<unsigned>(const RepresenterType &)>;
+
+  static H5::H5File
+  OpenFile(const std::string & filename)
+  {
+    try
+    {
+      return H5::H5File(filename.c_str(), H5F_ACC_RDONLY);
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("could not open HDF5 file \n") + e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
+    }
+  }
+
+  static H5::H5File
+  OpenFileForWriting(const std::string & filename)
+  {
+    try
+    {
+      return H5::H5File(filename.c_str(), H5F_ACC_TRUNC);
+    }
+    catch (const H5::Exception & e)
+    {
+      std::string msg(std::string("Could not open HDF5 file for writing \n") + e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::IO_ERROR);
+    }
+  }
+
+  // the content of a model file, read before the model is created
+  struct ModelData
+  {
+    int                            majorVersion{ 0 };
+    int                            minorVersion{ 0 };
+    VectorType                     mean;
+    VectorType                     pcaVariance;
+    MatrixType                     pcaBasisMatrix;
+    float                          noiseVariance{ 0.0f };
+    ModelInfo                      modelInfo;
+    UniquePtrType<RepresenterType> roiRepresenter;
+  };
+
+  // same as LoadModel, the file is read under the HDF5 library lock and the model is created without it
+  static UniquePtrType<StatisticalModelType>
+  LoadModelFromFile(RepresenterType *         representer,
+                    const std::string &       filename,
+                    unsigned                  maxNumberOfPCAComponents,
+                    const PointSelectorType & selectPoints,
+                    ModelInfoLoadFlags        modelInfoFlags = ModelInfoLoadFlags::ALL)
+  {
+    ModelData data;
+    {
+      auto lock = HDF5Utils::LockLibrary();
+      auto file = OpenFile(filename);
+      data = ReadModel(representer, file.openGroup("/"), maxNumberOfPCAComponents, selectPoints, modelInfoFlags);
+    }
+    return CreateModel(representer, std::move(data));
+  }
+
+  // load the model, or the model of the points returned by selectPoints if it is set
+  static UniquePtrType<StatisticalModelType>
+  LoadModel(RepresenterType *         representer,
+            const H5::Group &         modelRoot,
+            unsigned                  maxNumberOfPCAComponents,
+            const PointSelectorType & selectPoints,
+            ModelInfoLoadFlags        modelInfoFlags = ModelInfoLoadFlags::ALL)
+  {
+    return CreateModel(representer,
+                       ReadModel(representer, modelRoot, maxNumberOfPCAComponents, selectPoints, modelInfoFlags));
+  }
+
+  // read the model data and load the representer, this is the only part of the loading that uses HDF5
+  static ModelData
+  ReadModel(RepresenterType *         representer,
+            const H5::Group &         modelRoot,
+            unsigned                  maxNumberOfPCAComponents,
+            const PointSelectorType & selectPoints,
+            ModelInfoLoadFlags        modelInfoFlags = ModelInfoLoadFlags::ALL)
+  {
+    ModelData data;
+
+    try
+    {
+      representer->Load(modelRoot.openGroup("./representer"));
+
+      // the rows of the mean and of the basis of the region of interest, or all the rows
+      std::vector<unsigned> rows;
+      if (selectPoints)
+      {
+        std::vector<unsigned> pointIds = selectPoints(*representer);
+        std::sort(std::begin(pointIds), std::end(pointIds));
+        pointIds.erase(std::unique(std::begin(pointIds), std::end(pointIds)), std::end(pointIds));
+        if (pointIds.empty())
+        {
+          throw StatisticalModelException("The region of interest does not contain any point",
+                                          Status::BAD_INPUT_ERROR);
+        }
+        if (pointIds.back() >= representer->GetDomain().GetNumberOfPoints())
+        {
+          throw StatisticalModelException("Invalid point id in the region of interest", Status::OUT_OF_RANGE_ERROR);
+        }
+
+        for (auto ptId : pointIds)
+        {
+          for (unsigned d = 0; d < representer->GetDimensions(); ++d)
+          {
+            rows.push_back(representer->MapPointIdToInternalIdx(ptId, d));
+          }
+        }
+        data.roiRepresenter.reset(representer->CloneForPoints(pointIds));
+      }
+
+      if (!HDF5Utils::ExistsObjectWithName(modelRoot, "version"))
+      {
+        // This is an old statismo format, that was versioned.
+        // We set the version to 0.8 as this is the last
+        // version that stores the old format.
+        if (representer->GetLogger())
+        {
+          representer->GetLogger()->Log(LogEntry{ "version attribute does not exist in hdf5 file. Assuming version 0.8",
+                                                  __FILE__,
+                                                  std::to_string(__LINE__) },
+                                        LogLevel::LOG_WARNING);
+        }
+
+        data.minorVersion = gk_oldFileVersionMinor;
+        data.majorVersion = gk_oldFileVersionMajor;
+      }
+      else
+      {
+        auto versionGroup = modelRoot.openGroup("./version");
+        data.minorVersion = HDF5Utils::ReadInt(versionGroup, "./minorVersion");
+        data.majorVersion = HDF5Utils::ReadInt(versionGroup, "./majorVersion");
+      }
+
+      if (!(data.majorVersion == gk_oldFileVersionMajor && data.minorVersion == gk_oldFileVersionMinor) &&
+          !(data.majorVersion == gk_previousFileVersionMajor && data.minorVersion == gk_previousFileVersionMinor) &&
+          !(data.majorVersion == gk_currenFileVersionMajor && data.minorVersion == gk_currentFileVersionMinor))
+      {
+        std::ostringstream os;
+        os << "an invalid statismo version was provided (" << data.majorVersion << "." << data.minorVersion << ")";
+        throw StatisticalModelException(os.str().c_str(), Status::BAD_VERSION_ERROR);
+      }
+
+      auto modelGroup = modelRoot.openGroup("./model");
+      if (selectPoints)
+      {
+        HDF5Utils::ReadVectorElements(modelGroup, "./mean", rows, data.mean);
+        HDF5Utils::ReadMatrixRows(modelGroup, "./pcaBasis", rows, maxNumberOfPCAComponents, data.pcaBasisMatrix);
+      }
+      else
+      {
+        HDF5Utils::ReadVector(modelGroup, "./mean", data.mean);
+        HDF5Utils::ReadMatrix(modelGroup, "./pcaBasis", maxNumberOfPCAComponents, data.pcaBasisMatrix);
+      }
+      HDF5Utils::ReadVector(modelGroup, "./pcaVariance", maxNumberOfPCAComponents, data.pcaVariance);
+      data.noiseVariance = HDF5Utils::ReadFloat(modelGroup, "./noiseVariance");
+
+      data.modelInfo.Load(modelRoot, modelInfoFlags);
+    }
+    catch (H5::Exception & e)
+    {
+      std::string msg(std::string("an exeption occured while reading HDF5 file") +
+                      "The most likely cause is that the hdf5 file does not contain the required objects. \n" +
+                      e.getCDetailMsg());
+      throw StatisticalModelException(msg.c_str(), Status::INVALID_DATA_ERROR);
+    }
+
+    return data;
+  }
+
+  // create the model from the data read by ReadModel
+  static UniquePtrType<StatisticalModelType>
+  CreateModel(RepresenterType * representer, ModelData && data)
+  {
+    auto * modelRepresenter = data.roiRepresenter ? data.roiRepresenter.get() : representer;
+
+    // Depending on the statismo version, the pcaBasis matrix was stored as U*D or U (where U are the orthonormal PCA
+    // Basis functions and D the standard deviations). Here we make sure that we fill the pcaBasisMatrix (which
+    // statismo stores as U*D) with the right values.
+    UniquePtrType<StatisticalModelType> newModel;
+    if (data.majorVersion == gk_oldFileVersionMajor && data.minorVersion == gk_oldFileVersionMinor)
+    {
+      VectorType D = data.pcaVariance.array().sqrt(); // NOLINT
+      MatrixType orthonormalPCABasisMatrix = data.pcaBasisMatrix * DiagMatrixType(D).inverse();
+      newModel = StatisticalModelType::SafeCreate(
+        modelRepresenter, data.mean, orthonormalPCABasisMatrix, data.pcaVariance, data.noiseVariance);
+    }
+    else
+    {
+      newModel = StatisticalModelType::SafeCreate(
+        modelRepresenter, data.mean, data.pcaBasisMatrix, data.pcaVariance, data.noiseVariance);
+    }
+
+    newModel->SetModelInfo(data.modelInfo);
+    return newModel;
+  }
 };
 
 } // namespace statismo
@@ -0,0 +1,369 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __STATIMO_CORE_INCREMENTAL_POSTERIOR_MODEL_H_
+#define __STATIMO_CORE_INCREMENTAL_POSTERIOR_MODEL_H_
+
+#include "statismo/core/CommonTypes.h"
+#include "statismo/core/Exceptions.h"
+#include "statismo/core/GenericFactory.h"
+#include "statismo/core/ModelInfo.h"
+#include "statismo/core/NonCopyable.h"
+#include "statismo/core/PosteriorModelBuilder.h"
+#include "statismo/core/StatisticalModel.h"
+
+#include <Eigen/Cholesky>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace statismo
+{
+
+/**
+ * \brief Posterior of a statistical model that is updated one landmark at a time
+ *
+ * PosteriorModelBuilder computes the posterior model from the full list of constraints. In interactive
+ * applications, where landmarks are added and removed one by one, rebuilding the model after each change
+ * is too expensive.
+ *
+ * This class only maintains the k x k posterior covariance of the coefficients of the prior model and the
+ * MAP coefficients. Adding or removing a landmark is a rank-d (Woodbury) update of these quantities,
+ * which costs O(k^2 d) and does not depend on the number of points of the model. The mean and covariance
+ * at single points can be queried directly, while the full posterior model (with its p x k basis) is only
+ * computed on demand by BuildPosteriorModel.
+ *
+ * The posterior model built from a set of landmarks is the same as the one returned by
+ * PosteriorModelBuilder::BuildNewModelFromModel for the same constraints.
+ *
+ * \warning The prior model must outlive this object.
+ * \ingroup Core
+ */
+template <typename T>
+class IncrementalPosteriorModel
+  : public GenericFactory<IncrementalPosteriorModel<T>>
+  , public NonCopyable
+{
+public:
+  using ObjectFactoryType = GenericFactory<IncrementalPosteriorModel<T>>;
+  using StatisticalModelType = StatisticalModel<T>;
+  using RepresenterType = typename StatisticalModelType::RepresenterType;
+  using PointType = typename StatisticalModelType::PointType;
+  using ValueType = typename StatisticalModelType::ValueType;
+  using PointCovarianceMatrixType = typename StatisticalModelType::PointCovarianceMatrixType;
+  using LandmarkIdType = unsigned;
+
+  friend ObjectFactoryType;
+
+  /**
+   * \brief Destroy the object.
+   */
+  void
+  Delete()
+  {
+    delete this;
+  }
+
+  /**
+   * \brief Add the constraint that the model has the value \a value at \a point
+   * \param covariance covariance of the error of the value
+   * \return id of the landmark, used to remove it
+   */
+  LandmarkIdType
+  AddLandmark(const PointType & point, const ValueType & value, const PointCovarianceMatrixType & covariance)
+  {
+    const auto * representer = m_priorModel->GetRepresenter();
+    auto         ptId = representer->GetPointIdForPoint(point);
+    CheckPointId(ptId);
+
+    if (covariance.rows() != m_dim || covariance.cols() != m_dim)
+    {
+      throw StatisticalModelException("The covariance of a landmark must be a dim x dim matrix",
+                                      Status::INVALID_DATA_ERROR);
+    }
+
+    Landmark landmark;
+    landmark.pointId = ptId;
+    landmark.value = representer->PointSampleToPointSampleVector(value);
+    landmark.covariance = covariance.template cast<double>();
+    landmark.precision = landmark.covariance.inverse();
+
+    const VectorTypeDoublePrecision residual = (landmark.value - PriorMeanAtPoint(ptId)).template cast<double>();
+    const MatrixTypeDoublePrecision rows = BasisRows(ptId);
+
+    // (M + Q_i^T L_i Q_i)^-1 = M^-1 - M^-1 Q_i^T (S_i + Q_i M^-1 Q_i^T)^-1 Q_i M^-1
+    Update(rows, landmark.covariance + rows * m_matMInverse * rows.transpose(), -1);
+    m_matM.noalias() += rows.transpose() * landmark.precision * rows;
+    m_rhs.noalias() += rows.transpose() * (landmark.precision * residual);
+    UpdateCoefficients();
+
+    auto id = m_nextLandmarkId++;
+    m_landmarks.emplace(id, std::move(landmark));
+    return id;
+  }
+
+  /**
+   * \brief Add a landmark with an uncorrelated error of variance \a variance
+   */
+  LandmarkIdType
+  AddLandmark(const PointType & point, const ValueType & value, double variance)
+  {
+    return AddLandmark(point, value, variance * PointCovarianceMatrixType::Identity(m_dim, m_dim));
+  }
+
+  /**
+   * \brief Remove the landmark with the given id
+   */
+  void
+  RemoveLandmark(LandmarkIdType id)
+  {
+    auto it = m_landmarks.find(id);
+    if (it == std::end(m_landmarks))
+    {
+      throw StatisticalModelException(("Unknown landmark " + std::to_string(id)).c_str(), Status::OUT_OF_RANGE_ERROR);
+    }
+
+    const auto &                    landmark = it->second;
+    const VectorTypeDoublePrecision residual =
+      (landmark.value - PriorMeanAtPoint(landmark.pointId)).template cast<double>();
+    const MatrixTypeDoublePrecision rows = BasisRows(landmark.pointId);
+
+    // (M - Q_i^T L_i Q_i)^-1 = M^-1 + M^-1 Q_i^T (S_i - Q_i M^-1 Q_i^T)^-1 Q_i M^-1
+    Update(rows, landmark.covariance - rows * m_matMInverse * rows.transpose(), 1);
+    m_matM.noalias() -= rows.transpose() * landmark.precision * rows;
+    m_rhs.noalias() -= rows.transpose() * (landmark.precision * residual);
+
+    m_landmarks.erase(it);
+    if (m_landmarks.empty())
+    {
+      // back to the prior, which also discards the rounding errors of the updates
+      Reset();
+    }
+    UpdateCoefficients();
+  }
+
+  /**
+   * \brief Remove all the landmarks
+   */
+  void
+  ClearLandmarks()
+  {
+    m_landmarks.clear();
+    Reset();
+  }
+
+  unsigned
+  GetNumberOfLandmarks() const
+  {
+    return m_landmarks.size();
+  }
+
+  /**
+   * \brief Return the MAP coefficients of the prior model given the landmarks
+   */
+  const VectorType &
+  GetCoefficients() const
+  {
+    return m_coefficients;
+  }
+
+  /**
+   * \brief Return the posterior covariance of the coefficients of the prior model
+   */
+  const MatrixTypeDoublePrecision &
+  GetCoefficientCovariance() const
+  {
+    return m_matMInverse;
+  }
+
+  /**
+   * \brief Return the posterior mean at the point with id \a ptId
+   */
+  VectorType
+  ComputeMeanAtPoint(unsigned ptId) const
+  {
+    CheckPointId(ptId);
+    return m_priorModel->GetRepresenter()->PointSampleToPointSampleVector(
+      m_priorModel->DrawSampleAtPoint(m_coefficients, ptId));
+  }
+
+  /**
+   * \brief Return the dim x dim posterior covariance at the point with id \a ptId (including the noise)
+   */
+  MatrixType
+  ComputeCovarianceAtPoint(unsigned ptId) const
+  {
+    CheckPointId(ptId);
+    const MatrixTypeDoublePrecision rows = BasisRows(ptId);
+    MatrixTypeDoublePrecision       cov = rows * m_matMInverse * rows.transpose();
+    cov.diagonal().array() += m_noiseVariance;
+    return cov.cast<ScalarType>();
+  }
+
+  /**
+   * \brief Compute the posterior model for the current landmarks
+   * \param computeScores determines whether the scores are computed and stored in the model
+   *
+   * This is the only operation whose cost depends on the number of points of the model.
+   */
+  UniquePtrType<StatisticalModelType>
+  BuildPosteriorModel(bool computeScores = true) const
+  {
+    auto posteriorModel =
+      details::CreatePosteriorModel(m_priorModel, m_coefficients, m_matMInverse, m_noiseVariance, computeScores);
+
+    typename ModelInfo::BuilderInfoList builderInfoList = posteriorModel->GetModelInfo().GetBuilderInfoList();
+
+    BuilderInfo::ParameterInfoList bi;
+    bi.emplace_back("NoiseVariance ", std::to_string(m_noiseVariance));
+
+    BuilderInfo::DataInfoList di;
+    for (const auto & item : m_landmarks)
+    {
+      std::ostringstream valueSStream;
+      valueSStream << "(" << item.second.pointId << ", (";
+      for (unsigned d = 0; d < m_dim; d++)
+      {
+        valueSStream << item.second.value[d] << (d + 1 < m_dim ? "," : "");
+      }
+      valueSStream << "))";
+      di.emplace_back("Point constraint " + std::to_string(item.first), valueSStream.str());
+    }
+    builderInfoList.emplace_back("IncrementalPosteriorModel", di, bi);
+
+    posteriorModel->SetModelInfo(ModelInfo{ posteriorModel->GetModelInfo().GetScoresMatrix(), builderInfoList });
+
+    return posteriorModel;
+  }
+
+private:
+  // number of Woodbury updates after which the inverse is recomputed from the information matrix
+  static constexpr unsigned sk_maxNumberOfUpdates = 64;
+
+  struct Landmark
+  {
+    unsigned                  pointId;
+    VectorType                value;
+    MatrixTypeDoublePrecision covariance;
+    MatrixTypeDoublePrecision precision;
+  };
+
+  explicit IncrementalPosteriorModel(const StatisticalModelType * priorModel)
+    : m_priorModel{ priorModel }
+    , m_dim{ priorModel->GetRepresenter()->GetDimensions() }
+    // this only makes sense for a proper PPCA model, as in PosteriorModelBuilder
+    , m_noiseVariance{ std::max(static_cast<double>(priorModel->GetNoiseVariance()),
+                                ModelBuilder<T>::sk_tolerance) }
+  {
+    Reset();
+  }
+
+  MatrixTypeDoublePrecision
+  BasisRows(unsigned ptId) const
+  {
+    return m_priorModel->GetJacobian(ptId).template cast<double>();
+  }
+
+  VectorType
+  PriorMeanAtPoint(unsigned ptId) const
+  {
+    return m_priorModel->GetRepresenter()->PointSampleToPointSampleVector(m_priorModel->DrawMeanAtPoint(ptId));
+  }
+
+  void
+  CheckPointId(unsigned ptId) const
+  {
+    if (ptId >= m_priorModel->GetDomain().GetNumberOfPoints())
+    {
+      throw StatisticalModelException("Invalid point id", Status::OUT_OF_RANGE_ERROR);
+    }
+  }
+
+  // M^-1 <- M^-1 + sign * M^-1 Q_i^T S^-1 Q_i M^-1
+  void
+  Update(const MatrixTypeDoublePrecision & rows, const MatrixTypeDoublePrecision & matS, double sign)
+  {
+    if (++m_numberOfUpdates > sk_maxNumberOfUpdates)
+    {
+      // the information matrix is updated after this call
+      m_refreshPending = true;
+    }
+
+    const MatrixTypeDoublePrecision matK = m_matMInverse * rows.transpose();
+    m_matMInverse.noalias() += sign * matK * matS.ldlt().solve(matK.transpose());
+  }
+
+  void
+  UpdateCoefficients()
+  {
+    if (m_refreshPending)
+    {
+      m_matMInverse = m_matM.ldlt().solve(MatrixTypeDoublePrecision::Identity(m_matM.rows(), m_matM.cols()));
+      m_numberOfUpdates = 0;
+      m_refreshPending = false;
+    }
+    m_coefficients = (m_matMInverse * m_rhs).cast<ScalarType>();
+  }
+
+  void
+  Reset()
+  {
+    auto k = m_priorModel->GetNumberOfPrincipalComponents();
+    m_matM = MatrixTypeDoublePrecision::Identity(k, k);
+    m_matMInverse = MatrixTypeDoublePrecision::Identity(k, k);
+    m_rhs = VectorTypeDoublePrecision::Zero(k);
+    m_coefficients = VectorType::Zero(k);
+    m_numberOfUpdates = 0;
+    m_refreshPending = false;
+  }
+
+  const StatisticalModelType *       m_priorModel;
+  unsigned                           m_dim;
+  double                             m_noiseVariance;
+  std::map<LandmarkIdType, Landmark> m_landmarks;
+  LandmarkIdType                     m_nextLandmarkId{ 0 };
+  MatrixTypeDoublePrecision          m_matM;
+  MatrixTypeDoublePrecision          m_matMInverse;
+  VectorTypeDoublePrecision          m_rhs;
+  VectorType                         m_coefficients;
+  unsigned                           m_numberOfUpdates{ 0 };
+  bool                               m_refreshPending{ false };
+};
+
+} // namespace statismo
+
+#endif
@@ -45,8 +45,11 @@
 #include "statismo/core/Hash.h"
 #include "statismo/core/SafeContainer.h"
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
 namespace statismo
 {
@@ -86,7 +89,52 @@ public:
     return m_lhs->GetKernelInfo() + " + " + m_rhs->GetKernelInfo();
   }
 
+  double
+  GetSupportRadius() const override
+  {
+    return std::max(m_lhs->GetSupportRadius(), m_rhs->GetSupportRadius());
+  }
+
+  void
+  EvaluateAtDomainPoints(const TPoint &         x,
+                         unsigned               xId,
+                         const TPoint &         y,
+                         unsigned               yId,
+                         Eigen::Ref<MatrixType> res) const override
+  {
+    m_lhs->EvaluateAtDomainPoints(x, xId, y, yId, res);
+
+    // the usual kernel dimensions fit in a buffer on the stack
+    auto dim = this->GetDimension();
+    if (dim <= sk_maxStackDimension)
+    {
+      StackMatrixType tmp(dim, dim);
+      m_rhs->EvaluateAtDomainPoints(x, xId, y, yId, tmp);
+      res += tmp;
+    }
+    else
+    {
+      MatrixType tmp(dim, dim);
+      m_rhs->EvaluateAtDomainPoints(x, xId, y, yId, tmp);
+      res += tmp;
+    }
+  }
+
+  bool
+  AcceptsPointIdsOf(const Domain<TPoint> & domain) const override
+  {
+    return m_lhs->AcceptsPointIdsOf(domain) && m_rhs->AcceptsPointIdsOf(domain);
+  }
+
 private:
+  static constexpr unsigned sk_maxStackDimension = 3;
+  using StackMatrixType = Eigen::Matrix<ScalarType,
+                                        Eigen::Dynamic,
+                                        Eigen::Dynamic,
+                                        Eigen::RowMajor,
+                                        sk_maxStackDimension,
+                                        sk_maxStackDimension>;
+
   const MatrixValuedKernelType * m_lhs;
   const MatrixValuedKernelType * m_rhs;
 };
@@ -127,6 +175,12 @@ public:
     return m_lhs->GetKernelInfo() + " * " + m_rhs->GetKernelInfo();
   }
 
+  double
+  GetSupportRadius() const override
+  {
+    return std::min(m_lhs->GetSupportRadius(), m_rhs->GetSupportRadius());
+  }
+
 private:
   const MatrixValuedKernelType * m_lhs;
   const MatrixValuedKernelType * m_rhs;
@@ -162,6 +216,29 @@ public:
     return m_kernel->GetKernelInfo() + " * " + std::to_string(m_scalingFactor);
   }
 
+  double
+  GetSupportRadius() const override
+  {
+    return m_kernel->GetSupportRadius();
+  }
+
+  void
+  EvaluateAtDomainPoints(const TPoint &         x,
+                         unsigned               xId,
+                         const TPoint &         y,
+                         unsigned               yId,
+                         Eigen::Ref<MatrixType> res) const override
+  {
+    m_kernel->EvaluateAtDomainPoints(x, xId, y, yId, res);
+    res *= m_scalingFactor;
+  }
+
+  bool
+  AcceptsPointIdsOf(const Domain<TPoint> & domain) const override
+  {
+    return m_kernel->AcceptsPointIdsOf(domain);
+  }
+
 private:
   const MatrixValuedKernelType * m_kernel;
   double                         m_scalingFactor;
@@ -204,6 +281,12 @@ public:
     return os.str();
   }
 
+  double
+  GetSupportRadius() const override
+  {
+    return m_kernel->GetSupportRadius();
+  }
+
 private:
   const ScalarValuedKernel<TPoint> * m_kernel;
   MatrixType                         m_ident;
@@ -245,13 +328,17 @@ public:
    * \param numEigenfunctions number of eigenfunctions to be used for the approximation
    * \param numberOfPointsForApproximation number of points used for the nystrom approximation
    * \param cacheValues Cache result of eigenfunction computations. Greatly speeds up the computation.
+   * \param precomputeDomainValues Compute the eigenfunctions at all the domain points upfront. The values
+   *        are then read without any locking, which is much faster when the kernel is evaluated from
+   *        several threads. Only the other points go through the cache.
    */
   SpatiallyVaryingKernel(const RepresenterType *               representer,
                          const MatrixValuedKernel<PointType> & kernel,
                          const TemperingFunction<PointType> &  eta,
                          unsigned                              numEigenfunctions,
                          unsigned                              numberOfPointsForApproximation = 0,
-                         bool                                  cacheValues = true)
+                         bool                                  cacheValues = true,
+                         bool                                  precomputeDomainValues = false)
     : MatrixValuedKernel<PointType>(kernel.GetDimension())
     , m_representer(representer)
     , m_nystrom(Nystrom<T>::SafeCreateStd(representer,
@@ -262,19 +349,103 @@ public:
     , m_eigenvalues(m_nystrom->GetEigenvalues())
     , m_eta(eta)
     , m_doCacheValues(cacheValues)
-  {}
+  {
+    if (precomputeDomainValues)
+    {
+      PrecomputeDomainValues();
+    }
+  }
 
   inline MatrixType
   operator()(const PointType & x, const PointType & y) const
   {
+    MatrixType res(this->m_dimension, this->m_dimension);
+    Evaluate(x, y, res);
+    return res;
+  }
 
-    MatrixType sum = MatrixType::Zero(this->m_dimension, this->m_dimension);
+  void
+  Evaluate(const PointType & x, const PointType & y, Eigen::Ref<MatrixType> res) const override
+  {
+    PhiHolderType holderX;
+    PhiHolderType holderY;
+    ComputeTemperedSum(PhiAtPoint(x, holderX), PhiAtPoint(y, holderY), m_eta(x), m_eta(y), res);
+  }
 
-    auto etaX = m_eta(x);
-    auto etaY = m_eta(y);
+  /**
+   * With a precomputed table, the eigenfunctions at the domain points are read from the table rows of the ids.
+   */
+  void
+  EvaluateAtDomainPoints(const PointType &      x,
+                         unsigned               xId,
+                         const PointType &      y,
+                         unsigned               yId,
+                         Eigen::Ref<MatrixType> res) const override
+  {
+    if (m_phiTable.size() == 0)
+    {
+      Evaluate(x, y, res);
+      return;
+    }
 
-    auto phisAtX = PhiAtPoint(x);
-    auto phisAtY = PhiAtPoint(y);
+    auto dim = this->m_dimension;
+    ComputeTemperedSum(
+      m_phiTable.middleRows(xId * dim, dim), m_phiTable.middleRows(yId * dim, dim), m_eta(x), m_eta(y), res);
+  }
+
+  /**
+   * Without a precomputed table the ids are ignored. With one, they must be the ids of the domain of the representer.
+   */
+  bool
+  AcceptsPointIdsOf(const Domain<PointType> & domain) const override
+  {
+    const auto & ownDomain = m_representer->GetDomain();
+    if (m_phiTable.size() == 0 || &domain == &ownDomain)
+    {
+      return true;
+    }
+    if (domain.GetNumberOfPoints() != ownDomain.GetNumberOfPoints())
+    {
+      return false;
+    }
+
+    auto points = domain.GetDomainPoints();
+    auto ownPoints = ownDomain.GetDomainPoints();
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+      if (m_representer->PointToVector(points[i]) != m_representer->PointToVector(ownPoints[i]))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  virtual ~SpatiallyVaryingKernel() = default;
+
+  std::string
+  GetKernelInfo() const
+  {
+    return "SpatiallyVaryingKernel";
+  }
+
+private:
+  using PhiHolderType = std::shared_ptr<const statismo::MatrixType>;
+  using PhiRefType = Eigen::Ref<const statismo::MatrixType>;
+  using CacheType = SafeShardedUnorderedMap<statismo::VectorType, PhiHolderType, Hash<statismo::VectorType>>;
+  using PointIdMapType = std::unordered_map<statismo::VectorType, unsigned, Hash<statismo::VectorType>>;
+
+  // number of domain points whose eigenfunctions are computed at once
+  static constexpr std::size_t sk_precomputeTileSize = 256;
+
+  void
+  ComputeTemperedSum(const PhiRefType &     phisAtX,
+                     const PhiRefType &     phisAtY,
+                     double                 etaX,
+                     double                 etaY,
+                     Eigen::Ref<MatrixType> res) const
+  {
+    res.setZero();
 
     double largestTemperedEigenvalue = std::pow(m_eigenvalues(0), (etaX + etaY) / 2);
 
@@ -290,47 +461,68 @@ public:
       }
       else
       {
-        sum += phisAtX.col(i) * phisAtY.col(i).transpose() * temperedEigenvalue;
+        res.noalias() += phisAtX.col(i) * phisAtY.col(i).transpose() * temperedEigenvalue;
       }
     }
     // normalize such that the largest eigenvalue is unaffected by the tempering
     double normalizationFactor = largestTemperedEigenvalue / m_eigenvalues(0);
-    sum *= 1.0 / normalizationFactor;
-    return sum;
+    res *= 1.0 / normalizationFactor;
   }
 
-  virtual ~SpatiallyVaryingKernel() = default;
-
-  std::string
-  GetKernelInfo() const
-  {
-    return "SpatiallyVaryingKernel";
-  }
-
-private:
-  using CacheType = SafeUnorderedMap<statismo::VectorType, statismo::MatrixType, Hash<statismo::VectorType>>;
-
   // returns a d x n matrix holding the value of all n eigenfunctions evaluated at the given point.
-  statismo::MatrixType
-  PhiAtPoint(const PointType & pt) const
+  // When the value is not taken from the table, it is owned by the holder.
+  PhiRefType
+  PhiAtPoint(const PointType & pt, PhiHolderType & holder) const
   {
-    statismo::MatrixType v;
-    if (m_doCacheValues)
+    if (m_phiTable.size() != 0 || m_doCacheValues)
     {
       // we need to convert the point to a vector, as the function hash_value (required by boost)
       // is not defined for an arbitrary point.
       auto ptAsVec = this->m_representer->PointToVector(pt);
-      if (!m_phiCache.Find(ptAsVec, v))
+
+      // the table and the id map are never modified after the construction, no lock is needed
+      auto got = m_domainPointIds.find(ptAsVec);
+      if (got != std::cend(m_domainPointIds))
+      {
+        auto dim = this->m_dimension;
+        return m_phiTable.middleRows(got->second * dim, dim);
+      }
+
+      if (m_doCacheValues)
       {
-        v = m_nystrom->ComputeEigenfunctionsAtPoint(pt);
-        m_phiCache.Insert(std::make_pair(ptAsVec, v));
+        if (!m_phiCache.Find(ptAsVec, holder))
+        {
+          holder = std::make_shared<const statismo::MatrixType>(m_nystrom->ComputeEigenfunctionsAtPoint(pt));
+          m_phiCache.Insert(std::make_pair(ptAsVec, holder));
+        }
+        return *holder;
       }
     }
-    else
+
+    holder = std::make_shared<const statismo::MatrixType>(m_nystrom->ComputeEigenfunctionsAtPoint(pt));
+    return *holder;
+  }
+
+  void
+  PrecomputeDomainValues()
+  {
+    auto domainPoints = m_representer->GetDomain().GetDomainPoints();
+    auto numPoints = domainPoints.size();
+    auto dim = this->m_dimension;
+
+    // one (numPoints * d) x n table, the rows of point i start at i * d
+    m_phiTable.resize(numPoints * dim, m_eigenvalues.size());
+    m_domainPointIds.reserve(numPoints);
+    for (std::size_t lowerInd = 0; lowerInd < numPoints; lowerInd += sk_precomputeTileSize)
     {
-      v = m_nystrom->ComputeEigenfunctionsAtPoint(pt);
+      auto upperInd = std::min(numPoints, lowerInd + sk_precomputeTileSize);
+      m_phiTable.middleRows(lowerInd * dim, (upperInd - lowerInd) * dim) =
+        m_nystrom->ComputeEigenfunctionsAtPoints(domainPoints, lowerInd, upperInd);
+      for (auto i = lowerInd; i < upperInd; ++i)
+      {
+        m_domainPointIds.emplace(m_representer->PointToVector(domainPoints[i]), static_cast<unsigned>(i));
+      }
     }
-    return v;
   }
 
   const RepresenterType *              m_representer;
@@ -339,6 +531,8 @@ private:
   const TemperingFunction<PointType> & m_eta;
   bool                                 m_doCacheValues;
   mutable CacheType                    m_phiCache;
+  statismo::MatrixType                 m_phiTable;
+  PointIdMapType                       m_domainPointIds;
 };
 
 
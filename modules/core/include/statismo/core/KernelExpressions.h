@@ -0,0 +1,438 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __STATIMO_CORE_KERNEL_EXPRESSIONS_H_
+#define __STATIMO_CORE_KERNEL_EXPRESSIONS_H_
+
+#include "statismo/core/CommonTypes.h"
+#include "statismo/core/Exceptions.h"
+#include "statismo/core/Kernels.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+/**
+ * \defgroup KernelExpressions Compile-time kernel expressions
+ * \ingroup Kernels
+ *
+ * The kernel combinators (SumKernel, ProductKernel, ...) compose kernels at runtime: every level
+ * is a virtual call that returns a dynamically allocated matrix. Kernel expressions compose the
+ * kernels at compile-time instead. The results are fixed-size d x d matrices and the whole
+ * expression is inlined, e.g.
+ *
+ * \code
+ * auto expr = 2.0 * MakeUncorrelatedKernelExpression<3>(gaussianKernel) + MakeUncorrelatedKernelExpression<3>(bspline);
+ * auto kernel = MakeMatrixValuedKernel(expr); // usable wherever a MatrixValuedKernel is expected
+ * \endcode
+ */
+
+namespace statismo
+{
+
+/**
+ * \brief Base class of the kernel expressions
+ * \tparam Derived concrete expression type
+ * \tparam TPoint point type
+ * \tparam Dim dimension of the kernel (i.e. the size of the matrix)
+ * \ingroup KernelExpressions
+ */
+template <typename Derived, typename TPoint, unsigned Dim>
+class KernelExpression
+{
+public:
+  using PointType = TPoint;
+  using ResultType = Eigen::Matrix<ScalarType, Dim, Dim>;
+  static constexpr unsigned sk_dimension = Dim;
+
+  ResultType
+  operator()(const TPoint & x, const TPoint & y) const
+  {
+    return Self().Evaluate(x, y);
+  }
+
+  const Derived &
+  Self() const
+  {
+    return static_cast<const Derived &>(*this);
+  }
+};
+
+namespace details
+{
+template <typename Derived, typename TPoint, unsigned Dim>
+std::true_type
+IsKernelExpressionImpl(const KernelExpression<Derived, TPoint, Dim> *);
+std::false_type
+IsKernelExpressionImpl(...);
+
+template <typename T>
+inline constexpr bool gk_isKernelExpression = decltype(IsKernelExpressionImpl(std::declval<const T *>()))::value;
+
+template <typename TPoint>
+TPoint
+ScalarKernelPointTypeImpl(const ScalarValuedKernel<TPoint> *);
+
+template <typename TScalarKernel>
+using ScalarKernelPointType = decltype(ScalarKernelPointTypeImpl(std::declval<const TScalarKernel *>()));
+} // namespace details
+
+/**
+ * \brief Expression turning a scalar kernel k into the matrix valued kernel Id*k
+ *
+ * The scalar kernel is called through its concrete type. If this type is final,
+ * the call is not virtual and the kernel evaluation is inlined.
+ *
+ * \ingroup KernelExpressions
+ */
+template <typename TScalarKernel, typename TPoint, unsigned Dim>
+class UncorrelatedKernelExpression
+  : public KernelExpression<UncorrelatedKernelExpression<TScalarKernel, TPoint, Dim>, TPoint, Dim>
+{
+public:
+  using Superclass = KernelExpression<UncorrelatedKernelExpression<TScalarKernel, TPoint, Dim>, TPoint, Dim>;
+  using ResultType = typename Superclass::ResultType;
+
+  explicit UncorrelatedKernelExpression(const TScalarKernel * kernel)
+    : m_kernel(kernel)
+  {}
+
+  ResultType
+  Evaluate(const TPoint & x, const TPoint & y) const
+  {
+    return ResultType::Identity() * static_cast<ScalarType>((*m_kernel)(x, y));
+  }
+
+  std::string
+  GetKernelInfo() const
+  {
+    return "UncorrelatedMatrixValuedKernel(" + m_kernel->GetKernelInfo() + ", " + std::to_string(Dim) + ")";
+  }
+
+  double
+  GetSupportRadius() const
+  {
+    return m_kernel->GetSupportRadius();
+  }
+
+private:
+  const TScalarKernel * m_kernel;
+};
+
+/**
+ * \brief Expression wrapping a runtime matrix valued kernel
+ * \note The wrapped kernel still returns a dynamic matrix. It allows to combine existing kernels
+ * with expressions.
+ * \ingroup KernelExpressions
+ */
+template <typename TPoint, unsigned Dim>
+class MatrixValuedKernelExpression : public KernelExpression<MatrixValuedKernelExpression<TPoint, Dim>, TPoint, Dim>
+{
+public:
+  using Superclass = KernelExpression<MatrixValuedKernelExpression<TPoint, Dim>, TPoint, Dim>;
+  using ResultType = typename Superclass::ResultType;
+
+  explicit MatrixValuedKernelExpression(const MatrixValuedKernel<TPoint> * kernel)
+    : m_kernel(kernel)
+  {
+    if (kernel->GetDimension() != Dim)
+    {
+      throw StatisticalModelException("Kernel dimension does not match the expression dimension",
+                                      Status::BAD_INPUT_ERROR);
+    }
+  }
+
+  ResultType
+  Evaluate(const TPoint & x, const TPoint & y) const
+  {
+    return (*m_kernel)(x, y);
+  }
+
+  std::string
+  GetKernelInfo() const
+  {
+    return m_kernel->GetKernelInfo();
+  }
+
+  double
+  GetSupportRadius() const
+  {
+    return m_kernel->GetSupportRadius();
+  }
+
+private:
+  const MatrixValuedKernel<TPoint> * m_kernel;
+};
+
+/**
+ * \brief Sum of two kernel expressions
+ * \ingroup KernelExpressions
+ */
+template <typename TLhs, typename TRhs>
+class SumKernelExpression
+  : public KernelExpression<SumKernelExpression<TLhs, TRhs>, typename TLhs::PointType, TLhs::sk_dimension>
+{
+public:
+  using Superclass = KernelExpression<SumKernelExpression<TLhs, TRhs>, typename TLhs::PointType, TLhs::sk_dimension>;
+  using PointType = typename Superclass::PointType;
+  using ResultType = typename Superclass::ResultType;
+
+  static_assert(TLhs::sk_dimension == TRhs::sk_dimension, "Kernels in a sum must have the same dimensionality");
+
+  SumKernelExpression(const TLhs & lhs, const TRhs & rhs)
+    : m_lhs(lhs)
+    , m_rhs(rhs)
+  {}
+
+  ResultType
+  Evaluate(const PointType & x, const PointType & y) const
+  {
+    return m_lhs.Evaluate(x, y) + m_rhs.Evaluate(x, y);
+  }
+
+  std::string
+  GetKernelInfo() const
+  {
+    return m_lhs.GetKernelInfo() + " + " + m_rhs.GetKernelInfo();
+  }
+
+  double
+  GetSupportRadius() const
+  {
+    return std::max(m_lhs.GetSupportRadius(), m_rhs.GetSupportRadius());
+  }
+
+private:
+  TLhs m_lhs;
+  TRhs m_rhs;
+};
+
+/**
+ * \brief Product of two kernel expressions
+ * \ingroup KernelExpressions
+ */
+template <typename TLhs, typename TRhs>
+class ProductKernelExpression
+  : public KernelExpression<ProductKernelExpression<TLhs, TRhs>, typename TLhs::PointType, TLhs::sk_dimension>
+{
+public:
+  using Superclass =
+    KernelExpression<ProductKernelExpression<TLhs, TRhs>, typename TLhs::PointType, TLhs::sk_dimension>;
+  using PointType = typename Superclass::PointType;
+  using ResultType = typename Superclass::ResultType;
+
+  static_assert(TLhs::sk_dimension == TRhs::sk_dimension, "Kernels in a product must have the same dimensionality");
+
+  ProductKernelExpression(const TLhs & lhs, const TRhs & rhs)
+    : m_lhs(lhs)
+    , m_rhs(rhs)
+  {}
+
+  ResultType
+  Evaluate(const PointType & x, const PointType & y) const
+  {
+    return m_lhs.Evaluate(x, y) * m_rhs.Evaluate(x, y);
+  }
+
+  std::string
+  GetKernelInfo() const
+  {
+    return m_lhs.GetKernelInfo() + " * " + m_rhs.GetKernelInfo();
+  }
+
+  double
+  GetSupportRadius() const
+  {
+    return std::min(m_lhs.GetSupportRadius(), m_rhs.GetSupportRadius());
+  }
+
+private:
+  TLhs m_lhs;
+  TRhs m_rhs;
+};
+
+/**
+ * \brief Scalar multiple of a kernel expression
+ * \ingroup KernelExpressions
+ */
+template <typename TExpr>
+class ScaledKernelExpression
+  : public KernelExpression<ScaledKernelExpression<TExpr>, typename TExpr::PointType, TExpr::sk_dimension>
+{
+public:
+  using Superclass = KernelExpression<ScaledKernelExpression<TExpr>, typename TExpr::PointType, TExpr::sk_dimension>;
+  using PointType = typename Superclass::PointType;
+  using ResultType = typename Superclass::ResultType;
+
+  ScaledKernelExpression(const TExpr & expr, double scalingFactor)
+    : m_expr(expr)
+    , m_scalingFactor(scalingFactor)
+  {}
+
+  ResultType
+  Evaluate(const PointType & x, const PointType & y) const
+  {
+    return m_expr.Evaluate(x, y) * static_cast<ScalarType>(m_scalingFactor);
+  }
+
+  std::string
+  GetKernelInfo() const
+  {
+    return m_expr.GetKernelInfo() + " * " + std::to_string(m_scalingFactor);
+  }
+
+  double
+  GetSupportRadius() const
+  {
+    return m_expr.GetSupportRadius();
+  }
+
+private:
+  TExpr  m_expr;
+  double m_scalingFactor;
+};
+
+/**
+ * \brief Type-erased kernel expression, usable wherever a MatrixValuedKernel is expected
+ * \ingroup KernelExpressions
+ */
+template <typename TExpr>
+class KernelExpressionAdapter : public MatrixValuedKernel<typename TExpr::PointType>
+{
+public:
+  using PointType = typename TExpr::PointType;
+
+  explicit KernelExpressionAdapter(const TExpr & expr)
+    : MatrixValuedKernel<PointType>(TExpr::sk_dimension)
+    , m_expr(expr)
+  {}
+
+  MatrixType
+  operator()(const PointType & x, const PointType & y) const override
+  {
+    return m_expr.Evaluate(x, y);
+  }
+
+  void
+  Evaluate(const PointType & x, const PointType & y, Eigen::Ref<MatrixType> res) const override
+  {
+    res = m_expr.Evaluate(x, y);
+  }
+
+  std::string
+  GetKernelInfo() const override
+  {
+    return m_expr.GetKernelInfo();
+  }
+
+  double
+  GetSupportRadius() const override
+  {
+    return m_expr.GetSupportRadius();
+  }
+
+private:
+  TExpr m_expr;
+};
+
+/**
+ * \brief Create the expression Id*kernel of dimension \a Dim from a scalar kernel
+ * \ingroup KernelExpressions
+ */
+template <unsigned Dim, typename TScalarKernel>
+auto
+MakeUncorrelatedKernelExpression(const TScalarKernel & kernel)
+{
+  return UncorrelatedKernelExpression<TScalarKernel, details::ScalarKernelPointType<TScalarKernel>, Dim>(&kernel);
+}
+
+/**
+ * \brief Create an expression from a runtime matrix valued kernel of dimension \a Dim
+ * \ingroup KernelExpressions
+ */
+template <unsigned Dim, typename TPoint>
+auto
+MakeKernelExpression(const MatrixValuedKernel<TPoint> & kernel)
+{
+  return MatrixValuedKernelExpression<TPoint, Dim>(&kernel);
+}
+
+/**
+ * \brief Type-erase a kernel expression into a MatrixValuedKernel
+ * \ingroup KernelExpressions
+ */
+template <typename TExpr, typename = std::enable_if_t<details::gk_isKernelExpression<TExpr>>>
+std::unique_ptr<MatrixValuedKernel<typename TExpr::PointType>>
+MakeMatrixValuedKernel(const TExpr & expr)
+{
+  return std::make_unique<KernelExpressionAdapter<TExpr>>(expr);
+}
+
+template <typename TLhs,
+          typename TRhs,
+          typename = std::enable_if_t<details::gk_isKernelExpression<TLhs> && details::gk_isKernelExpression<TRhs>>>
+auto
+operator+(const TLhs & lhs, const TRhs & rhs)
+{
+  return SumKernelExpression<TLhs, TRhs>(lhs, rhs);
+}
+
+template <typename TLhs,
+          typename TRhs,
+          typename = std::enable_if_t<details::gk_isKernelExpression<TLhs> && details::gk_isKernelExpression<TRhs>>>
+auto
+operator*(const TLhs & lhs, const TRhs & rhs)
+{
+  return ProductKernelExpression<TLhs, TRhs>(lhs, rhs);
+}
+
+template <typename TExpr, typename = std::enable_if_t<details::gk_isKernelExpression<TExpr>>>
+auto
+operator*(const TExpr & expr, double scalingFactor)
+{
+  return ScaledKernelExpression<TExpr>(expr, scalingFactor);
+}
+
+template <typename TExpr, typename = std::enable_if_t<details::gk_isKernelExpression<TExpr>>>
+auto
+operator*(double scalingFactor, const TExpr & expr)
+{
+  return ScaledKernelExpression<TExpr>(expr, scalingFactor);
+}
+
+} // namespace statismo
+
+#endif
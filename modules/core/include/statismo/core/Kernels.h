@@ -45,6 +45,7 @@
 #include "statismo/core/StatisticalModel.h"
 
 #include <cmath>
+#include <limits>
 #include <vector>
 #include <memory>
 #include <functional>
@@ -79,6 +80,18 @@ public:
    */
   virtual std::string
   GetKernelInfo() const = 0;
+
+  /**
+   * \brief Return the support radius of the kernel
+   *
+   * Compactly supported kernels return the distance beyond which the kernel is zero. It
+   * allows to assemble sparse kernel matrices. The default is an infinite support.
+   */
+  virtual double
+  GetSupportRadius() const
+  {
+    return std::numeric_limits<double>::infinity();
+  }
 };
 
 
@@ -103,6 +116,43 @@ public:
   virtual MatrixType
   operator()(const TPoint & x, const TPoint & y) const = 0;
 
+  /**
+   * \brief Evaluate the kernel at the points x and y and write the d x d result into \a res
+   *
+   * Kernels that can compute their value without allocating a temporary matrix override this method.
+   */
+  virtual void
+  Evaluate(const TPoint & x, const TPoint & y, Eigen::Ref<MatrixType> res) const
+  {
+    res = (*this)(x, y);
+  }
+
+  /**
+   * \brief Evaluate the kernel at the points x and y of a domain, whose ids are \a xId and \a yId
+   *
+   * Kernels that are defined on the points of a domain (e.g. a StatisticalModelKernel) override this
+   * method and use the ids, which avoids looking up the points. The others simply ignore the ids.
+   * \warning Only valid for a domain for which AcceptsPointIdsOf returned true
+   */
+  virtual void
+  EvaluateAtDomainPoints(const TPoint &           x,
+                         [[maybe_unused]] unsigned xId,
+                         const TPoint &           y,
+                         [[maybe_unused]] unsigned yId,
+                         Eigen::Ref<MatrixType>   res) const
+  {
+    Evaluate(x, y, res);
+  }
+
+  /**
+   * \brief Return true if EvaluateAtDomainPoints can be called with the point ids of \a domain
+   */
+  virtual bool
+  AcceptsPointIdsOf([[maybe_unused]] const Domain<TPoint> & domain) const
+  {
+    return true;
+  }
+
   /**
    * \brief Return the dimensionality of the kernel (i.e. the size of the matrix)
    */
@@ -120,6 +170,16 @@ public:
   virtual std::string
   GetKernelInfo() const = 0;
 
+  /**
+   * \brief Return the distance beyond which the kernel is zero (infinite by default)
+   * \sa ScalarValuedKernel::GetSupportRadius
+   */
+  virtual double
+  GetSupportRadius() const
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+
 protected:
   unsigned m_dimension;
 };
@@ -150,6 +210,45 @@ public:
     return m;
   }
 
+  void
+  EvaluateAtDomainPoints(const PointType &,
+                         unsigned               xId,
+                         const PointType &,
+                         unsigned               yId,
+                         Eigen::Ref<MatrixType> res) const override
+  {
+    m_statisticalModel->ComputeCovarianceAtPoint(xId, yId, res);
+  }
+
+  /**
+   * The point ids are accepted if the domain has the same points as the domain of the model.
+   */
+  bool
+  AcceptsPointIdsOf(const Domain<PointType> & domain) const override
+  {
+    const auto & modelDomain = m_statisticalModel->GetDomain();
+    if (&domain == &modelDomain)
+    {
+      return true;
+    }
+    if (domain.GetNumberOfPoints() != modelDomain.GetNumberOfPoints())
+    {
+      return false;
+    }
+
+    const auto * representer = m_statisticalModel->GetRepresenter();
+    auto         points = domain.GetDomainPoints();
+    auto         modelPoints = modelDomain.GetDomainPoints();
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+      if (representer->PointToVector(points[i]) != representer->PointToVector(modelPoints[i]))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
   std::string
   GetKernelInfo() const override
   {
@@ -0,0 +1,314 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __STATIMO_CORE_KRONECKER_GP_MODEL_BUILDER_H_
+#define __STATIMO_CORE_KRONECKER_GP_MODEL_BUILDER_H_
+
+#include "statismo/core/CommonTypes.h"
+#include "statismo/core/Config.h"
+#include "statismo/core/Exceptions.h"
+#include "statismo/core/Kernels.h"
+#include "statismo/core/ModelInfo.h"
+#include "statismo/core/ModelBuilder.h"
+#include "statismo/core/Representer.h"
+#include "statismo/core/StatisticalModel.h"
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace statismo
+{
+
+/**
+ * \brief A model builder for Gaussian process models defined on a regular grid
+ *
+ * This builder is a specialization of the LowRankGPModelBuilder for representers whose
+ * domain is a regular grid (e.g. images) and kernels that are separable along the axes of the grid,
+ * i.e. \f$k(x, y) = \prod_d k_d(x_d, y_d)\f$ (Gaussian, B-spline, ...).
+ *
+ * The kernel matrix on the grid is then the Kronecker product of the small per-axis kernel matrices.
+ * Its eigenpairs are products of the per-axis eigenpairs, which are computed exactly. No Nystrom
+ * approximation is involved and the cost is dominated by writing the basis matrix.
+ *
+ * The resulting model uses the matrix-valued kernel \f$k(x, y) I_d\f$, where \f$d\f$ is
+ * the dimension of the representer.
+ *
+ * The grid is given by the coordinates of the grid points along each axis. The points of the
+ * representer domain are expected in the usual image order, i.e. the first axis varies fastest.
+ *
+ * \ingroup ModelBuilders
+ * \ingroup Core
+ */
+template <typename T>
+class KroneckerGPModelBuilder : public ModelBuilderBase<T, KroneckerGPModelBuilder<T>>
+{
+public:
+  using Superclass = ModelBuilderBase<T, KroneckerGPModelBuilder<T>>;
+  using ObjectFactoryType = typename Superclass::ObjectFactoryType;
+  using RepresenterType = typename Superclass::RepresenterType;
+  using StatisticalModelType = typename Superclass::StatisticalModelType;
+  using AxisKernelType = ScalarValuedKernel<double>;
+  using AxisKernelListType = std::vector<const AxisKernelType *>;
+  using AxisCoordinatesType = std::vector<double>;
+  using GridType = std::vector<AxisCoordinatesType>;
+
+  friend ObjectFactoryType;
+
+  /**
+   * \brief Build a new model using a zero-mean Gaussian process with a separable kernel
+   * \param axisKernels one scalar kernel per grid axis
+   * \param grid coordinates of the grid points along each axis
+   * \param numComponents number of components of the model
+   * \return new statistical model representing the given Gaussian process
+   */
+  UniquePtrType<StatisticalModelType>
+  BuildNewZeroMeanModel(const AxisKernelListType & axisKernels, const GridType & grid, unsigned numComponents) const
+  {
+    return BuildNewModel(m_representer->IdentitySample(), axisKernels, grid, numComponents);
+  }
+
+  /**
+   * \brief Build a new model using a Gaussian process with given mean and separable kernel
+   * \param mean dataset that represents the mean (shape or deformation)
+   * \param axisKernels one scalar kernel per grid axis
+   * \param grid coordinates of the grid points along each axis
+   * \param numComponents number of components of the model
+   * \return new statistical model representing the given Gaussian process
+   */
+  UniquePtrType<StatisticalModelType>
+  BuildNewModel(typename RepresenterType::DatasetConstPointerType mean,
+                const AxisKernelListType &                        axisKernels,
+                const GridType &                                  grid,
+                unsigned                                          numComponents) const
+  {
+    STATISMO_LOG_INFO("Building new model");
+    STATISMO_LOG_INFO("Component count: " + std::to_string(numComponents));
+
+    if (grid.empty() || axisKernels.size() != grid.size())
+    {
+      throw StatisticalModelException("One kernel per grid axis is needed", Status::BAD_INPUT_ERROR);
+    }
+
+    std::size_t numGridPoints = 1;
+    for (const auto & axis : grid)
+    {
+      numGridPoints *= axis.size();
+    }
+
+    auto numDomainPoints = m_representer->GetDomain().GetNumberOfPoints();
+    if (numGridPoints != numDomainPoints)
+    {
+      throw StatisticalModelException("The grid does not match the domain of the representer",
+                                      Status::BAD_INPUT_ERROR);
+    }
+
+    auto dim = m_representer->GetDimensions();
+    if (numComponents == 0 || numComponents > numDomainPoints * dim)
+    {
+      throw StatisticalModelException("Invalid number of components", Status::BAD_INPUT_ERROR);
+    }
+
+    // eigendecomposition of the per-axis kernel matrices, sorted by decreasing eigenvalues
+    std::vector<MatrixTypeDoublePrecision> axisEigenvectors;
+    std::vector<VectorTypeDoublePrecision> axisEigenvalues;
+    for (std::size_t a = 0; a < grid.size(); ++a)
+    {
+      auto n = grid[a].size();
+
+      MatrixTypeDoublePrecision k(n, n);
+      for (unsigned i = 0; i < n; ++i)
+      {
+        for (unsigned j = i; j < n; ++j)
+        {
+          k(i, j) = k(j, i) = (*axisKernels[a])(grid[a][i], grid[a][j]);
+        }
+      }
+
+      Eigen::SelfAdjointEigenSolver<MatrixTypeDoublePrecision> es(k);
+      if (es.info() != Eigen::Success)
+      {
+        throw StatisticalModelException("Eigendecomposition of the axis kernel matrix failed",
+                                        Status::INVALID_DATA_ERROR);
+      }
+
+      // the solver returns the eigenvalues in increasing order
+      axisEigenvectors.emplace_back(es.eigenvectors().rowwise().reverse());
+      axisEigenvalues.emplace_back(es.eigenvalues().reverse().cwiseMax(0.0));
+    }
+
+    // every scalar eigenfunction yields dim components of the vector-valued process
+    auto numScalarComponents = (numComponents + dim - 1) / dim;
+    auto indices = SelectLargestEigenvalues(axisEigenvalues, numScalarComponents);
+
+    MatrixType pcaBasis(numDomainPoints * dim, numComponents);
+    VectorType pcaVariance(numComponents);
+    pcaBasis.setZero();
+
+    VectorTypeDoublePrecision phi(numDomainPoints);
+    for (unsigned i = 0; i < numScalarComponents; ++i)
+    {
+      // Kronecker product of the axis eigenvectors, the first axis varies fastest
+      double      lambda = 1.0;
+      std::size_t len = 1;
+      for (std::size_t a = 0; a < grid.size(); ++a)
+      {
+        const auto & u = axisEigenvectors[a];
+        auto         n = static_cast<std::size_t>(u.rows());
+        lambda *= axisEigenvalues[a](indices[i][a]);
+
+        if (a == 0)
+        {
+          phi.head(n) = u.col(indices[i][a]);
+        }
+        else
+        {
+          // expand in place, starting from the last block so that no value is overwritten before being used
+          for (std::size_t j = n; j-- > 0;)
+          {
+            phi.segment(j * len, len) = phi.head(len) * u(j, indices[i][a]);
+          }
+        }
+        len *= n;
+      }
+
+      for (unsigned d = 0; d < dim && i * dim + d < numComponents; ++d)
+      {
+        auto c = i * dim + d;
+        for (std::size_t p = 0; p < numDomainPoints; ++p)
+        {
+          pcaBasis(p * dim + d, c) = static_cast<ScalarType>(phi(p));
+        }
+        pcaVariance(c) = static_cast<ScalarType>(lambda);
+      }
+    }
+
+    auto mu = m_representer->SampleToSampleVector(mean);
+    auto model = StatisticalModelType::SafeCreate(m_representer, mu, pcaBasis, pcaVariance, 0);
+
+    // the model builder does not use any data. Hence the scores and the datainfo is emtpy
+    MatrixType                              scores; // no scores
+    typename BuilderInfo::DataInfoList      dataInfo;
+    typename BuilderInfo::ParameterInfoList bi;
+    bi.emplace_back(BuilderInfo::KeyValuePair("NoiseVariance", std::to_string(0)));
+    bi.emplace_back(BuilderInfo::KeyValuePair("KernelInfo", GetKernelInfo(axisKernels)));
+
+    // finally add meta data to the model info
+    ModelInfo::BuilderInfoList biList(1, BuilderInfo{ "KroneckerGPModelBuilder", dataInfo, bi });
+
+    model->SetModelInfo(ModelInfo{ scores, biList });
+
+    return model;
+  }
+
+private:
+  using MultiIndexType = std::vector<unsigned>;
+
+  // Enumerate the multi-indices of the n largest products of the (sorted) axis eigenvalues.
+  // As the eigenvalues decrease along each axis, the next largest product is always a
+  // neighbour (one index incremented) of an already selected one.
+  static std::vector<MultiIndexType>
+  SelectLargestEigenvalues(const std::vector<VectorTypeDoublePrecision> & axisEigenvalues, unsigned n)
+  {
+    auto product = [&](const MultiIndexType & idx) {
+      double p = 1.0;
+      for (std::size_t a = 0; a < idx.size(); ++a)
+      {
+        p *= axisEigenvalues[a](idx[a]);
+      }
+      return p;
+    };
+
+    std::vector<MultiIndexType>                            selected;
+    std::priority_queue<std::pair<double, MultiIndexType>> candidates;
+    std::set<MultiIndexType>                               visited;
+
+    MultiIndexType first(axisEigenvalues.size(), 0);
+    candidates.emplace(product(first), first);
+    visited.insert(first);
+
+    while (selected.size() < n && !candidates.empty())
+    {
+      auto idx = candidates.top().second;
+      candidates.pop();
+      selected.push_back(idx);
+
+      for (std::size_t a = 0; a < idx.size(); ++a)
+      {
+        if (idx[a] + 1 < axisEigenvalues[a].size())
+        {
+          auto next = idx;
+          ++next[a];
+          if (visited.insert(next).second)
+          {
+            candidates.emplace(product(next), next);
+          }
+        }
+      }
+    }
+
+    return selected;
+  }
+
+  static std::string
+  GetKernelInfo(const AxisKernelListType & axisKernels)
+  {
+    std::ostringstream os;
+    os << "KroneckerProduct(";
+    for (std::size_t a = 0; a < axisKernels.size(); ++a)
+    {
+      os << (a > 0 ? ", " : "") << axisKernels[a]->GetKernelInfo();
+    }
+    os << ")";
+    return os.str();
+  }
+
+  KroneckerGPModelBuilder(const RepresenterType * representer)
+    : m_representer(representer)
+  {
+    this->SetLogger(m_representer->GetLogger());
+  }
+
+  const RepresenterType * m_representer;
+};
+
+} // namespace statismo
+
+#endif
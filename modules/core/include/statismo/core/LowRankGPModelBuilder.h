@@ -37,9 +37,12 @@
 #ifndef __STATIMO_CORE_LOW_RANK_GP_MODEL_BUILDER_H_
 #define __STATIMO_CORE_LOW_RANK_GP_MODEL_BUILDER_H_
 
+#include "statismo/core/BuildCheckpoint.h"
 #include "statismo/core/CommonTypes.h"
 #include "statismo/core/Config.h"
 #include "statismo/core/DataManager.h"
+#include "statismo/core/Exceptions.h"
+#include "statismo/core/Hash.h"
 #include "statismo/core/Kernels.h"
 #include "statismo/core/ModelInfo.h"
 #include "statismo/core/ModelBuilder.h"
@@ -48,43 +51,45 @@
 #include "statismo/core/StatisticalModel.h"
 #include "statismo/core/ThreadPool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <exception>
+#include <limits>
 #include <vector>
 #include <future>
-#include <thread>
+#include <mutex>
 #include <memory>
+#include <string>
+#include <utility>
 
 namespace statismo
 {
 
 /**
- * \brief This struct holds the result of the eigenfunction computation
+ * \brief Targets and limits of an adaptive-rank build of LowRankGPModelBuilder
+ *
+ * The build stops as soon as one of the two targets is reached.
+ *
  * \ingroup ModelBuilders
  * \ingroup Core
  */
-struct EigenfunctionComputationResult
+struct AdaptiveRankParameters
 {
-
-  /**
-   * \brief Ctor
-   * \param l lower index
-   * \param u upper index
-   * \param resMat result matrix
-   */
-  EigenfunctionComputationResult(unsigned l, unsigned u, const MatrixType & resMat)
-    : lowerInd(l)
-    , upperInd(u)
-    , resultForPoints(resMat)
-  {}
-
-  EigenfunctionComputationResult() = default;
-
-  unsigned   lowerInd{ 0 };
-  unsigned   upperInd{ 0 };
-  MatrixType resultForPoints;
+  /** Fraction of the total variance of the process retained by the model */
+  double   retainedVariance{ 0.99 };
+  /** Bound on the estimated variance that is not retained by the model (0 disables this target) */
+  double   traceError{ 0 };
+  /** Number of components computed by the first approximation */
+  unsigned initialNumComponents{ 10 };
+  /** Largest number of components of the model */
+  unsigned maxNumComponents{ 500 };
+  /** Number of points used by the first approximation */
+  unsigned initialNumPointsForNystrom{ 100 };
+  /** Largest number of points used for the approximation */
+  unsigned maxNumPointsForNystrom{ 2000 };
 };
 
-
 /**
  * \brief A model builder for building statistical models that are specified
  * by an arbitrary Gaussian Process.
@@ -141,60 +146,474 @@ public:
   {
     STATISMO_LOG_INFO("Building new model");
     STATISMO_LOG_INFO("Component count: " + std::to_string(numComponents));
-    auto domainPoints = m_representer->GetDomain().GetDomainPoints();
+
+    auto progress = this->CreateProgressReporter();
+    progress.Report(sk_nystromStage, 0, 1);
+
+    auto buildKey = ComputeBuildKey(kernel,
+                                    "numComponents=" + std::to_string(numComponents) +
+                                      ";numPointsForNystrom=" + std::to_string(numPointsForNystrom));
+    auto nystrom = RestoreNystrom(kernel, buildKey);
+    if (!nystrom)
+    {
+      nystrom = Nystrom<T>::SafeCreateStd(m_representer, kernel, numComponents, numPointsForNystrom);
+      SaveNystrom(*nystrom);
+    }
+    progress.Report(sk_nystromStage, 1, 1);
+
+    typename BuilderInfo::ParameterInfoList bi;
+    bi.emplace_back(BuilderInfo::KeyValuePair("NoiseVariance", std::to_string(0)));
+    bi.emplace_back(BuilderInfo::KeyValuePair("KernelInfo", kernel.GetKernelInfo()));
+
+    return BuildModelFromNystrom(mean, *nystrom, bi, progress);
+  }
+
+  /**
+   * \brief Build a new model using a zero-mean Gaussian process with given kernel, where the
+   * number of components and of Nystrom points are chosen adaptively (see BuildNewModelToTargetVariance)
+   */
+  UniquePtrType<StatisticalModelType>
+  BuildNewZeroMeanModelToTargetVariance(const MatrixValuedKernelType &  kernel,
+                                        const AdaptiveRankParameters & params) const
+  {
+    return BuildNewModelToTargetVariance(m_representer->IdentitySample(), kernel, params);
+  }
+
+  /**
+   * \brief Build a new model using a Gaussian process with given mean and kernel, where the
+   * number of components and of Nystrom points are chosen adaptively
+   *
+   * The build starts with a small Nystrom approximation and grows its rank and its point set
+   * until the model retains the target variance of the process and the number of Nystrom points
+   * is large enough for the selected rank, or until the limits given in \a params are reached.
+   * The kernel blocks already evaluated are kept when points are added.
+   * \param mean dataset that represents the mean (shape or deformation)
+   * \param kernel kernel (or covariance) function (see \ref Kernels)
+   * \param params targets and limits of the build
+   * \return new statistical model representing the given Gaussian process
+   */
+  UniquePtrType<StatisticalModelType>
+  BuildNewModelToTargetVariance(typename RepresenterType::DatasetConstPointerType mean,
+                                const MatrixValuedKernelType &                    kernel,
+                                const AdaptiveRankParameters &                    params) const
+  {
+    if (params.retainedVariance <= 0 || params.retainedVariance > 1 || params.traceError < 0)
+    {
+      throw StatisticalModelException("Invalid variance target", Status::BAD_INPUT_ERROR);
+    }
+    if (params.initialNumComponents == 0 || params.initialNumPointsForNystrom == 0)
+    {
+      throw StatisticalModelException("Initial number of components and of Nystrom points must be positive",
+                                      Status::BAD_INPUT_ERROR);
+    }
+
+    STATISMO_LOG_INFO("Building new model to retained variance " + std::to_string(params.retainedVariance));
+
+    auto buildKey = ComputeBuildKey(kernel,
+                                    "retainedVariance=" + std::to_string(params.retainedVariance) +
+                                      ";traceError=" + std::to_string(params.traceError) +
+                                      ";initialNumComponents=" + std::to_string(params.initialNumComponents) +
+                                      ";maxNumComponents=" + std::to_string(params.maxNumComponents) +
+                                      ";initialNumPointsForNystrom=" +
+                                      std::to_string(params.initialNumPointsForNystrom) +
+                                      ";maxNumPointsForNystrom=" + std::to_string(params.maxNumPointsForNystrom));
+    auto progress = this->CreateProgressReporter();
+    auto nystrom = RestoreNystrom(kernel, buildKey);
+    if (!nystrom)
+    {
+      nystrom = BuildAdaptiveNystrom(kernel, params, progress);
+      SaveNystrom(*nystrom);
+    }
+
+    auto numPoints = nystrom->GetNumberOfNystromPoints();
+    STATISMO_LOG_INFO("Component count: " + std::to_string(nystrom->GetEigenvalues().size()));
+    STATISMO_LOG_INFO("Nystrom point count: " + std::to_string(numPoints));
+
+    auto retainedVariance = nystrom->GetEigenvalues().sum() / nystrom->GetTotalVariance();
+
+    typename BuilderInfo::ParameterInfoList bi;
+    bi.emplace_back(BuilderInfo::KeyValuePair("NoiseVariance", std::to_string(0)));
+    bi.emplace_back(BuilderInfo::KeyValuePair("KernelInfo", kernel.GetKernelInfo()));
+    bi.emplace_back(BuilderInfo::KeyValuePair("NumberOfPointsForNystrom", std::to_string(numPoints)));
+    bi.emplace_back(BuilderInfo::KeyValuePair("EstimatedRetainedVariance", std::to_string(retainedVariance)));
+
+    return BuildModelFromNystrom(mean, *nystrom, bi, progress);
+  }
+
+  /**
+   * \brief Set the thread pool used to compute the model
+   *
+   * The pool can be shared between several builders, so that concurrent builds do not
+   * oversubscribe the machine. If no pool is set, the builder creates its own one at
+   * the first build and reuses it for the following ones.
+   */
+  void
+  SetThreadPool(SharedPtrType<ThreadPool> pool)
+  {
+    std::lock_guard<std::mutex> lock{ m_poolMutex };
+    m_pool = std::move(pool);
+  }
+
+  /**
+   * \brief Set the checkpoint in which the intermediate results of the builds are stored
+   *
+   * The Nystrom approximation and the tiles of the basis are stored, so that an interrupted
+   * build resumes from them when it is run again with the same checkpoint file.
+   * \param checkpoint checkpoint (nullptr disables checkpointing)
+   */
+  void
+  SetCheckpoint(SharedPtrType<BuildCheckpoint> checkpoint)
+  {
+    m_checkpoint = std::move(checkpoint);
+  }
+
+  /**
+   * \brief Set the number of threads of the pool created by the builder
+   * \param numThreads number of threads (0 means one per hardware thread)
+   * \note This replaces any pool previously set with SetThreadPool
+   */
+  void
+  SetNumberOfThreads(unsigned numThreads)
+  {
+    std::lock_guard<std::mutex> lock{ m_poolMutex };
+    m_numThreads = numThreads;
+    m_pool.reset();
+  }
+
+  /**
+   * \brief Set the number of domain points computed by one task
+   * \param tileSize number of points (0 means it is derived from the kernel size)
+   */
+  void
+  SetTileSize(unsigned tileSize)
+  {
+    m_tileSize = tileSize;
+  }
+
+private:
+  // Approximate amount of memory a task should work on (typical L2 cache size)
+  static constexpr std::size_t sk_tileMemorySize = 256 * 1024;
+  // Minimal ratio between the number of Nystrom points and of components in an adaptive build
+  static constexpr unsigned sk_nystromOversampling = 2;
+  // Names of the stages reported to the progress callback
+  inline static const std::string sk_nystromStage = "Nystrom approximation";
+  inline static const std::string sk_basisStage = "Basis";
+  // Names of the entries of the checkpoint
+  inline static const std::string sk_nystromPrefix = "nystrom";
+  inline static const std::string sk_basisName = "basis";
+  inline static const std::string sk_basisTilesName = "basisTiles";
+  inline static const std::string sk_basisTileSizeName = "basisTileSize";
+
+  /**
+   * \brief Return the smallest number of eigenfunctions of \a nystrom that reaches one of the
+   * targets of \a params, or 0 if none is reached by the computed eigenfunctions
+   */
+  static unsigned
+  SelectNumberOfComponents(const Nystrom<T> & nystrom, const AdaptiveRankParameters & params)
+  {
+    const auto & eigenvalues = nystrom.GetComputedEigenvalues();
+    auto         totalVariance = nystrom.GetTotalVariance();
+
+    double cumulatedVariance = 0;
+    for (unsigned i = 0; i < eigenvalues.size(); ++i)
+    {
+      cumulatedVariance += eigenvalues[i];
+      if (cumulatedVariance >= params.retainedVariance * totalVariance ||
+          totalVariance - cumulatedVariance <= params.traceError)
+      {
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * \brief Grow a Nystrom approximation until it reaches the targets of \a params
+   *
+   * The progress is reported in number of Nystrom points.
+   */
+  std::unique_ptr<Nystrom<T>>
+  BuildAdaptiveNystrom(const MatrixValuedKernelType &         kernel,
+                       const AdaptiveRankParameters &         params,
+                       const details::BuildProgressReporter & progress) const
+  {
+    auto numDomainPoints = static_cast<unsigned>(m_representer->GetDomain().GetNumberOfPoints());
+    auto maxNumPoints = std::min(params.maxNumPointsForNystrom, numDomainPoints);
+    auto numPoints = std::min(params.initialNumPointsForNystrom, maxNumPoints);
+    auto rank = std::min({ params.initialNumComponents, params.maxNumComponents, numPoints });
+
+    progress.Report(sk_nystromStage, 0, maxNumPoints);
+    auto nystrom = Nystrom<T>::SafeCreateStd(m_representer, kernel, rank, numPoints, true);
+
+    unsigned numComponents = 0;
+    while (true)
+    {
+      progress.Report(sk_nystromStage, numPoints, maxNumPoints);
+      numComponents = SelectNumberOfComponents(*nystrom, params);
+      STATISMO_LOG_DEBUG("Nystrom points: " + std::to_string(numPoints) + ", rank: " + std::to_string(rank) +
+                         ", selected components: " + std::to_string(numComponents));
+
+      // the target is not reached with the eigenvalues computed so far
+      auto maxRank = std::min(params.maxNumComponents, numPoints);
+      if (numComponents == 0 && rank < maxRank)
+      {
+        rank = std::min(2 * rank, maxRank);
+        nystrom->Extend(numPoints, rank);
+        continue;
+      }
+      if (numComponents == 0)
+      {
+        numComponents = rank;
+      }
+
+      // the eigenfunctions are only approximated well if the number of Nystrom points
+      // is sufficiently larger than the number of components
+      if (numPoints >= maxNumPoints || numPoints >= sk_nystromOversampling * numComponents)
+      {
+        break;
+      }
+      numPoints = std::min(maxNumPoints, std::max(2 * numPoints, sk_nystromOversampling * numComponents));
+      nystrom->Extend(numPoints, rank);
+    }
+
+    nystrom->SetNumberOfEigenfunctions(numComponents);
+    progress.Report(sk_nystromStage, maxNumPoints, maxNumPoints);
+    return nystrom;
+  }
+
+  /**
+   * \brief Compute the key identifying a build in a checkpoint, from the domain, the kernel and
+   * the build \a parameters
+   */
+  std::string
+  ComputeBuildKey(const MatrixValuedKernelType & kernel, const std::string & parameters) const
+  {
+    std::size_t domainHash = 0;
+    for (const auto & pt : m_representer->GetDomain().GetDomainPoints())
+    {
+      details::HashCombine(domainHash, BuildCheckpoint::HashMatrix(m_representer->PointToVector(pt)));
+    }
+
+    return "LowRankGPModelBuilder;kernel=" + kernel.GetKernelInfo() + ";kernelDim=" +
+           std::to_string(kernel.GetDimension()) + ";domain=" + std::to_string(domainHash) + ";" + parameters;
+  }
+
+  /**
+   * \brief Start the build in the checkpoint, and return the Nystrom approximation it holds if the
+   * checkpoint belongs to the same build (nullptr otherwise)
+   */
+  std::unique_ptr<Nystrom<T>>
+  RestoreNystrom(const MatrixValuedKernelType & kernel, const std::string & buildKey) const
+  {
+    if (!m_checkpoint || !m_checkpoint->Begin(buildKey) || !m_checkpoint->Exists(sk_nystromPrefix + "Matrix"))
+    {
+      return nullptr;
+    }
+
+    STATISMO_LOG_INFO("Resuming build from checkpoint " + m_checkpoint->GetFilename());
+    return Nystrom<T>::SafeCreateStd(m_representer, kernel, *m_checkpoint, sk_nystromPrefix);
+  }
+
+  void
+  SaveNystrom(const Nystrom<T> & nystrom) const
+  {
+    if (m_checkpoint)
+    {
+      nystrom.SaveState(*m_checkpoint, sk_nystromPrefix);
+      m_checkpoint->Flush();
+    }
+  }
+
+  /**
+   * \brief Read the tiles of the basis stored in the checkpoint into \a pcaBasis
+   * \param tileSize number of domain points of a tile, replaced by the one of the stored tiles
+   * \param savedTiles indices of the tiles read
+   */
+  void
+  RestoreBasisTiles(MatrixType & pcaBasis, std::size_t & tileSize, std::vector<unsigned> & savedTiles) const
+  {
+    auto kernelDim = m_representer->GetDimensions();
+    auto numDomainPoints = m_representer->GetDomain().GetNumberOfPoints();
+
+    if (!m_checkpoint->Exists(sk_basisTilesName))
+    {
+      m_checkpoint->WriteIndices(sk_basisTileSizeName, { static_cast<unsigned>(tileSize) });
+      return;
+    }
+
+    // the tiles are read with the size they were computed with, as the results of the
+    // computation depend slightly on it
+    std::vector<unsigned> storedTileSize;
+    m_checkpoint->ReadIndices(sk_basisTileSizeName, storedTileSize);
+    tileSize = storedTileSize.at(0);
+    m_checkpoint->ReadIndices(sk_basisTilesName, savedTiles);
+    for (auto tile : savedTiles)
+    {
+      auto lowerInd = tile * tileSize;
+      auto upperInd = std::min(numDomainPoints, lowerInd + tileSize);
+      m_checkpoint->ReadRows(sk_basisName,
+                             lowerInd * kernelDim,
+                             pcaBasis.middleRows(lowerInd * kernelDim, (upperInd - lowerInd) * kernelDim));
+    }
+  }
+
+  /**
+   * \brief Store the \a pendingTiles of \a pcaBasis in the checkpoint and add them to \a savedTiles
+   */
+  void
+  SaveBasisTiles(const MatrixType &      pcaBasis,
+                 std::size_t             tileSize,
+                 std::vector<unsigned> & pendingTiles,
+                 std::vector<unsigned> & savedTiles) const
+  {
+    auto kernelDim = m_representer->GetDimensions();
     auto numDomainPoints = m_representer->GetDomain().GetNumberOfPoints();
-    auto kernelDim = kernel.GetDimension();
 
-    auto nystrom = Nystrom<T>::SafeCreateStd(m_representer, kernel, numComponents, numPointsForNystrom);
+    for (auto tile : pendingTiles)
+    {
+      auto lowerInd = tile * tileSize;
+      auto upperInd = std::min(numDomainPoints, lowerInd + tileSize);
+      m_checkpoint->WriteRows(sk_basisName,
+                              pcaBasis.rows(),
+                              lowerInd * kernelDim,
+                              pcaBasis.middleRows(lowerInd * kernelDim, (upperInd - lowerInd) * kernelDim));
+    }
+    savedTiles.insert(std::end(savedTiles), std::begin(pendingTiles), std::end(pendingTiles));
+    pendingTiles.clear();
+
+    m_checkpoint->WriteIndices(sk_basisTilesName, savedTiles);
+    m_checkpoint->Flush();
+  }
+
+  UniquePtrType<StatisticalModelType>
+  BuildModelFromNystrom(typename RepresenterType::DatasetConstPointerType mean,
+                        const Nystrom<T> &                                nystrom,
+                        const typename BuilderInfo::ParameterInfoList &   bi,
+                        const details::BuildProgressReporter &            progress) const
+  {
+    auto domainPoints = m_representer->GetDomain().GetDomainPoints();
+    auto numDomainPoints = m_representer->GetDomain().GetNumberOfPoints();
+    auto kernelDim = m_representer->GetDimensions();
+    auto numComponents = nystrom.GetEigenvalues().size();
 
     // We precompute the value of the eigenfunction for each domain point
     // and store it later in the pcaBasis matrix. In this way we obtain
     // a standard statismo model.
-    // To save time, we parallelize over the rows
-    unsigned                                                 numChunks = std::thread::hardware_concurrency() + 1;
-    ThreadPool                                               pool{ numChunks - 1 };
-    std::vector<std::future<EigenfunctionComputationResult>> futvec;
-
-    for (unsigned i = 0; i <= numChunks; i++)
+    // To save time, the rows are computed in parallel. Each task handles a tile of
+    // domain points that is small enough for its kernel block to stay in cache. The
+    // tasks are much more numerous than the threads, which balances the load.
+    MatrixType pcaBasis(numDomainPoints * kernelDim, numComponents);
+
+    auto pool = GetThreadPool();
+    auto tileSize = ComputeTileSize(nystrom.GetNumberOfNystromPoints(), kernelDim);
+
+    // the tiles computed by an interrupted build are read from the checkpoint
+    std::vector<unsigned> savedTiles;
+    std::vector<unsigned> pendingTiles;
+    if (m_checkpoint)
+    {
+      RestoreBasisTiles(pcaBasis, tileSize, savedTiles);
+    }
+    std::vector<bool> isTileSaved((numDomainPoints + tileSize - 1) / tileSize, false);
+    for (auto tile : savedTiles)
     {
-      unsigned chunkSize =
-        static_cast<unsigned>(ceil(static_cast<float>(numDomainPoints) / static_cast<float>(numChunks)));
-      unsigned lowerInd = i * chunkSize;
-      unsigned upperInd = std::min(static_cast<unsigned>(numDomainPoints), (i + 1) * chunkSize);
+      isTileSaved.at(tile) = true;
+    }
+
+    // reported before any task is submitted, as a cancellation throws from here
+    auto numCompletedTiles = savedTiles.size();
+    progress.Report(sk_basisStage, numCompletedTiles, isTileSaved.size());
 
-      if (lowerInd >= upperInd)
+    // the tasks of a cancelled build return without computing their tile, which
+    // frees the pool as soon as the running tasks are finished
+    std::atomic<bool>                                   isCancelled{ false };
+    std::vector<std::pair<unsigned, std::future<bool>>> futvec;
+    futvec.reserve(isTileSaved.size());
+
+    for (unsigned tile = 0; tile < isTileSaved.size(); ++tile)
+    {
+      if (isTileSaved[tile])
       {
-        break;
+        continue;
       }
 
-      futvec.emplace_back(pool.Submit([=, nys = nystrom.get(), k = &kernel]() {
-        return ComputeEigenfunctionsForPoints(nys, k, numComponents, domainPoints, lowerInd, upperInd);
-      }));
+      auto lowerInd = tile * tileSize;
+      auto upperInd = std::min(numDomainPoints, lowerInd + tileSize);
+      futvec.emplace_back(tile, pool->Submit([&, lowerInd, upperInd]() {
+                            if (isCancelled)
+                            {
+                              return false;
+                            }
+                            pcaBasis.middleRows(lowerInd * kernelDim, (upperInd - lowerInd) * kernelDim) =
+                              nystrom.ComputeEigenfunctionsAtDomainPoints(domainPoints, lowerInd, upperInd);
+                            return true;
+                          }));
     }
 
-    MatrixType pcaBasis = MatrixType::Zero(numDomainPoints * kernelDim, numComponents);
+    // all the tasks must be finished before an exception can be rethrown,
+    // as they write into pcaBasis. Meanwhile, the finished tiles are periodically
+    // stored in the checkpoint.
+    std::exception_ptr error;
+    for (auto & [tile, f] : futvec)
+    {
+      try
+      {
+        if (!f.get())
+        {
+          continue;
+        }
+        if (m_checkpoint)
+        {
+          pendingTiles.push_back(tile);
+          if (m_checkpoint->IsDue())
+          {
+            SaveBasisTiles(pcaBasis, tileSize, pendingTiles, savedTiles);
+          }
+        }
+        if (!error)
+        {
+          progress.Report(sk_basisStage, ++numCompletedTiles, isTileSaved.size());
+        }
+      }
+      catch (...)
+      {
+        isCancelled = true;
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+      }
+    }
 
-    // collect the result
-    for (auto & f : futvec)
+    // the tiles completed by a failed or cancelled build are kept for resuming it
+    if (m_checkpoint && !pendingTiles.empty())
     {
-      auto res = f.get();
-      pcaBasis.block(res.lowerInd * kernelDim, 0, (res.upperInd - res.lowerInd) * kernelDim, pcaBasis.cols()) =
-        res.resultForPoints;
+      try
+      {
+        SaveBasisTiles(pcaBasis, tileSize, pendingTiles, savedTiles);
+      }
+      catch (...)
+      {
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error)
+    {
+      std::rethrow_exception(error);
     }
-    futvec.clear();
 
     STATISMO_LOG_DEBUG("End of multithreaded computation");
 
-    auto pcaVariance = nystrom->GetEigenvalues();
+    auto pcaVariance = nystrom.GetEigenvalues();
     auto mu = m_representer->SampleToSampleVector(mean);
     auto model = StatisticalModelType::SafeCreate(m_representer, mu, pcaBasis, pcaVariance, 0);
 
     // the model builder does not use any data. Hence the scores and the datainfo is emtpy
-    MatrixType                              scores; // no scores
-    typename BuilderInfo::DataInfoList      dataInfo;
-    typename BuilderInfo::ParameterInfoList bi;
-    bi.emplace_back(BuilderInfo::KeyValuePair("NoiseVariance", std::to_string(0)));
-    bi.emplace_back(BuilderInfo::KeyValuePair("KernelInfo", kernel.GetKernelInfo()));
+    MatrixType                         scores; // no scores
+    typename BuilderInfo::DataInfoList dataInfo;
 
     // finally add meta data to the model info
     ModelInfo::BuilderInfoList biList(1, BuilderInfo{ "LowRankGPModelBuilder", dataInfo, bi });
@@ -204,36 +623,30 @@ public:
     return model;
   }
 
-private:
-  /*
-   * Compute the eigenfunction value at the poitns with index lowerInd - upperInd.
-   * Return a result object with the given values.
-   * This method is used to be able to parallelize the computations.
-   */
-  EigenfunctionComputationResult
-  ComputeEigenfunctionsForPoints(const Nystrom<T> *             nystrom,
-                                 const MatrixValuedKernelType * kernel,
-                                 unsigned                       numEigenfunctions,
-                                 const std::vector<PointType> & domainPts,
-                                 unsigned                       lowerInd,
-                                 unsigned                       upperInd) const
+  SharedPtrType<ThreadPool>
+  GetThreadPool() const
   {
+    std::lock_guard<std::mutex> lock{ m_poolMutex };
+    if (!m_pool)
+    {
+      m_pool = std::make_shared<ThreadPool>(m_numThreads == 0 ? std::numeric_limits<unsigned>::max() : m_numThreads,
+                                            ThreadPool::WaitingMode::BLOCK,
+                                            0);
+    }
+    return m_pool;
+  }
 
-    auto kernelDim = kernel->GetDimension();
-    assert(upperInd <= domainPts.size());
-
-    // holds the results of the computation
-    MatrixType resMat = MatrixType::Zero((upperInd - lowerInd) * kernelDim, numEigenfunctions);
-
-    // compute the nystrom extension for each point i in domainPts, for which
-    // i is in the right range
-    for (unsigned i = lowerInd; i < upperInd; i++)
+  std::size_t
+  ComputeTileSize(std::size_t numNystromPoints, unsigned kernelDim) const
+  {
+    if (m_tileSize > 0)
     {
-      auto pti = domainPts[i];
-      resMat.block((i - lowerInd) * kernelDim, 0, kernelDim, resMat.cols()) =
-        nystrom->ComputeEigenfunctionsAtPoint(pti);
+      return m_tileSize;
     }
-    return EigenfunctionComputationResult(lowerInd, upperInd, resMat);
+
+    // memory needed by the kernel block of one domain point
+    auto pointSize = numNystromPoints * kernelDim * kernelDim * sizeof(ScalarType);
+    return std::max<std::size_t>(1, sk_tileMemorySize / std::max<std::size_t>(1, pointSize));
   }
 
   LowRankGPModelBuilder(const RepresenterType * representer)
@@ -242,7 +655,12 @@ private:
     this->SetLogger(m_representer->GetLogger());
   }
 
-  const RepresenterType * m_representer;
+  const RepresenterType *                m_representer;
+  mutable SharedPtrType<ThreadPool>      m_pool;
+  mutable std::mutex                     m_poolMutex;
+  unsigned                               m_numThreads{ 0 };
+  unsigned                               m_tileSize{ 0 };
+  SharedPtrType<BuildCheckpoint>         m_checkpoint;
 };
 
 } // namespace statismo
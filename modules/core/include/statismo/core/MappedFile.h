@@ -0,0 +1,95 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __STATIMO_CORE_MAPPED_FILE_H_
+#define __STATIMO_CORE_MAPPED_FILE_H_
+
+#include "statismo/core/NonCopyable.h"
+#include "statismo/core/StatismoCoreExport.h"
+
+#include <cstddef>
+#include <string>
+
+namespace statismo
+{
+
+/**
+ * \brief Read-only memory mapping of a file
+ *
+ * The content of the file is accessible through GetData as long as the object exists. The pages are read
+ * by the operating system when they are first accessed, and are shared with the other mappings of the file.
+ * \ingroup Core
+ */
+class STATISMO_CORE_EXPORT MappedFile : public NonCopyable
+{
+public:
+  /**
+   * \brief Map the file \a filename
+   * \throw StatisticalModelException with Status::IO_ERROR if the file cannot be mapped
+   */
+  explicit MappedFile(const std::string & filename);
+
+  ~MappedFile() override;
+
+  /**
+   * \brief Return the content of the file, or nullptr for an empty file
+   */
+  const char *
+  GetData() const
+  {
+    return m_data;
+  }
+
+  /**
+   * \brief Return the size of the file in bytes
+   */
+  std::size_t
+  GetSize() const
+  {
+    return m_size;
+  }
+
+private:
+  const char * m_data{ nullptr };
+  std::size_t  m_size{ 0 };
+#ifdef _WIN32
+  void * m_fileHandle{ nullptr };
+  void * m_mappingHandle{ nullptr };
+#endif
+};
+
+} // namespace statismo
+
+#endif
@@ -40,11 +40,15 @@
 
 #include "statismo/core/CommonTypes.h"
 #include "statismo/core/DataManager.h"
+#include "statismo/core/Exceptions.h"
 #include "statismo/core/StatisticalModel.h"
 #include "statismo/core/GenericFactory.h"
 #include "statismo/core/NonCopyable.h"
 #include "statismo/core/Logger.h"
 
+#include <chrono>
+#include <functional>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -55,6 +59,77 @@
 namespace statismo
 {
 
+/**
+ * \brief Progress of a model build, reported to the progress callback of the builder
+ *
+ * A build is made of stages, each of which is split into work units (e.g. the tiles
+ * of a basis).
+ *
+ * \ingroup ModelBuilders
+ * \ingroup Core
+ */
+struct BuildProgress
+{
+  /** Name of the current stage */
+  std::string               stage;
+  /** Number of work units of the stage that are completed */
+  std::size_t               completedUnits{ 0 };
+  /** Number of work units of the stage */
+  std::size_t               totalUnits{ 0 };
+  /** Time elapsed since the beginning of the build */
+  std::chrono::milliseconds elapsed{ 0 };
+};
+
+/**
+ * \brief Callback receiving the progress of a build
+ *
+ * It is called from the thread running the build and returns false to cancel the build.
+ * A cancelled build throws a StatisticalModelException with status Status::CANCELLED.
+ *
+ * \ingroup ModelBuilders
+ * \ingroup Core
+ */
+using ProgressCallbackType = std::function<bool(const BuildProgress &)>;
+
+namespace details
+{
+/**
+ * \brief Report the progress of one build to a progress callback
+ */
+class BuildProgressReporter
+{
+public:
+  explicit BuildProgressReporter(ProgressCallbackType callback)
+    : m_callback(std::move(callback))
+    , m_start(std::chrono::steady_clock::now())
+  {}
+
+  /**
+   * \brief Report that \a completedUnits work units of \a totalUnits are completed in the stage \a stage
+   * \throws StatisticalModelException with status Status::CANCELLED if the build is cancelled
+   */
+  void
+  Report(const std::string & stage, std::size_t completedUnits, std::size_t totalUnits) const
+  {
+    if (!m_callback)
+    {
+      return;
+    }
+
+    auto elapsed =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start);
+    if (!m_callback(BuildProgress{ stage, completedUnits, totalUnits, elapsed }))
+    {
+      throw StatisticalModelException(("Build cancelled during stage " + stage).c_str(), Status::CANCELLED);
+    }
+  }
+
+private:
+  ProgressCallbackType                  m_callback;
+  std::chrono::steady_clock::time_point m_start;
+};
+} // namespace details
+
 /**
  * \brief Base abstract class for model builders
  * \ingroup ModelBuilders
@@ -132,6 +207,16 @@ public:
     delete this;
   }
 
+  /**
+   * \brief Set the callback receiving the progress of the builds, which can also cancel them
+   * \param callback progress callback (an empty function disables progress reporting)
+   */
+  void
+  SetProgressCallback(ProgressCallbackType callback)
+  {
+    m_progressCallback = std::move(callback);
+  }
+
 protected:
   Logger *
   GetLogger() const
@@ -139,8 +224,24 @@ protected:
     return m_logger;
   }
 
+  const ProgressCallbackType &
+  GetProgressCallback() const
+  {
+    return m_progressCallback;
+  }
+
+  /**
+   * \brief Create the reporter of the progress of a new build
+   */
+  details::BuildProgressReporter
+  CreateProgressReporter() const
+  {
+    return details::BuildProgressReporter{ m_progressCallback };
+  }
+
 private:
-  Logger * m_logger{ nullptr };
+  Logger *             m_logger{ nullptr };
+  ProgressCallbackType m_progressCallback;
 };
 
 } // namespace statismo
@@ -0,0 +1,332 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __STATIMO_CORE_MODEL_CACHE_H_
+#define __STATIMO_CORE_MODEL_CACHE_H_
+
+#include "statismo/core/CommonTypes.h"
+#include "statismo/core/Exceptions.h"
+#include "statismo/core/GenericFactory.h"
+#include "statismo/core/IO.h"
+#include "statismo/core/NonCopyable.h"
+#include "statismo/core/StatisticalModel.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace statismo
+{
+
+/**
+ * \brief Counters of a ModelCache
+ */
+struct ModelCacheStatistics
+{
+  std::size_t numberOfHits{ 0 };
+  std::size_t numberOfMisses{ 0 };
+  std::size_t numberOfEvictions{ 0 };
+  // models currently held by the cache and their size in bytes
+  std::size_t numberOfModels{ 0 };
+  std::size_t size{ 0 };
+};
+
+/**
+ * \brief Thread-safe cache of the models loaded from files
+ *
+ * The models are identified by the path of the file, the time of its last modification and the maximal number of
+ * components that are loaded, such that a modified file is loaded again. The models are shared and constant: the
+ * cache and all the callers that requested the same model hold the same object.
+ *
+ * When several threads request a model that is not in the cache, it is loaded once and the other threads wait for
+ * this load. The least recently used models are evicted when the total size of the models exceeds the size budget,
+ * or when there are more models than the maximal number of models. An evicted model stays valid as long as a caller
+ * holds it.
+ *
+ * A process-wide cache is returned by GetInstance, other caches can be created with the factory methods.
+ * \ingroup Core
+ */
+template <typename T>
+class ModelCache
+  : public GenericFactory<ModelCache<T>>
+  , public NonCopyable
+{
+public:
+  using ObjectFactoryType = GenericFactory<ModelCache<T>>;
+  using StatisticalModelType = StatisticalModel<T>;
+  using RepresenterType = typename StatisticalModelType::RepresenterType;
+  using ModelPointerType = std::shared_ptr<const StatisticalModelType>;
+
+  friend ObjectFactoryType;
+
+  /**
+   * \brief Destroy the object.
+   */
+  void
+  Delete()
+  {
+    delete this;
+  }
+
+  /**
+   * \brief Get the process-wide cache
+   */
+  static ModelCache &
+  GetInstance()
+  {
+    static ModelCache s_cache;
+    return s_cache;
+  }
+
+  /**
+   * \brief Get the model stored in \a filename, which is loaded if it is not in the cache
+   * \param representer representer of the type of the model, it is cloned and not modified
+   * \param maxNumberOfPCAComponents maximal number of pca components loaded (see IO::LoadStatisticalModel)
+   * \throw StatisticalModelException if the model cannot be loaded, the failed loads are not cached
+   */
+  ModelPointerType
+  GetModel(const RepresenterType * representer,
+           const std::string &     filename,
+           unsigned                maxNumberOfPCAComponents = std::numeric_limits<unsigned>::max())
+  {
+    KeyType key;
+    try
+    {
+      auto path = std::filesystem::weakly_canonical(filename);
+      key = KeyType{ path.string(), std::filesystem::last_write_time(path), maxNumberOfPCAComponents };
+    }
+    catch (const std::filesystem::filesystem_error & e)
+    {
+      throw StatisticalModelException((std::string("could not open model file \n") + e.what()).c_str(),
+                                      Status::IO_ERROR);
+    }
+
+    std::promise<ModelPointerType>       promise;
+    std::shared_future<ModelPointerType> cachedModel;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto                        it = m_entries.find(key);
+      if (it != std::end(m_entries))
+      {
+        ++m_statistics.numberOfHits;
+        m_lruList.splice(std::begin(m_lruList), m_lruList, it->second.lruPosition);
+        cachedModel = it->second.model;
+      }
+      else
+      {
+        ++m_statistics.numberOfMisses;
+        m_lruList.push_front(key);
+        m_entries.emplace(key, Entry{ promise.get_future().share(), std::begin(m_lruList) });
+      }
+    }
+
+    if (cachedModel.valid())
+    {
+      // waits if the model is being loaded by another thread
+      return cachedModel.get();
+    }
+
+    ModelPointerType model;
+    try
+    {
+      // the reads of concurrent misses are serialized by IO, the models are created concurrently
+      UniquePtrType<RepresenterType> modelRepresenter{ representer->CloneSelf() };
+      model = IO<T>::LoadStatisticalModel(modelRepresenter.get(), filename, maxNumberOfPCAComponents);
+    }
+    catch (...)
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        RemoveEntry(m_entries.find(key));
+      }
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto &                      entry = m_entries.at(key);
+      entry.isLoaded = true;
+      entry.size = GetModelSize(*model);
+      m_statistics.size += entry.size;
+      Evict();
+    }
+    promise.set_value(model);
+    return model;
+  }
+
+  /**
+   * \brief Set the maximal total size of the models in the cache, in bytes
+   */
+  void
+  SetSizeBudget(std::size_t sizeBudget)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sizeBudget = sizeBudget;
+    Evict();
+  }
+
+  std::size_t
+  GetSizeBudget() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sizeBudget;
+  }
+
+  /**
+   * \brief Set the maximal number of models in the cache
+   */
+  void
+  SetMaximumNumberOfModels(std::size_t maximumNumberOfModels)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maximumNumberOfModels = maximumNumberOfModels;
+    Evict();
+  }
+
+  std::size_t
+  GetMaximumNumberOfModels() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maximumNumberOfModels;
+  }
+
+  /**
+   * \brief Remove all the loaded models from the cache
+   */
+  void
+  Clear()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = std::begin(m_entries); it != std::end(m_entries);)
+    {
+      auto next = std::next(it);
+      if (it->second.isLoaded)
+      {
+        RemoveEntry(it);
+      }
+      it = next;
+    }
+  }
+
+  ModelCacheStatistics
+  GetStatistics() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto                        statistics = m_statistics;
+    statistics.numberOfModels = m_entries.size();
+    return statistics;
+  }
+
+private:
+  using KeyType = std::tuple<std::string, std::filesystem::file_time_type, unsigned>;
+
+  struct Entry
+  {
+    std::shared_future<ModelPointerType>  model;
+    typename std::list<KeyType>::iterator lruPosition;
+    // the models that are being loaded are not evicted
+    bool        isLoaded{ false };
+    std::size_t size{ 0 };
+  };
+  using EntryMapType = std::map<KeyType, Entry>;
+
+  // 1GB by default
+  explicit ModelCache(std::size_t sizeBudget = std::size_t{ 1 } << 30)
+    : m_sizeBudget(sizeBudget)
+  {}
+
+  static std::size_t
+  GetModelSize(const StatisticalModelType & model)
+  {
+    std::size_t numRows = model.GetMeanVector().size();
+    return (numRows * (model.GetNumberOfPrincipalComponents() + 1) + model.GetNumberOfPrincipalComponents()) *
+           sizeof(ScalarType);
+  }
+
+  void
+  RemoveEntry(typename EntryMapType::iterator it)
+  {
+    m_statistics.size -= it->second.size;
+    m_lruList.erase(it->second.lruPosition);
+    m_entries.erase(it);
+  }
+
+  // evict the least recently used models, but the most recent one
+  void
+  Evict()
+  {
+    auto position = std::end(m_lruList);
+    while ((m_statistics.size > m_sizeBudget || m_entries.size() > m_maximumNumberOfModels) &&
+           position != std::begin(m_lruList))
+    {
+      auto current = std::prev(position);
+      if (current == std::begin(m_lruList))
+      {
+        break;
+      }
+
+      auto it = m_entries.find(*current);
+      if (it->second.isLoaded)
+      {
+        RemoveEntry(it);
+        ++m_statistics.numberOfEvictions;
+      }
+      else
+      {
+        position = current;
+      }
+    }
+  }
+
+  mutable std::mutex   m_mutex;
+  EntryMapType         m_entries;
+  std::list<KeyType>   m_lruList;
+  std::size_t          m_sizeBudget;
+  std::size_t          m_maximumNumberOfModels{ std::numeric_limits<std::size_t>::max() };
+  ModelCacheStatistics m_statistics;
+};
+
+} // namespace statismo
+
+#endif
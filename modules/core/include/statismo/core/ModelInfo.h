@@ -51,6 +51,34 @@ namespace statismo
 
 class BuilderInfo; // forward declaration
 
+/**
+ * \brief Parts of the model info that are read by ModelInfo::Load
+ *
+ * The scores and the builder infos grow with the number of datasets, and their loading can be skipped when they
+ * are not needed. The flags can be combined with operator|.
+ *
+ * \ingroup Core
+ */
+enum class ModelInfoLoadFlags : unsigned
+{
+  NONE = 0,
+  SCORES = 1,
+  BUILDER_INFO = 2,
+  ALL = SCORES | BUILDER_INFO
+};
+
+inline ModelInfoLoadFlags
+operator|(ModelInfoLoadFlags lhs, ModelInfoLoadFlags rhs)
+{
+  return static_cast<ModelInfoLoadFlags>(static_cast<unsigned>(lhs) | static_cast<unsigned>(rhs));
+}
+
+inline bool
+HasFlag(ModelInfoLoadFlags flags, ModelInfoLoadFlags flag)
+{
+  return (static_cast<unsigned>(flags) & static_cast<unsigned>(flag)) != 0;
+}
+
 /**
  * \brief Store meta information about the model
  *
@@ -105,9 +133,12 @@ public:
 
   /**
    * \brief Load model info from tan hdf5 group
+   * \param publicFg group holding the model info
+   * \param flags parts of the model info to load. The scores, or the builder infos, of a model info loaded without
+   * them are empty (saving it thus drops them).
    */
   STATISMO_CORE_EXPORT void
-  Load(const H5::H5Location & publicFg);
+  Load(const H5::H5Location & publicFg, ModelInfoLoadFlags flags = ModelInfoLoadFlags::ALL);
 
 private:
   BuilderInfo
@@ -176,6 +207,12 @@ private:
   static void
   FillKeyValueListFromInfoGroup(const H5::H5Location & group, KeyValueList & keyValueList);
 
+  // the lists are stored as a single array of strings, where each key is followed by its value
+  static void
+  WriteKeyValueList(const H5::H5Location & group, const char * name, const KeyValueList & keyValueList);
+  static void
+  ReadKeyValueList(const H5::H5Location & group, const char * name, KeyValueList & keyValueList);
+
   std::string       m_modelBuilderName;
   std::string       m_buildtime;
   DataInfoList      m_dataInfo;
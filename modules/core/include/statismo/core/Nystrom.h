@@ -11,15 +11,26 @@
 #ifndef __STATIMO_CORE_NYSTROM_H_
 #define __STATIMO_CORE_NYSTROM_H_
 
+#include "statismo/core/BuildCheckpoint.h"
 #include "statismo/core/NonCopyable.h"
 #include "statismo/core/GenericFactory.h"
 #include "statismo/core/CommonTypes.h"
+#include "statismo/core/Exceptions.h"
 #include "statismo/core/Kernels.h"
 #include "statismo/core/RandSVD.h"
 #include "statismo/core/RandUtils.h"
 #include "statismo/core/Representer.h"
+#include "statismo/core/SpatialIndex.h"
+
+#include <Eigen/Sparse>
 
 #include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
 
 namespace statismo
 {
@@ -56,12 +67,8 @@ public:
     // for every domain point x in the list, we compute the kernel vector
     // kx = (k(x, x1), ... k(x, xm))
     // since the kernel is matrix valued, kx is actually a matrix
-    MatrixType kxi = MatrixType::Zero(kernelDim, m_nystromPoints.size() * kernelDim);
-
-    for (unsigned j = 0; j < m_nystromPoints.size(); j++)
-    {
-      kxi.block(0, j * kernelDim, kernelDim, kernelDim) = m_kernel(pt, m_nystromPoints[j]);
-    }
+    MatrixType kxi(kernelDim, m_nystromPoints.size() * kernelDim);
+    ComputeKernelBlocksAtPoint(pt, sk_noPointId, kxi, 0);
 
 
     MatrixType resMat = MatrixType::Zero(kernelDim, m_numEigenfunctions);
@@ -74,6 +81,61 @@ public:
   }
 
 
+  /**
+   * \brief Return a (u - l) * d x n matrix, which holds the d-dimension value of all the n eigenfunctions
+   * at the points with index l to u in \a pts
+   *
+   * The kernel vectors of the whole range are assembled into one block, so that the
+   * eigenfunctions are obtained with a single matrix product instead of one per point.
+   */
+  MatrixType
+  ComputeEigenfunctionsAtPoints(const std::vector<PointType> & pts, std::size_t l, std::size_t u) const
+  {
+    assert(l <= u && u <= pts.size());
+
+    unsigned kernelDim = m_kernel.GetDimension();
+
+    MatrixType kx((u - l) * kernelDim, m_nystromPoints.size() * kernelDim);
+    for (std::size_t i = l; i < u; ++i)
+    {
+      ComputeKernelBlocksAtPoint(pts[i], sk_noPointId, kx, (i - l) * kernelDim);
+    }
+
+    return kx * m_nystromMatrix.leftCols(m_numEigenfunctions);
+  }
+
+  /**
+   * \brief Same as ComputeEigenfunctionsAtPoints, where \a domainPoints are the points of the
+   * representer domain, i.e. the index of a point is its point id
+   *
+   * If the kernel accepts the point ids of this domain (see MatrixValuedKernel::AcceptsPointIdsOf),
+   * it is evaluated with the ids and the points are not looked up.
+   */
+  MatrixType
+  ComputeEigenfunctionsAtDomainPoints(const std::vector<PointType> & domainPoints, std::size_t l, std::size_t u) const
+  {
+    assert(l <= u && u <= domainPoints.size());
+
+    unsigned kernelDim = m_kernel.GetDimension();
+
+    MatrixType kx((u - l) * kernelDim, m_nystromPoints.size() * kernelDim);
+    for (std::size_t i = l; i < u; ++i)
+    {
+      ComputeKernelBlocksAtPoint(domainPoints[i], static_cast<long>(i), kx, (i - l) * kernelDim);
+    }
+
+    return kx * m_nystromMatrix.leftCols(m_numEigenfunctions);
+  }
+
+  /**
+   * \brief Get the number of points used for the approximation
+   */
+  std::size_t
+  GetNumberOfNystromPoints() const
+  {
+    return m_nystromPoints.size();
+  }
+
   /**
    * \brief Get a vector of size n, where n is the number of eigenfunctions/eigenvalues
    * that were approximated
@@ -85,97 +147,419 @@ public:
   }
 
 
+  /**
+   * \brief Get all the eigenvalues computed by the last decomposition of the kernel matrix
+   *
+   * The first GetEigenvalues().size() of them correspond to the eigenfunctions in use.
+   */
+  const VectorType &
+  GetComputedEigenvalues() const
+  {
+    return m_computedEigenvalues;
+  }
+
+  /**
+   * \brief Get an estimate of the total variance of the kernel on the domain, i.e. the sum of
+   * all its eigenvalues
+   *
+   * It is obtained from the trace of the kernel matrix at the Nystrom points.
+   */
+  double
+  GetTotalVariance() const
+  {
+    return m_kernelTrace * static_cast<double>(m_numDomainPoints) / static_cast<double>(m_nystromPoints.size());
+  }
+
+  /**
+   * \brief Set the number of eigenfunctions in use
+   * \param numEigenfunctions number of eigenfunctions, at most the number computed by the last decomposition
+   */
+  void
+  SetNumberOfEigenfunctions(unsigned numEigenfunctions)
+  {
+    if (numEigenfunctions > m_computedEigenvalues.size())
+    {
+      throw StatisticalModelException(
+        ("Only " + std::to_string(m_computedEigenvalues.size()) + " eigenfunctions were computed").c_str(),
+        Status::BAD_INPUT_ERROR);
+    }
+
+    m_numEigenfunctions = numEigenfunctions;
+    m_eigenvalues = m_computedEigenvalues.topRows(numEigenfunctions);
+  }
+
+  /**
+   * \brief Add points to the approximation and recompute the eigenfunctions
+   *
+   * The new points are drawn from the points of the domain that are not used yet. The kernel
+   * matrix of the current points is kept, only the blocks involving a new point are evaluated.
+   * \param numberOfPointsForApproximation new total number of points (no point is removed)
+   * \param numEigenfunctions number of eigenfunctions to compute
+   * \warning The Nystrom object must have been created as extensible
+   */
+  void
+  Extend(unsigned numberOfPointsForApproximation, unsigned numEigenfunctions)
+  {
+    if (!m_extensible)
+    {
+      throw StatisticalModelException("Nystrom approximation is not extensible", Status::BAD_INPUT_ERROR);
+    }
+
+    AddNystromPoints(numberOfPointsForApproximation);
+    ComputeDecomposition(numEigenfunctions);
+  }
+
+  /**
+   * \brief Store the approximation in \a checkpoint, under entries starting with \a prefix
+   *
+   * A Nystrom object created from the checkpoint computes the same eigenfunctions.
+   */
+  void
+  SaveState(BuildCheckpoint & checkpoint, const std::string & prefix) const
+  {
+    checkpoint.WriteIndices(prefix + "PointIds", m_nystromPointIds);
+    checkpoint.WriteMatrix<ScalarType>(prefix + "Matrix", m_nystromMatrix);
+    checkpoint.WriteVector<ScalarType>(prefix + "Eigenvalues", m_computedEigenvalues);
+    checkpoint.WriteIndices(prefix + "NumberOfEigenfunctions", { m_numEigenfunctions });
+    checkpoint.WriteVector<double>(prefix + "KernelTrace", VectorTypeDoublePrecision::Constant(1, m_kernelTrace));
+  }
+
 private:
+  /**
+   * \brief Restore an approximation stored with SaveState
+   * \note The restored approximation is not extensible
+   */
+  Nystrom(const Representer<T> *                representer,
+          const MatrixValuedKernel<PointType> & kernel,
+          const BuildCheckpoint &               checkpoint,
+          const std::string &                   prefix)
+    : m_representer(representer)
+    , m_kernel(kernel)
+    , m_numEigenfunctions(0)
+    , m_supportRadius(kernel.GetSupportRadius())
+    , m_usePointIds(kernel.AcceptsPointIdsOf(representer->GetDomain()))
+    , m_extensible(false)
+  {
+    DomainType domain = m_representer->GetDomain();
+    m_domainPoints = domain.GetDomainPoints();
+    m_numDomainPoints = domain.GetNumberOfPoints();
+
+    checkpoint.ReadIndices(prefix + "PointIds", m_nystromPointIds);
+    for (auto id : m_nystromPointIds)
+    {
+      if (id >= m_numDomainPoints)
+      {
+        throw StatisticalModelException("Nystrom points of the checkpoint do not match the domain",
+                                        Status::BAD_INPUT_ERROR);
+      }
+      m_nystromPoints.push_back(m_domainPoints[id]);
+    }
+    BuildNystromPointIndex();
+
+    checkpoint.ReadMatrix<ScalarType>(prefix + "Matrix", m_nystromMatrix);
+    checkpoint.ReadVector<ScalarType>(prefix + "Eigenvalues", m_computedEigenvalues);
+    if (m_nystromMatrix.rows() != static_cast<Eigen::Index>(m_nystromPoints.size() * kernel.GetDimension()) ||
+        m_nystromMatrix.cols() != m_computedEigenvalues.size())
+    {
+      throw StatisticalModelException("Invalid Nystrom approximation in checkpoint", Status::BAD_INPUT_ERROR);
+    }
+
+    std::vector<unsigned> numEigenfunctions;
+    checkpoint.ReadIndices(prefix + "NumberOfEigenfunctions", numEigenfunctions);
+    VectorTypeDoublePrecision trace;
+    checkpoint.ReadVector<double>(prefix + "KernelTrace", trace);
+    m_kernelTrace = trace(0);
+
+    SetNumberOfEigenfunctions(numEigenfunctions.at(0));
+  }
+
   Nystrom(const Representer<T> *                representer,
           const MatrixValuedKernel<PointType> & kernel,
           unsigned                              numEigenfunctions,
-          unsigned                              numberOfPointsForApproximation)
+          unsigned                              numberOfPointsForApproximation,
+          bool                                  extensible = false)
     : m_representer(representer)
     , m_kernel(kernel)
     , m_numEigenfunctions(numEigenfunctions)
+    , m_supportRadius(kernel.GetSupportRadius())
+    , m_usePointIds(kernel.AcceptsPointIdsOf(representer->GetDomain()))
+    , m_extensible(extensible)
   {
     DomainType domain = m_representer->GetDomain();
-    m_nystromPoints = GetNystromPoints(domain, numberOfPointsForApproximation);
-    auto numDomainPoints = domain.GetNumberOfPoints();
+    m_domainPoints = domain.GetDomainPoints();
+    m_numDomainPoints = domain.GetNumberOfPoints();
+    m_shuffledPointIds = GetShuffledPointIds(domain);
 
-    // compute a eigenvalue decomposition of the kernel matrix, evaluated at the points used for the
-    // nystrom approximation
+    AddNystromPoints(numberOfPointsForApproximation);
+    ComputeDecomposition(numEigenfunctions);
 
-    MatrixType U; // will hold the eigenvectors (principal components)
-    VectorType D; // will hold the eigenvalues (variance)
-    ComputeKernelMatrixDecomposition(&m_kernel, m_nystromPoints, numEigenfunctions, U, D);
+    if (!m_extensible)
+    {
+      // the kernel matrix is only needed to extend the approximation
+      m_kernelMatrix.resize(0, 0);
+      m_kernelTriplets = std::vector<Eigen::Triplet<double>>{};
+    }
+  }
 
-    // precompute the part of the nystrom approximation, which is independent of the domain point
-    float normFactor = static_cast<float>(m_nystromPoints.size()) / static_cast<float>(numDomainPoints);
-    m_nystromMatrix =
-      std::sqrt(normFactor) * (U.leftCols(numEigenfunctions) * D.topRows(numEigenfunctions).asDiagonal().inverse());
+  /**
+   * \brief Get the ids of the points of the domain in random order
+   *
+   * The points used for the approximation are taken from the front of this list.
+   */
+  std::vector<unsigned>
+  GetShuffledPointIds(DomainType & domain) const
+  {
+    std::vector<unsigned> shuffledIds(domain.GetNumberOfPoints());
+    std::iota(std::begin(shuffledIds), std::end(shuffledIds), 0);
+    std::shuffle(std::begin(shuffledIds), std::end(shuffledIds), statismo::rand::RandGen());
 
-    m_eigenvalues = (1.0f / normFactor) * D.topRows(numEigenfunctions);
+    return shuffledIds;
   }
 
   /**
-   * \brief Get a random set of points from the domain
-   * \param domain the domain to sample from
-   * \param numberOfPoints the size of the sample
+   * \brief Add the next points of the shuffled domain points until \a numberOfPoints are used
+   * and extend the kernel matrix accordingly
    */
-  std::vector<PointType>
-  GetNystromPoints(DomainType & domain, std::size_t numberOfPoints) const
+  void
+  AddNystromPoints(std::size_t numberOfPoints)
   {
-    numberOfPoints = std::min(numberOfPoints, domain.GetNumberOfPoints());
+    numberOfPoints = std::min(numberOfPoints, m_shuffledPointIds.size());
+    auto numOldPoints = m_nystromPoints.size();
+    if (numberOfPoints <= numOldPoints)
+    {
+      return;
+    }
 
-    std::vector<PointType> shuffledDomainPoints = domain.GetDomainPoints();
-    std::shuffle(std::begin(shuffledDomainPoints), std::end(shuffledDomainPoints), statismo::rand::RandGen());
-    shuffledDomainPoints.resize(numberOfPoints);
+    for (auto i = numOldPoints; i < numberOfPoints; ++i)
+    {
+      m_nystromPointIds.push_back(m_shuffledPointIds[i]);
+      m_nystromPoints.push_back(m_domainPoints[m_shuffledPointIds[i]]);
+    }
 
-    return shuffledDomainPoints;
+    BuildNystromPointIndex();
+    if (m_nystromPointIndex)
+    {
+      ExtendSparseKernelMatrix(numOldPoints);
+    }
+    else
+    {
+      ExtendKernelMatrix(numOldPoints);
+    }
   }
 
+  /**
+   * \brief Index the Nystrom points if the kernel has a compact support
+   *
+   * For compactly supported kernels, only the pairs of points that are closer than
+   * the support radius interact. They are found with a spatial index.
+   */
+  void
+  BuildNystromPointIndex()
+  {
+    if (std::isfinite(m_supportRadius) && m_supportRadius > 0)
+    {
+      SpatialIndex::PointListType pts;
+      pts.reserve(m_nystromPoints.size());
+      for (const auto & pt : m_nystromPoints)
+      {
+        pts.push_back(m_representer->PointToVector(pt));
+      }
+      m_nystromPointIndex = std::make_unique<SpatialIndex>(std::move(pts), m_supportRadius);
+    }
+  }
 
   /**
-   * \brief Compute the kernel matrix for all points given in \a xs and
-   * return a matrix \a U with the first \a numComponents eigenvectors and a vector \a D with
-   * the corresponding eigenvalues of this \a kernel matrix
+   * \brief Evaluate the rows and columns of the kernel matrix of the Nystrom points that
+   * belong to the points from \a numOldPoints on
    */
   void
-  ComputeKernelMatrixDecomposition(const MatrixValuedKernel<PointType> * kernel,
-                                   const std::vector<PointType> &        xs,
-                                   unsigned                              numComponents,
-                                   MatrixType &                          U,
-                                   VectorType &                          D) const
+  ExtendKernelMatrix(std::size_t numOldPoints)
   {
-    unsigned kernelDim = kernel->GetDimension();
+    unsigned kernelDim = m_kernel.GetDimension();
+    auto     n = m_nystromPoints.size();
+
+    m_kernelMatrix.conservativeResize(n * kernelDim, n * kernelDim);
 
-    auto                      n = xs.size();
-    MatrixTypeDoublePrecision K = MatrixTypeDoublePrecision::Zero(n * kernelDim, n * kernelDim);
-    for (unsigned i = 0; i < n; ++i)
+    MatrixType k_xixj(kernelDim, kernelDim);
+    for (auto i = static_cast<unsigned>(numOldPoints); i < n; ++i)
     {
-      for (unsigned j = i; j < n; ++j)
+      for (unsigned j = 0; j <= i; ++j)
       {
-        MatrixType k_xixj = (*kernel)(xs[i], xs[j]);
+        EvaluateKernelAtNystromPoints(i, j, k_xixj);
         for (unsigned d1 = 0; d1 < kernelDim; d1++)
         {
           for (unsigned d2 = 0; d2 < kernelDim; d2++)
           {
             double elem_d1d2 = k_xixj(d1, d2);
-            K(i * kernelDim + d1, j * kernelDim + d2) = elem_d1d2;
-            K(j * kernelDim + d2, i * kernelDim + d1) = elem_d1d2;
+            m_kernelMatrix(i * kernelDim + d1, j * kernelDim + d2) = elem_d1d2;
+            m_kernelMatrix(j * kernelDim + d2, i * kernelDim + d1) = elem_d1d2;
           }
         }
+        if (i == j)
+        {
+          m_kernelTrace += k_xixj.trace();
+        }
       }
     }
+  }
+
+  /**
+   * \brief Same as ExtendKernelMatrix, but the kernel matrix is assembled as a sparse
+   * matrix, where only the pairs of points within the support radius of the kernel are evaluated
+   */
+  void
+  ExtendSparseKernelMatrix(std::size_t numOldPoints)
+  {
+    unsigned kernelDim = m_kernel.GetDimension();
+    auto     n = m_nystromPoints.size();
+
+    MatrixType k_xixj(kernelDim, kernelDim);
+    for (auto i = static_cast<unsigned>(numOldPoints); i < n; ++i)
+    {
+      m_nystromPointIndex->ForEachPointInRadius(
+        m_representer->PointToVector(m_nystromPoints[i]), m_supportRadius, [&](unsigned j) {
+          // the pair (j, i) is handled together with (i, j)
+          if (j > i)
+          {
+            return;
+          }
+
+          EvaluateKernelAtNystromPoints(i, j, k_xixj);
+          for (unsigned d1 = 0; d1 < kernelDim; d1++)
+          {
+            for (unsigned d2 = 0; d2 < kernelDim; d2++)
+            {
+              if (k_xixj(d1, d2) != 0)
+              {
+                m_kernelTriplets.emplace_back(i * kernelDim + d1, j * kernelDim + d2, k_xixj(d1, d2));
+                if (i != j)
+                {
+                  m_kernelTriplets.emplace_back(j * kernelDim + d2, i * kernelDim + d1, k_xixj(d1, d2));
+                }
+              }
+            }
+          }
+          if (i == j)
+          {
+            m_kernelTrace += k_xixj.trace();
+          }
+        });
+    }
+  }
+
+  /**
+   * \brief Compute the first \a numEigenfunctions eigenvectors and eigenvalues of the kernel matrix
+   * and the part of the nystrom approximation, which is independent of the domain point
+   */
+  void
+  ComputeDecomposition(unsigned numEigenfunctions)
+  {
+    unsigned kernelDim = m_kernel.GetDimension();
+    auto     n = m_nystromPoints.size();
+
+    MatrixType U; // will hold the eigenvectors (principal components)
+    VectorType D; // will hold the eigenvalues (variance)
 
     using SVDType = RandSVD<double>;
-    SVDType svd(K, numComponents * kernelDim);
-    U = svd.MatrixU().cast<ScalarType>();
-    D = svd.SingularValues().cast<ScalarType>();
+    if (m_nystromPointIndex)
+    {
+      Eigen::SparseMatrix<double> K(n * kernelDim, n * kernelDim);
+      K.setFromTriplets(std::begin(m_kernelTriplets), std::end(m_kernelTriplets));
+      SVDType svd(K, numEigenfunctions * kernelDim);
+      U = svd.MatrixU().cast<ScalarType>();
+      D = svd.SingularValues().cast<ScalarType>();
+    }
+    else
+    {
+      SVDType svd(m_kernelMatrix, numEigenfunctions * kernelDim);
+      U = svd.MatrixU().cast<ScalarType>();
+      D = svd.SingularValues().cast<ScalarType>();
+    }
+
+    float normFactor = static_cast<float>(n) / static_cast<float>(m_numDomainPoints);
+    m_nystromMatrix =
+      std::sqrt(normFactor) * (U.leftCols(numEigenfunctions) * D.topRows(numEigenfunctions).asDiagonal().inverse());
+
+    m_computedEigenvalues = (1.0f / normFactor) * D.topRows(numEigenfunctions);
+    SetNumberOfEigenfunctions(numEigenfunctions);
+  }
+
+  /**
+   * \brief Evaluate the kernel at the Nystrom points \a i and \a j
+   */
+  void
+  EvaluateKernelAtNystromPoints(unsigned i, unsigned j, Eigen::Ref<MatrixType> res) const
+  {
+    if (m_usePointIds)
+    {
+      m_kernel.EvaluateAtDomainPoints(
+        m_nystromPoints[i], m_nystromPointIds[i], m_nystromPoints[j], m_nystromPointIds[j], res);
+    }
+    else
+    {
+      m_kernel.Evaluate(m_nystromPoints[i], m_nystromPoints[j], res);
+    }
   }
 
+  /**
+   * \brief Write the kernel blocks k(pt, x_1), ..., k(pt, x_m) of the Nystrom points into the
+   * rows of \a kx starting at \a row
+   * \param pt point
+   * \param ptId id of \a pt in the domain, or sk_noPointId if it is not known
+   */
+  void
+  ComputeKernelBlocksAtPoint(const PointType & pt, long ptId, MatrixType & kx, Eigen::Index row) const
+  {
+    unsigned kernelDim = m_kernel.GetDimension();
+
+    auto setBlock = [&](unsigned j) {
+      auto block = kx.block(row, j * kernelDim, kernelDim, kernelDim);
+      if (m_usePointIds && ptId != sk_noPointId)
+      {
+        m_kernel.EvaluateAtDomainPoints(
+          pt, static_cast<unsigned>(ptId), m_nystromPoints[j], m_nystromPointIds[j], block);
+      }
+      else
+      {
+        m_kernel.Evaluate(pt, m_nystromPoints[j], block);
+      }
+    };
+
+    if (m_nystromPointIndex)
+    {
+      // the kernel is zero for all the other points
+      kx.middleRows(row, kernelDim).setZero();
+      m_nystromPointIndex->ForEachPointInRadius(m_representer->PointToVector(pt), m_supportRadius, setBlock);
+    }
+    else
+    {
+      for (unsigned j = 0; j < m_nystromPoints.size(); j++)
+      {
+        setBlock(j);
+      }
+    }
+  }
+
+  static constexpr long sk_noPointId = -1;
+
   const Representer<T> *                m_representer;
   MatrixType                            m_nystromMatrix;
   VectorType                            m_eigenvalues;
+  VectorType                            m_computedEigenvalues;
+  std::vector<PointType>                m_domainPoints;
+  std::size_t                           m_numDomainPoints{ 0 };
+  std::vector<unsigned>                 m_shuffledPointIds;
   std::vector<PointType>                m_nystromPoints;
+  std::vector<unsigned>                 m_nystromPointIds;
   const MatrixValuedKernel<PointType> & m_kernel;
   unsigned                              m_numEigenfunctions;
+  double                                m_supportRadius;
+  bool                                  m_usePointIds;
+  bool                                  m_extensible;
+  MatrixTypeDoublePrecision             m_kernelMatrix;
+  std::vector<Eigen::Triplet<double>>   m_kernelTriplets;
+  double                                m_kernelTrace{ 0 };
+  std::unique_ptr<SpatialIndex>         m_nystromPointIndex;
 };
 
 } // namespace statismo
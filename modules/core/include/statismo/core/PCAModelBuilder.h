@@ -38,6 +38,7 @@
 #ifndef __STATIMO_CORE_PCA_MODEL_BUILDER_H_
 #define __STATIMO_CORE_PCA_MODEL_BUILDER_H_
 
+#include "statismo/core/BuildCheckpoint.h"
 #include "statismo/core/CommonTypes.h"
 #include "statismo/core/Config.h"
 #include "statismo/core/DataManager.h"
@@ -46,6 +47,7 @@
 #include "statismo/core/StatisticalModel.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace statismo
@@ -97,16 +99,44 @@ public:
                 bool                     computeScores = true,
                 EigenValueMethod         method = EigenValueMethod::JACOBI_SVD) const;
 
+  /**
+   * \brief Set the checkpoint in which the intermediate results of the builds are stored
+   *
+   * The Gram matrix of the samples is accumulated over blocks of samples (or of variables),
+   * and the partial sums are stored, so that an interrupted build resumes from them when it
+   * is run again with the same checkpoint file.
+   * \param checkpoint checkpoint (nullptr disables checkpointing)
+   */
+  void
+  SetCheckpoint(SharedPtrType<BuildCheckpoint> checkpoint)
+  {
+    m_checkpoint = std::move(checkpoint);
+  }
 
 private:
+  // Number of samples (or variables) added to the Gram matrix between two checkpoints
+  static constexpr unsigned sk_gramBlockSize = 256;
+
   PCAModelBuilder() = default;
 
+  /**
+   * \brief Compute the Gram matrix X0 X0^T (if \a inner is true) or X0^T X0
+   */
+  MatrixType
+  ComputeGramMatrix(const MatrixType &                     matX0,
+                    bool                                   inner,
+                    EigenValueMethod                       method,
+                    const details::BuildProgressReporter & progress) const;
+
   UniquePtrType<StatisticalModelType>
-  BuildNewModelInternal(const Representer<T> * representer,
-                        const MatrixType &     matX0,
-                        const VectorType &     mu,
-                        double                 noiseVariance,
-                        EigenValueMethod       method = EigenValueMethod::JACOBI_SVD) const;
+  BuildNewModelInternal(const Representer<T> *                 representer,
+                        const MatrixType &                     matX0,
+                        const VectorType &                     mu,
+                        double                                 noiseVariance,
+                        const details::BuildProgressReporter & progress,
+                        EigenValueMethod                       method = EigenValueMethod::JACOBI_SVD) const;
+
+  SharedPtrType<BuildCheckpoint> m_checkpoint;
 };
 
 } // namespace statismo
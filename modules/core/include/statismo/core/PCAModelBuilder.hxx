@@ -45,6 +45,10 @@
 #include <Eigen/SVD>
 #include <Eigen/Eigenvalues>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 namespace statismo
 {
 
@@ -68,6 +72,9 @@ PCAModelBuilder<T>::BuildNewModel(const DataItemListType & sampleDataList,
                                     Status::BAD_INPUT_ERROR);
   }
 
+  auto progress = this->CreateProgressReporter();
+  progress.Report("Sample matrix", 0, 1);
+
   unsigned     p = sampleDataList.front()->GetSampleVector().rows();
   const auto * representer = sampleDataList.front()->GetRepresenter();
 
@@ -91,14 +98,19 @@ PCAModelBuilder<T>::BuildNewModel(const DataItemListType & sampleDataList,
     matX0.row(i++) = item->GetSampleVector() - mu;
   }
 
+  progress.Report("Sample matrix", 1, 1);
+
   // build the model
-  auto model = BuildNewModelInternal(representer, matX0, mu, noiseVariance, method);
+  auto model = BuildNewModelInternal(representer, matX0, mu, noiseVariance, progress, method);
+  progress.Report("Decomposition", 1, 1);
 
   // compute the scores if requested
   MatrixType scores;
   if (computeScores)
   {
+    progress.Report("Scores", 0, 1);
     scores = this->ComputeScores(sampleDataList, model.get());
+    progress.Report("Scores", 1, 1);
   }
 
   typename BuilderInfo::ParameterInfoList bi;
@@ -126,11 +138,12 @@ PCAModelBuilder<T>::BuildNewModel(const DataItemListType & sampleDataList,
 
 template <typename T>
 UniquePtrType<typename PCAModelBuilder<T>::StatisticalModelType>
-PCAModelBuilder<T>::BuildNewModelInternal(const Representer<T> * representer,
-                                          const MatrixType &     matX0,
-                                          const VectorType &     mu,
-                                          double                 noiseVariance,
-                                          EigenValueMethod       method) const
+PCAModelBuilder<T>::BuildNewModelInternal(const Representer<T> *                 representer,
+                                          const MatrixType &                     matX0,
+                                          const VectorType &                     mu,
+                                          double                                 noiseVariance,
+                                          const details::BuildProgressReporter & progress,
+                                          EigenValueMethod                       method) const
 {
   unsigned n = matX0.rows();
   unsigned p = matX0.cols();
@@ -158,7 +171,8 @@ PCAModelBuilder<T>::BuildNewModelInternal(const Representer<T> * representer,
       {
         // we compute the eigenvectors of the covariance matrix by computing an SVD of the
         // n x n inner product matrix 1/(n-1) X0X0^T
-        MatrixType             cov = matX0 * matX0.transpose() * 1.0 / (n - 1);
+        MatrixType cov = ComputeGramMatrix(matX0, true, method, progress) * 1.0 / (n - 1);
+        progress.Report("Decomposition", 0, 1);
         SVDDoublePrecisionType svd(cov.cast<double>(), Eigen::ComputeThinV);
         VectorType             singularValues = svd.singularValues().cast<ScalarType>();
         MatrixType             matV = svd.matrixV().cast<ScalarType>();
@@ -205,7 +219,9 @@ PCAModelBuilder<T>::BuildNewModelInternal(const Representer<T> * representer,
       else // NOLINT
       {
         // we compute an SVD of the full p x p  covariance matrix 1/(n-1) X0^TX0 directly
-        SVDType    svd(matX0.transpose() * matX0, Eigen::ComputeThinU);
+        MatrixType gram = ComputeGramMatrix(matX0, false, method, progress);
+        progress.Report("Decomposition", 0, 1);
+        SVDType    svd(gram, Eigen::ComputeThinU);
         VectorType singularValues = svd.singularValues();
         singularValues /= (n - 1.0);
         unsigned numComponentsToKeep =
@@ -234,7 +250,9 @@ PCAModelBuilder<T>::BuildNewModelInternal(const Representer<T> * representer,
 
       using SelfAdjointEigenSolver = Eigen::SelfAdjointEigenSolver<MatrixType>;
       SelfAdjointEigenSolver es;
-      es.compute(matX0.transpose() * matX0);
+      MatrixType             gram = ComputeGramMatrix(matX0, false, method, progress);
+      progress.Report("Decomposition", 0, 1);
+      es.compute(gram);
       VectorType eigenValues =
         es.eigenvalues().reverse(); // SelfAdjointEigenSolver orders the eigenvalues in increasing order
       eigenValues /= (n - 1.0);
@@ -261,6 +279,85 @@ PCAModelBuilder<T>::BuildNewModelInternal(const Representer<T> * representer,
   return nullptr;
 }
 
+template <typename T>
+MatrixType
+PCAModelBuilder<T>::ComputeGramMatrix(const MatrixType &                     matX0,
+                                      bool                                   inner,
+                                      EigenValueMethod                       method,
+                                      const details::BuildProgressReporter & progress) const
+{
+  if (!m_checkpoint)
+  {
+    progress.Report("Gram matrix", 0, 1);
+    MatrixType gram = inner ? MatrixType(matX0 * matX0.transpose()) : MatrixType(matX0.transpose() * matX0);
+    progress.Report("Gram matrix", 1, 1);
+    return gram;
+  }
+
+  // the products of blocks of columns (resp. rows) of X0 are summed up, and the
+  // partial sum is stored with the index of the next block
+  auto dim = inner ? matX0.rows() : matX0.cols();
+  auto numItems = inner ? matX0.cols() : matX0.rows();
+
+  std::string buildKey = "PCAModelBuilder;method=" + std::to_string(static_cast<int>(method)) +
+                         ";inner=" + std::to_string(inner) + ";blockSize=" + std::to_string(sk_gramBlockSize) +
+                         ";rows=" + std::to_string(matX0.rows()) + ";cols=" + std::to_string(matX0.cols()) +
+                         ";data=" + std::to_string(BuildCheckpoint::HashMatrix(matX0));
+
+  MatrixType gram;
+  unsigned   nextItem = 0;
+  if (m_checkpoint->Begin(buildKey) && m_checkpoint->Exists("gram"))
+  {
+    STATISMO_LOG_INFO("Resuming build from checkpoint " + m_checkpoint->GetFilename());
+
+    std::vector<unsigned> next;
+    m_checkpoint->ReadMatrix<ScalarType>("gram", gram);
+    m_checkpoint->ReadIndices("gramNextItem", next);
+    nextItem = next.at(0);
+  }
+  else
+  {
+    gram = MatrixType::Zero(dim, dim);
+  }
+
+  auto saveState = [&](Eigen::Index next) {
+    m_checkpoint->WriteMatrix<ScalarType>("gram", gram);
+    m_checkpoint->WriteIndices("gramNextItem", { static_cast<unsigned>(next) });
+    m_checkpoint->Flush();
+  };
+
+  progress.Report("Gram matrix", nextItem, numItems);
+  for (Eigen::Index item = nextItem; item < numItems; item += sk_gramBlockSize)
+  {
+    auto size = std::min<Eigen::Index>(sk_gramBlockSize, numItems - item);
+    if (inner)
+    {
+      gram.noalias() += matX0.middleCols(item, size) * matX0.middleCols(item, size).transpose();
+    }
+    else
+    {
+      gram.noalias() += matX0.middleRows(item, size).transpose() * matX0.middleRows(item, size);
+    }
+
+    if (item + size == numItems || m_checkpoint->IsDue())
+    {
+      saveState(item + size);
+    }
+
+    try
+    {
+      progress.Report("Gram matrix", item + size, numItems);
+    }
+    catch (const StatisticalModelException &)
+    {
+      // a cancelled build can be resumed from the blocks added so far
+      saveState(item + size);
+      throw;
+    }
+  }
+
+  return gram;
+}
 
 } // namespace statismo
 
@@ -42,11 +42,61 @@
 #include "statismo/core/CommonTypes.h"
 #include "statismo/core/PCAModelBuilder.h"
 
+#include <Eigen/Cholesky>
 #include <Eigen/SVD>
 
 namespace statismo
 {
 
+namespace details
+{
+/*
+ * Create the posterior model from the MAP coefficients and the posterior covariance M^-1 of the coefficients of
+ * the prior model. The posterior model is derived from the prior, i.e. it shares its mean and basis.
+ * If computeScores is set, the scores of the prior are mapped to the posterior model and stored in its ModelInfo
+ * together with the builder info of the prior.
+ */
+template <typename T>
+UniquePtrType<StatisticalModel<T>>
+CreatePosteriorModel(const StatisticalModel<T> *       priorModel,
+                     const VectorType &                coeffs,
+                     const MatrixTypeDoublePrecision & matMInverse,
+                     double                            noiseVariance,
+                     bool                              computeScores)
+{
+  VectorType D2 = priorModel->GetPCAVarianceVector();
+  // the values of D2 can be negative. We need to be careful when taking the root
+  VectorTypeDoublePrecision D2Sqrt = D2.cwiseMax(static_cast<ScalarType>(0)).array().sqrt().cast<double>();
+
+  using SVDType = Eigen::JacobiSVD<MatrixTypeDoublePrecision>;
+  MatrixTypeDoublePrecision innerMatrix = D2Sqrt.asDiagonal() * matMInverse * D2Sqrt.asDiagonal();
+  SVDType                   svd(innerMatrix, Eigen::ComputeThinU);
+
+  // SVD of the inner matrix: the orthonormal basis of the posterior is U_c = U svd.matrixU(), where U is
+  // the orthonormal basis of the prior, and its mean is the MAP solution in the sample space
+  VectorType D_c = svd.singularValues().cast<ScalarType>();
+  auto       posteriorModel =
+    StatisticalModel<T>::SafeCreate(priorModel, coeffs, svd.matrixU().cast<ScalarType>(), D_c, noiseVariance);
+
+  const MatrixType & inputScores = priorModel->GetModelInfo().GetScoresMatrix();
+  MatrixType         scores = MatrixType::Zero(inputScores.rows(), inputScores.cols());
+  if (computeScores && inputScores.cols() > 0)
+  {
+    // A training sample x = mu + U D s of the prior model has the posterior coefficients
+    // M_c^-1 W_c^T (x - mu_c) with W_c = U_c D_c^1/2 and mu_c = mu + U D coeffs (D = D2^1/2).
+    // As U and svd.matrixU() are orthonormal, M_c = D_c + rho2 I and W_c^T (x - mu_c) = D_c^1/2 svd.matrixU()^T D
+    // (s - coeffs), so that all the scores are obtained by a single k x k transform.
+    VectorTypeDoublePrecision scale =
+      D_c.cast<double>().array().sqrt() / (D_c.cast<double>().array() + noiseVariance);
+    MatrixTypeDoublePrecision scoreTransform = scale.asDiagonal() * svd.matrixU().transpose() * D2Sqrt.asDiagonal();
+    scores = (scoreTransform * (inputScores.colwise() - coeffs).cast<double>()).cast<ScalarType>();
+  }
+  posteriorModel->SetModelInfo(ModelInfo{ scores, priorModel->GetModelInfo().GetBuilderInfoList() });
+
+  return posteriorModel;
+}
+} // namespace details
+
 //
 // PosteriorModelBuilder
 //
@@ -108,6 +158,7 @@ PosteriorModelBuilder<T>::BuildNewModel(const DataItemListType &
   STATISMO_LOG_INFO("Building new model");
   using PCAModelBuilderType = PCAModelBuilder<T>;
   auto modelBuilder = PCAModelBuilderType::SafeCreate();
+  modelBuilder->SetProgressCallback(this->GetProgressCallback());
   auto model = modelBuilder->BuildNewModel(sampleDataList, noiseVariance);
   auto PosteriorModel = BuildNewModelFromModel(model.get(), pointValuesWithCovariance, noiseVariance);
   return PosteriorModel;
@@ -121,82 +172,29 @@ PosteriorModelBuilder<T>::BuildNewModelFromModel(const StatisticalModelType *
                                                  bool                                     computeScores) const
 {
   STATISMO_LOG_INFO("Building new model from model");
-  const RepresenterType * representer = inputModel->GetRepresenter();
+  auto progress = this->CreateProgressReporter();
+  progress.Report("Posterior", 0, 1);
 
-  const MatrixType & Q = inputModel->GetPCABasisMatrix();
-  const VectorType & mu = inputModel->GetMeanVector();
+  const RepresenterType * representer = inputModel->GetRepresenter();
 
   // this method only makes sense for a proper PPCA model (e.g. the noise term is properly defined)
   // if the model has zero noise, we assume a small amount of noise
   double rho2 = std::max((double)inputModel->GetNoiseVariance(), (double)Superclass::sk_tolerance);
   auto   dim = representer->GetDimensions();
 
-  // build the part matrices considering only the points that are fixed
-  auto       numPrincipalComponents = inputModel->GetNumberOfPrincipalComponents();
-  MatrixType Q_g(pointValuesWithCovariance.size() * dim, numPrincipalComponents);
-  VectorType mu_g(pointValuesWithCovariance.size() * dim);
-  VectorType s_g(pointValuesWithCovariance.size() * dim);
-
-  MatrixType LQ_g(pointValuesWithCovariance.size() * dim, numPrincipalComponents);
-
-  unsigned i{ 0 };
-  for (const auto & item : pointValuesWithCovariance)
-  {
-    VectorType val = representer->PointSampleToPointSampleVector(item.first.second);
-    unsigned   pt_id = representer->GetPointIdForPoint(item.first.first);
-
-    // In the formulas, we actually need the precision matrix, which is the inverse of the covariance.
-    const MatrixType pointPrecisionMatrix = item.second.inverse();
+  // the system of the MAP coefficients, assembled from the points that are fixed
+  MatrixTypeDoublePrecision M;
+  VectorTypeDoublePrecision rhs;
+  inputModel->ComputePointValuesSystem(pointValuesWithCovariance, M, rhs);
 
-    // Get the three rows pertaining to this point:
-    const MatrixType Qrows_for_pt_id = Q.block(pt_id * dim, 0, dim, numPrincipalComponents);
-
-    Q_g.block(i * dim, 0, dim, numPrincipalComponents) = Qrows_for_pt_id;
-    mu_g.block(i * dim, 0, dim, 1) = mu.block(pt_id * dim, 0, dim, 1);
-    s_g.block(i * dim, 0, dim, 1) = val;
-
-    LQ_g.block(i * dim, 0, dim, numPrincipalComponents) = pointPrecisionMatrix * Qrows_for_pt_id;
-    i++;
-  }
-
-  VectorType         D2 = inputModel->GetPCAVarianceVector().array();
-  const MatrixType & Q_gT = Q_g.transpose();
-
-  MatrixType M = Q_gT * LQ_g;
-  M.diagonal() += VectorType::Ones(Q_g.cols());
-
-  MatrixTypeDoublePrecision Minv = M.cast<double>().inverse();
+  MatrixTypeDoublePrecision Minv = M.inverse();
 
   // the MAP solution for the latent variables (coefficients)
-  VectorType coeffs = Minv.cast<ScalarType>() * LQ_g.transpose() * (s_g - mu_g);
-
-  // the MAP solution in the sample space
-  VectorType mu_c = inputModel->GetRepresenter()->SampleToSampleVector(inputModel->DrawSample(coeffs));
-
-  const VectorType &        pcaVariance = inputModel->GetPCAVarianceVector();
-  VectorTypeDoublePrecision pcaSdev = pcaVariance.cast<double>().array().sqrt();
-
-  VectorType D2MinusRho = D2 - VectorType::Ones(D2.rows()) * rho2;
-  // the values of D2 can be negative. We need to be careful when taking the root
-  for (i = 0; i < D2MinusRho.rows(); i++)
-  {
-    D2MinusRho(i) = std::max((ScalarType)0, D2(i));
-  }
-  VectorType D2MinusRhoSqrt = D2MinusRho.array().sqrt();
+  VectorType coeffs = (Minv * rhs).cast<ScalarType>();
 
-
-  using SVDType = Eigen::JacobiSVD<MatrixTypeDoublePrecision>;
-  MatrixTypeDoublePrecision innerMatrix =
-    D2MinusRhoSqrt.cast<double>().asDiagonal() * Minv * D2MinusRhoSqrt.cast<double>().asDiagonal();
-  SVDType svd(innerMatrix, Eigen::ComputeThinU);
-
-  // SVD of the inner matrix
-  VectorType D_c = svd.singularValues().cast<ScalarType>();
-
-  // Todo: Maybe it is possible to do this with Q, so that we don"t need to get U as well.
-  MatrixType U_c = inputModel->GetOrthonormalPCABasisMatrix() * svd.matrixU().cast<ScalarType>();
-
-  auto PosteriorModel = StatisticalModelType::SafeCreate(representer, mu_c, U_c, D_c, rho2);
+  // the scores are part of the posterior stage, as they are computed with the posterior model
+  auto PosteriorModel = details::CreatePosteriorModel(inputModel, coeffs, Minv, rho2, computeScores);
+  progress.Report("Posterior", 1, 1);
 
   // Write the parameters used to build the models into the builderInfo
 
@@ -232,22 +230,7 @@ PosteriorModelBuilder<T>::BuildNewModelFromModel(const StatisticalModelType *
 
   builderInfoList.emplace_back("PosteriorModelBuilder", di, bi);
 
-  MatrixType inputScores = inputModel->GetModelInfo().GetScoresMatrix();
-  MatrixType scores = MatrixType::Zero(inputScores.rows(), inputScores.cols());
-
-  if (computeScores)
-  {
-    // get the scores from the input model
-    for (i = 0; i < inputScores.cols(); i++)
-    {
-      // reconstruct the sample from the input model and project it back into the model
-      auto ds = inputModel->DrawSample(inputScores.col(i));
-      scores.col(i) = PosteriorModel->ComputeCoefficients(ds);
-      representer->DeleteDataset(ds);
-    }
-  }
-
-  PosteriorModel->SetModelInfo(ModelInfo{ scores, builderInfoList });
+  PosteriorModel->SetModelInfo(ModelInfo{ PosteriorModel->GetModelInfo().GetScoresMatrix(), builderInfoList });
 
   return PosteriorModel;
 }
@@ -42,6 +42,7 @@
 
 #include <Eigen/Dense>
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <random>
@@ -58,27 +59,24 @@ public:
   using VectorType = Eigen::Matrix<ScalarType, Eigen::Dynamic, 1>;
   using MatrixType = Eigen::Matrix<ScalarType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
 
-  RandSVD(const MatrixType & A, unsigned k)
+  /**
+   * \brief Compute the k leading singular vectors of \a A
+   *
+   * \a A is only used through matrix products, so that it can also be a sparse matrix.
+   */
+  template <typename TMatrix>
+  RandSVD(const TMatrix & A, unsigned k)
   {
     unsigned n = A.rows();
 
-    static std::normal_distribution<> dist(0, 1);
-    static auto                       r = std::bind(dist, rand::RandGen());
-
-    // create gaussian random amtrix
-    MatrixType Omega(n, k);
-    for (unsigned i = 0; i < n; i++)
-    {
-      for (unsigned j = 0; j < k; j++)
-      {
-        Omega(i, j) = r();
-      }
-    }
+    MatrixType Omega = GaussianRandomMatrix(n, k);
 
+    // the products are evaluated from the right, such that no n x n matrix is formed
+    MatrixType Y = A * MatrixType(A.transpose() * MatrixType(A * Omega));
 
-    MatrixType                              Y = A * A.transpose() * A * Omega;
-    Eigen::FullPivHouseholderQR<MatrixType> qr(Y);
-    MatrixType                              Q = qr.matrixQ().leftCols(k + k);
+    // thin Q factor of the QR decomposition
+    Eigen::HouseholderQR<MatrixType> qr(Y);
+    MatrixType                       Q = qr.householderQ() * MatrixType::Identity(n, std::min(n, k + k));
 
     MatrixType B = Q.transpose() * A;
 
@@ -103,6 +101,24 @@ public:
 
 
 private:
+  // the generator is shared by all the instantiations of the constructor
+  static MatrixType
+  GaussianRandomMatrix(unsigned rows, unsigned cols)
+  {
+    static std::normal_distribution<> dist(0, 1);
+    static auto                       r = std::bind(dist, rand::RandGen());
+
+    MatrixType omega(rows, cols);
+    for (unsigned i = 0; i < rows; i++)
+    {
+      for (unsigned j = 0; j < cols; j++)
+      {
+        omega(i, j) = r();
+      }
+    }
+    return omega;
+  }
+
   VectorType m_D;
   MatrixType m_U;
 };
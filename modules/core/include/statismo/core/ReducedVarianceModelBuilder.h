@@ -69,6 +69,8 @@ public:
    * \brief Build a new model from the given model, which retains only the leading principal components
    * \param model statistical model
    * \param numberOfPrincipalComponents number of components to keep
+   * \note The new model shares the mean and the basis of \a model (see StatisticalModel::IsDerived), only the
+   * variances and the scores are copied.
    */
   UniquePtrType<StatisticalModelType>
   BuildNewModelWithLeadingComponents(const StatisticalModelType * model, unsigned numberOfPrincipalComponents) const;
@@ -56,12 +56,9 @@ ReducedVarianceModelBuilder<T>::BuildNewModelWithLeadingComponents(const Statist
   STATISMO_LOG_INFO("Building new model");
   STATISMO_LOG_INFO("Number of principal components: " + std::to_string(numberOfPrincipalComponents));
 
-  auto reducedModel =
-    StatisticalModelType::SafeCreate(inputModel->GetRepresenter(),
-                                     inputModel->GetMeanVector(),
-                                     inputModel->GetOrthonormalPCABasisMatrix().leftCols(numberOfPrincipalComponents),
-                                     inputModel->GetPCAVarianceVector().topRows(numberOfPrincipalComponents),
-                                     inputModel->GetNoiseVariance());
+  // the reduced model is a view on the leading components of the input model, which shares its basis
+  numberOfPrincipalComponents = std::min(numberOfPrincipalComponents, inputModel->GetNumberOfPrincipalComponents());
+  auto reducedModel = StatisticalModelType::SafeCreate(inputModel, numberOfPrincipalComponents);
 
   // Write the parameters used to build the models into the builderInfo
   typename ModelInfo::BuilderInfoList builderInfoList = inputModel->GetModelInfo().GetBuilderInfoList();
@@ -47,6 +47,7 @@
 #include <H5Cpp.h>
 #include <string>
 #include <memory>
+#include <vector>
 
 /**
  * \defgroup Representers Representers classes and routines
@@ -362,6 +363,20 @@ public:
   virtual void
   Save(const H5::Group & fg) const = 0;
 
+  /**
+   * \brief Create a representer of the given points of this representer
+   *
+   * The point i of the new representer is the point pointIds[i] of this representer. It is used to load the
+   * model of a region of interest (see IO::LoadStatisticalModelForPoints).
+   * \warning Not all representers can be restricted to a subset of their points, the default implementation throws
+   */
+  virtual Representer *
+  CloneForPoints([[maybe_unused]] const std::vector<unsigned> & pointIds) const
+  {
+    throw StatisticalModelException("The representer cannot be restricted to a subset of its points",
+                                    Status::NOT_IMPLEMENTED_ERROR);
+  }
+
   ///@}
 
   /**
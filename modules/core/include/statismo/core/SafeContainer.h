@@ -39,10 +39,12 @@
 #include "statismo/core/CommonTypes.h"
 #include "statismo/core/NonCopyable.h"
 
+#include <array>
 #include <unordered_map>
 #include <queue>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
 #include <memory>
 #include <condition_variable>
 
@@ -108,6 +110,87 @@ private:
   mutable std::mutex m_guard;
 };
 
+/**
+ * \brief Thread safe unordered map for read-mostly workloads
+ *
+ * The keys are distributed over several shards, each one guarded by its own
+ * reader/writer lock. Concurrent lookups do not block each other, and writers
+ * only block the accesses to their shard.
+ *
+ * \note The interface is the same as the one of SafeUnorderedMap
+ *
+ * \ingroup Core
+ */
+template <class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>, std::size_t N = 16>
+class SafeShardedUnorderedMap : public NonCopyable
+{
+public:
+  using ValueType = std::pair<const Key, T>;
+
+  void
+  Insert(const ValueType & value)
+  {
+    auto &                              shard = GetShard(value.first);
+    std::unique_lock<std::shared_mutex> l{ shard.guard };
+    shard.map.insert(value);
+  }
+
+  std::size_t
+  Size() const
+  {
+    std::size_t size = 0;
+    for (const auto & shard : m_shards)
+    {
+      std::shared_lock<std::shared_mutex> l{ shard.guard };
+      size += shard.map.size();
+    }
+    return size;
+  }
+
+  bool
+  Empty() const
+  {
+    return Size() == 0;
+  }
+
+  bool
+  Find(const Key & key, T & value) const
+  {
+    const auto &                        shard = GetShard(key);
+    std::shared_lock<std::shared_mutex> l{ shard.guard };
+    auto                                got = shard.map.find(key);
+
+    if (got == std::cend(shard.map))
+    {
+      return false;
+    }
+
+    value = got->second;
+    return true;
+  }
+
+private:
+  struct Shard
+  {
+    std::unordered_map<Key, T, Hash, KeyEqual> map;
+    mutable std::shared_mutex                  guard;
+  };
+
+  Shard &
+  GetShard(const Key & key)
+  {
+    return m_shards[Hash{}(key) % N];
+  }
+
+  const Shard &
+  GetShard(const Key & key) const
+  {
+    return m_shards[Hash{}(key) % N];
+  }
+
+  std::array<Shard, N> m_shards;
+};
+
 /**
  * \brief Thread safe queue
  * \note Implementation taken from "C++ concurrency in action", A. Williams
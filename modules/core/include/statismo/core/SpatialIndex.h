@@ -0,0 +1,170 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __STATIMO_CORE_SPATIAL_INDEX_H_
+#define __STATIMO_CORE_SPATIAL_INDEX_H_
+
+#include "statismo/core/CommonTypes.h"
+#include "statismo/core/Hash.h"
+
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+namespace statismo
+{
+
+/**
+ * \brief Uniform grid index to find the points lying within a given radius
+ *
+ * The points are bucketed in cubic cells. A radius query only visits the cells
+ * overlapping the bounding box of the query ball, hence the cell size should be
+ * of the order of the typical query radius.
+ *
+ * \ingroup Core
+ */
+class SpatialIndex
+{
+public:
+  using PointListType = std::vector<VectorType>;
+
+  /**
+   * \brief Create an index over \a points (all points must have the same dimension)
+   * \param points points to index
+   * \param cellSize edge length of the cells
+   */
+  SpatialIndex(PointListType points, double cellSize)
+    : m_points(std::move(points))
+    , m_cellSize(cellSize)
+  {
+    for (unsigned i = 0; i < m_points.size(); ++i)
+    {
+      m_cells[CellOf(m_points[i])].push_back(i);
+    }
+  }
+
+  /**
+   * \brief Call \a f with the index of every point whose distance to \a pt is at most \a radius
+   */
+  template <typename F>
+  void
+  ForEachPointInRadius(const VectorType & pt, double radius, F && f) const
+  {
+    if (m_points.empty())
+    {
+      return;
+    }
+
+    auto       dim = pt.size();
+    const auto kReach = static_cast<CellType::Scalar>(std::ceil(radius / m_cellSize));
+    const auto kRadius2 = radius * radius;
+
+    CellType center = CellOf(pt);
+    CellType cell = center.array() - kReach;
+
+    // odometer over the box of cells [center - reach, center + reach]
+    while (true)
+    {
+      auto it = m_cells.find(cell);
+      if (it != std::end(m_cells))
+      {
+        for (auto i : it->second)
+        {
+          if ((m_points[i] - pt).squaredNorm() <= kRadius2)
+          {
+            f(i);
+          }
+        }
+      }
+
+      Eigen::Index d = 0;
+      for (; d < dim; ++d)
+      {
+        if (cell(d) < center(d) + kReach)
+        {
+          ++cell(d);
+          break;
+        }
+        cell(d) = center(d) - kReach;
+      }
+      if (d == dim)
+      {
+        break;
+      }
+    }
+  }
+
+  /**
+   * \brief Return the indices of the points whose distance to \a pt is at most \a radius
+   */
+  std::vector<unsigned>
+  FindPointsInRadius(const VectorType & pt, double radius) const
+  {
+    std::vector<unsigned> res;
+    ForEachPointInRadius(pt, radius, [&res](unsigned i) { res.push_back(i); });
+    return res;
+  }
+
+  /**
+   * \brief Return the number of indexed points
+   */
+  std::size_t
+  GetNumberOfPoints() const
+  {
+    return m_points.size();
+  }
+
+private:
+  using CellType = Eigen::Matrix<long, Eigen::Dynamic, 1>;
+
+  CellType
+  CellOf(const VectorType & pt) const
+  {
+    CellType cell(pt.size());
+    for (Eigen::Index d = 0; d < pt.size(); ++d)
+    {
+      cell(d) = static_cast<long>(std::floor(pt(d) / m_cellSize));
+    }
+    return cell;
+  }
+
+  PointListType                                                       m_points;
+  double                                                              m_cellSize;
+  std::unordered_map<CellType, std::vector<unsigned>, Hash<CellType>> m_cells;
+};
+
+} // namespace statismo
+
+#endif
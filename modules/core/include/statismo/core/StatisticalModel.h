@@ -47,6 +47,8 @@
 #include "statismo/core/Logger.h"
 
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace statismo
@@ -283,6 +285,16 @@ public:
    */
   MatrixType
   GetCovarianceAtPoint(unsigned ptId1, unsigned ptId2) const;
+
+  /**
+   * \brief Compute the covariance in the model between the points ptId1 and ptId2, without any allocation if the
+   * representer stores the components of a point in consecutive rows
+   * \param ptId1 point 1
+   * \param ptId2 point 2
+   * \param cov d x d matrix that receives the covariance
+   */
+  void
+  ComputeCovarianceAtPoint(unsigned ptId1, unsigned ptId2, Eigen::Ref<MatrixType> cov) const;
   ///@}
 
 
@@ -388,6 +400,22 @@ public:
     const PointValueWithCovarianceListType & pointValuesWithCovariance) const;
 
 
+  /**
+   * \brief Compute the linear system of the MAP coefficients given point values with covariances
+   * \param pointValuesWithCovariance A list with PointValuePairs and PointCovarianceMatrices
+   * \param matM is set to \f$I + Q_g^T L Q_g\f$, where \f$Q_g\f$ are the rows of the PCA basis at the given points
+   * and \f$L\f$ the block diagonal matrix of the point precisions (inverse covariances)
+   * \param rhs is set to \f$Q_g^T L (s_g - \mu_g)\f$
+   *
+   * The point covariances of 2D and 3D models are handled as fixed-size matrices with closed-form inverses.
+   * The system is assembled from the whitened basis rows, without forming \f$L Q_g\f$.
+   * \warning This is for library internal use only
+   */
+  void
+  ComputePointValuesSystem(const PointValueWithCovarianceListType & pointValuesWithCovariance,
+                           MatrixTypeDoublePrecision &              matM,
+                           VectorTypeDoublePrecision &              rhs) const;
+
   /**
    * \brief Version with point indices
    * \param pointIdValueList list with (Point,Value) pairs, a list of (PointId, Value) is provided
@@ -424,6 +452,8 @@ public:
    * \f$p\f$ points, the returned mean vector \f$m\f$ has dimensionality \f$m \in \mathbf{R}^{dp} \f$, i.e.
    * the \f$d\f$ components are stacked into the vector. The order of the components in the vector is
    * undefined and depends on the representer.
+   *
+   * \note For a derived model (see IsDerived), the mean is computed on the first call.
    * */
   const VectorType &
   GetMeanVector() const;
@@ -436,10 +466,29 @@ public:
    * \f$n\f$ points, the returned matrix \f$W\f$ has dimensionality \f$W \in \mathbf{R}^{dp \times n} \f$, i.e.
    * the \f$d\f$ components are stacked into the matrix. The order of the components in the matrix is
    * undefined and depends on the representer.
+   *
+   * \note For a derived model (see IsDerived), the matrix is computed on the first call and then kept
+   * in memory, which is what derived models avoid. Prefer methods such as DrawSampleVector or GetJacobian.
    */
   const MatrixType &
   GetPCABasisMatrix() const;
 
+  /**
+   * \brief Return true if the model is derived from another model
+   *
+   * Models built from another model (e.g. posterior or reduced models) share the mean and PCA basis of
+   * the model they were built from. They only store a small k x k' transform of the basis and the
+   * coefficients of their mean, and evaluate samples, projections and covariances in this factorized form.
+   * Reduced models of an explicit model do not even need a transform: they are a view on the leading
+   * columns of the shared basis. The explicit basis is only computed when it is requested, e.g. when the
+   * model is saved.
+   */
+  bool
+  IsDerived() const
+  {
+    return m_isDerived;
+  }
+
 
   /**
    * \brief Get the PCA Matrix, but with its principal axis normalized to unit length
@@ -449,6 +498,15 @@ public:
   MatrixType
   GetOrthonormalPCABasisMatrix() const;
 
+  /**
+   * \brief Compute the rows [firstRow, firstRow + numRows) of the orthonormal PCA basis into \a rows
+   *
+   * It allows to process the orthonormal basis in blocks of rows (e.g. to save a model), without computing the
+   * whole matrix as GetOrthonormalPCABasisMatrix does.
+   */
+  void
+  ComputeOrthonormalPCABasisRows(unsigned firstRow, unsigned numRows, Eigen::Ref<MatrixType> rows) const;
+
 
   /**
    * \brief Get an instance for the given coefficients as a vector
@@ -514,20 +572,74 @@ private:
    * \brief Create an instance of the StatisticalModel
    * \param representer an instance of the representer, used to convert the samples to dataset of the represented type.
    */
-  StatisticalModel(const RepresenterType * representer,
-                   VectorType              m,
-                   const MatrixType &      orthonormalPCABasis,
-                   VectorType              pcaVariance,
-                   double                  noiseVariance);
+  StatisticalModel(const RepresenterType *              representer,
+                   VectorType                           m,
+                   const Eigen::Ref<const MatrixType> & orthonormalPCABasis,
+                   VectorType                           pcaVariance,
+                   double                               noiseVariance);
+
+
+  /**
+   * \brief Create a model derived from \a parentModel, which shares the mean and basis of the parent
+   * \param meanCoefficients coefficients of the mean of the new model in the parent model
+   * \param orthonormalTransform k x k' matrix R, such that the orthonormal basis of the new model is U R, where
+   * U is the orthonormal basis of the parent
+   * \param pcaVariance variance of the k' components of the new model
+   */
+  StatisticalModel(const StatisticalModel * parentModel,
+                   const VectorType &       meanCoefficients,
+                   const MatrixType &       orthonormalTransform,
+                   VectorType               pcaVariance,
+                   double                   noiseVariance);
+
+  /**
+   * \brief Create a model that keeps the leading \a numberOfComponents components of \a parentModel
+   *
+   * The model is a view on the leading columns of the basis of the parent, only the variances are copied.
+   */
+  StatisticalModel(const StatisticalModel * parentModel, unsigned numberOfComponents);
+
+  template <int Dim>
+  void
+  ComputePointValuesSystemImpl(const PointValueWithCovarianceListType & pointValuesWithCovariance,
+                               MatrixTypeDoublePrecision &              matM,
+                               VectorTypeDoublePrecision &              rhs) const;
 
+  // maps the coefficients of the model to the coefficients of the basis stored in m_pcaBasisMatrix
+  VectorType
+  ToRootCoefficients(const VectorType & coefficients) const;
+
+  // the columns of m_pcaBasisMatrix that are used by the model
+  typename MatrixType::ConstColsBlockXpr
+  GetSharedBasis() const;
+
+  // the rows [firstRow, firstRow + numRows) of the mean and of the basis
+  VectorType
+  GetMeanRows(unsigned firstRow, unsigned numRows) const;
+  MatrixType
+  GetBasisRows(unsigned firstRow, unsigned numRows) const;
 
   const RepresenterType * m_representer;
-  VectorType              m_mean;
-  MatrixType              m_pcaBasisMatrix;
-  VectorType              m_pcaVariance;
-  float                   m_noiseVariance;
+  // The mean and the basis are shared with the models derived from this one. A derived model stores them
+  // implicitly, with respect to the mean and basis of the model it was derived from (the root):
+  // mean = m_mean + B * m_meanOffset and basis = B * m_basisTransform, where B are the leading
+  // m_numberOfBasisColumns columns of m_pcaBasisMatrix. Without a transform, the basis is B itself.
+  SharedPtrType<const VectorType> m_mean;
+  SharedPtrType<const MatrixType> m_pcaBasisMatrix;
+  VectorType                      m_pcaVariance;
+  float                           m_noiseVariance;
+  bool                            m_isDerived{ false };
+  bool                            m_hasBasisTransform{ false };
+  unsigned                        m_numberOfBasisColumns{ 0 };
+  VectorType                      m_meanOffset;
+  MatrixType                      m_basisTransform;
+  // explicit mean and basis of a derived model, computed when they are requested
+  mutable std::once_flag m_flatMeanFlag;
+  mutable VectorType     m_flatMean;
+  mutable std::once_flag m_flatBasisFlag;
+  mutable MatrixType     m_flatBasis;
   // caching
-  mutable bool m_cachedValuesValid;
+  mutable std::once_flag m_matMInverseFlag;
   // the matrix M^{-1} in Bishops PRML book. This is roughly the Latent Covariance matrix (but not exactly)
   mutable MatrixType m_matMInverse;
   ModelInfo          m_modelInfo;
@@ -42,31 +42,104 @@
 #include "statismo/core/ModelBuilder.h"
 #include "statismo/core/StatisticalModel.h"
 
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+
+#include <cassert>
 #include <cmath>
 #include <fstream>
 #include <string>
+#include <vector>
 
 namespace statismo
 {
 
 template <typename T>
-StatisticalModel<T>::StatisticalModel(const RepresenterType * representer,
-                                      VectorType              m,
-                                      const MatrixType &      orthonormalPCABasis,
-                                      VectorType              pcaVariance,
-                                      double                  noiseVariance)
+StatisticalModel<T>::StatisticalModel(const RepresenterType *              representer,
+                                      VectorType                           m,
+                                      const Eigen::Ref<const MatrixType> & orthonormalPCABasis,
+                                      VectorType                           pcaVariance,
+                                      double                               noiseVariance)
   : m_representer(representer->CloneSelf())
-  , m_mean(std::move(m))
+  , m_mean(std::make_shared<const VectorType>(std::move(m)))
   , m_pcaVariance(std::move(pcaVariance))
   , m_noiseVariance(noiseVariance)
-  , m_cachedValuesValid(false)
 {
   VectorType d = m_pcaVariance.array().sqrt();
-  m_pcaBasisMatrix = orthonormalPCABasis * DiagMatrixType(d);
+  m_pcaBasisMatrix = std::make_shared<const MatrixType>(orthonormalPCABasis * DiagMatrixType(d));
+  m_numberOfBasisColumns = m_pcaBasisMatrix->cols();
 
   this->SetLogger(m_representer->GetLogger());
 }
 
+template <typename T>
+StatisticalModel<T>::StatisticalModel(const StatisticalModel * parentModel,
+                                      const VectorType &       meanCoefficients,
+                                      const MatrixType &       orthonormalTransform,
+                                      VectorType               pcaVariance,
+                                      double                   noiseVariance)
+  : m_representer(parentModel->m_representer->CloneSelf())
+  , m_mean(parentModel->m_mean)
+  , m_pcaBasisMatrix(parentModel->m_pcaBasisMatrix)
+  , m_pcaVariance(std::move(pcaVariance))
+  , m_noiseVariance(noiseVariance)
+{
+  this->SetLogger(m_representer->GetLogger());
+  m_isDerived = true;
+  m_hasBasisTransform = true;
+  m_numberOfBasisColumns = parentModel->m_numberOfBasisColumns;
+
+  auto numParentComponents = parentModel->GetNumberOfPrincipalComponents();
+  if (meanCoefficients.size() != numParentComponents || orthonormalTransform.rows() != numParentComponents ||
+      orthonormalTransform.cols() != m_pcaVariance.size())
+  {
+    STATISMO_LOG_ERROR("Bad dimensions of the derived model");
+    throw StatisticalModelException("Incompatible dimensions for a derived model", Status::INVALID_DATA_ERROR);
+  }
+
+  // The orthonormal basis of the parent is U_p = W_p D_p^-1/2, hence
+  // W = U_p R D^1/2 = W_p (D_p^-1/2 R D^1/2)
+  VectorType parentSdevInverse =
+    parentModel->m_pcaVariance.array().sqrt().unaryExpr([](ScalarType v) { return v > 0 ? 1 / v : 0; });
+  VectorType sdev = m_pcaVariance.array().sqrt();
+  MatrixType transform = parentSdevInverse.asDiagonal() * orthonormalTransform * sdev.asDiagonal();
+
+  m_meanOffset = parentModel->ToRootCoefficients(meanCoefficients);
+  m_basisTransform =
+    parentModel->m_hasBasisTransform ? MatrixType(parentModel->m_basisTransform * transform) : transform;
+}
+
+template <typename T>
+StatisticalModel<T>::StatisticalModel(const StatisticalModel * parentModel, unsigned numberOfComponents)
+  : m_representer(parentModel->m_representer->CloneSelf())
+  , m_mean(parentModel->m_mean)
+  , m_pcaBasisMatrix(parentModel->m_pcaBasisMatrix)
+  , m_noiseVariance(parentModel->m_noiseVariance)
+{
+  this->SetLogger(m_representer->GetLogger());
+
+  if (numberOfComponents > parentModel->GetNumberOfPrincipalComponents())
+  {
+    STATISMO_LOG_ERROR("Bad number of components");
+    throw StatisticalModelException("The number of components exceeds the number of components of the model",
+                                    Status::OUT_OF_RANGE_ERROR);
+  }
+
+  m_isDerived = true;
+  m_pcaVariance = parentModel->m_pcaVariance.topRows(numberOfComponents);
+  m_hasBasisTransform = parentModel->m_hasBasisTransform;
+  if (m_hasBasisTransform)
+  {
+    m_numberOfBasisColumns = parentModel->m_numberOfBasisColumns;
+    m_meanOffset = parentModel->m_meanOffset;
+    m_basisTransform = parentModel->m_basisTransform.leftCols(numberOfComponents);
+  }
+  else
+  {
+    m_numberOfBasisColumns = numberOfComponents;
+  }
+}
+
 
 template <typename T>
 StatisticalModel<T>::~StatisticalModel()
@@ -159,7 +232,11 @@ StatisticalModel<T>::DrawPCABasisSample(const unsigned pcaComponentIndex) const
   }
 
 
-  return m_representer->SampleVectorToSample(m_pcaBasisMatrix.col(pcaComponentIndex));
+  if (m_hasBasisTransform)
+  {
+    return m_representer->SampleVectorToSample(GetSharedBasis() * m_basisTransform.col(pcaComponentIndex));
+  }
+  return m_representer->SampleVectorToSample(m_pcaBasisMatrix->col(pcaComponentIndex));
 }
 
 
@@ -175,7 +252,7 @@ StatisticalModel<T>::DrawSampleVector(const VectorType & coefficients, bool addN
     throw StatisticalModelException("Incorrect number of coefficients provided");
   }
 
-  unsigned vectorSize = this->m_mean.size();
+  unsigned vectorSize = m_mean->size();
   assert(vectorSize != 0);
 
   VectorType epsilon = VectorType::Zero(vectorSize);
@@ -185,7 +262,7 @@ StatisticalModel<T>::DrawSampleVector(const VectorType & coefficients, bool addN
   }
 
 
-  return m_mean + m_pcaBasisMatrix * coefficients + epsilon;
+  return *m_mean + GetSharedBasis() * ToRootCoefficients(coefficients) + epsilon;
 }
 
 
@@ -210,14 +287,15 @@ StatisticalModel<T>::DrawSampleAtPoint(const VectorType & coefficients, const un
   {
     epsilon = utils::GenerateNormalVector(dim) * sqrt(m_noiseVariance);
   }
+  VectorType rootCoefficients = ToRootCoefficients(coefficients);
   for (unsigned d = 0; d < dim; d++)
   {
     unsigned idx = m_representer->MapPointIdToInternalIdx(ptId, d);
 
-    if (idx >= m_mean.rows())
+    if (idx >= m_mean->rows())
     {
       STATISMO_LOG_DEBUG("Index: " + std::to_string(idx));
-      STATISMO_LOG_DEBUG("Mean rows count: " + std::to_string(m_mean.rows()));
+      STATISMO_LOG_DEBUG("Mean rows count: " + std::to_string(m_mean->rows()));
       STATISMO_LOG_ERROR("Invalid index");
 
       std::ostringstream os;
@@ -226,7 +304,7 @@ StatisticalModel<T>::DrawSampleAtPoint(const VectorType & coefficients, const un
       throw StatisticalModelException(os.str().c_str());
     }
 
-    v[d] = m_mean[idx] + m_pcaBasisMatrix.row(idx).dot(coefficients) + epsilon[d];
+    v[d] = (*m_mean)[idx] + GetSharedBasis().row(idx).dot(rootCoefficients) + epsilon[d];
   }
 
   return this->m_representer->PointSampleVectorToPointSample(v);
@@ -249,31 +327,57 @@ StatisticalModel<T>::GetCovarianceAtPoint(unsigned ptId1, unsigned ptId2) const
 {
   unsigned   dim = m_representer->GetDimensions();
   MatrixType cov(dim, dim);
+  ComputeCovarianceAtPoint(ptId1, ptId2, cov);
+  return cov;
+}
+
+template <typename T>
+void
+StatisticalModel<T>::ComputeCovarianceAtPoint(unsigned ptId1, unsigned ptId2, Eigen::Ref<MatrixType> cov) const
+{
+  unsigned dim = m_representer->GetDimensions();
+  unsigned firstRow1 = m_representer->MapPointIdToInternalIdx(ptId1, 0);
+  unsigned firstRow2 = m_representer->MapPointIdToInternalIdx(ptId2, 0);
 
-  for (unsigned i = 0; i < dim; i++)
+  // the standard representers store the d rows of a point contiguously (see RepresenterBase), but a representer
+  // can define its own mapping
+  bool contiguous = true;
+  for (unsigned d = 1; d < dim && contiguous; ++d)
   {
-    unsigned   idxi = m_representer->MapPointIdToInternalIdx(ptId1, i);
-    VectorType vi = m_pcaBasisMatrix.row(idxi);
-    for (unsigned j = 0; j < dim; j++)
+    contiguous = m_representer->MapPointIdToInternalIdx(ptId1, d) == firstRow1 + d &&
+                 m_representer->MapPointIdToInternalIdx(ptId2, d) == firstRow2 + d;
+  }
+
+  if (!contiguous)
+  {
+    MatrixType rows1(dim, GetNumberOfPrincipalComponents());
+    MatrixType rows2(dim, GetNumberOfPrincipalComponents());
+    for (unsigned d = 0; d < dim; ++d)
     {
-      unsigned   idxj = m_representer->MapPointIdToInternalIdx(ptId2, j);
-      VectorType vj = m_pcaBasisMatrix.row(idxj);
-      cov(i, j) = vi.dot(vj);
-      if (i == j)
-      {
-        cov(i, j) += m_noiseVariance;
-      }
+      rows1.row(d) = GetBasisRows(m_representer->MapPointIdToInternalIdx(ptId1, d), 1);
+      rows2.row(d) = GetBasisRows(m_representer->MapPointIdToInternalIdx(ptId2, d), 1);
     }
+    cov.noalias() = rows1 * rows2.transpose();
   }
-  return cov;
+  else if (m_hasBasisTransform)
+  {
+    cov.noalias() = GetBasisRows(firstRow1, dim) * GetBasisRows(firstRow2, dim).transpose();
+  }
+  else
+  {
+    auto basis = GetSharedBasis();
+    cov.noalias() = basis.middleRows(firstRow1, dim) * basis.middleRows(firstRow2, dim).transpose();
+  }
+  cov.diagonal().array() += m_noiseVariance;
 }
 
 template <typename T>
 MatrixType
 StatisticalModel<T>::GetCovarianceMatrix() const
 {
-  MatrixType matM = m_pcaBasisMatrix * m_pcaBasisMatrix.transpose();
-  matM.diagonal() += m_noiseVariance * VectorType::Ones(m_pcaBasisMatrix.rows());
+  const MatrixType & matW = GetPCABasisMatrix();
+  MatrixType         matM = matW * matW.transpose();
+  matM.diagonal() += m_noiseVariance * VectorType::Ones(matW.rows());
   return matM;
 }
 
@@ -292,9 +396,19 @@ StatisticalModel<T>::ComputeCoefficientsForSampleVector(const VectorType & sampl
 
   CheckAndUpdateCachedParameters();
 
-  const MatrixType & matWT = m_pcaBasisMatrix.transpose();
+  VectorType residual = sample - *m_mean;
+  if (m_hasBasisTransform)
+  {
+    residual.noalias() -= GetSharedBasis() * m_meanOffset;
+  }
 
-  VectorType coeffs = m_matMInverse * (matWT * (sample - m_mean));
+  VectorType projection = GetSharedBasis().transpose() * residual;
+  if (m_hasBasisTransform)
+  {
+    projection = m_basisTransform.transpose() * projection;
+  }
+
+  VectorType coeffs = m_matMInverse * projection;
   return coeffs;
 }
 
@@ -336,8 +450,9 @@ StatisticalModel<T>::ComputeCoefficientsForPointIDValues(const PointIdValueListT
     unsigned   ptId = item.first;
     for (unsigned d = 0; d < dim; d++)
     {
-      pcaBasisPart.row(i * dim + d) = this->GetPCABasisMatrix().row(m_representer->MapPointIdToInternalIdx(ptId, d));
-      muPart[i * dim + d] = this->GetMeanVector()[m_representer->MapPointIdToInternalIdx(ptId, d)];
+      unsigned idx = m_representer->MapPointIdToInternalIdx(ptId, d);
+      pcaBasisPart.row(i * dim + d) = GetBasisRows(idx, 1);
+      muPart[i * dim + d] = GetMeanRows(idx, 1)[0];
       sample[i * dim + d] = val[d];
     }
     i++;
@@ -355,57 +470,123 @@ VectorType
 StatisticalModel<T>::ComputeCoefficientsForPointValuesWithCovariance(
   const PointValueWithCovarianceListType & pointValuesWithCovariance) const
 {
-
   // The naming of the variables correspond to those used in the paper
   // Posterior Shape Models,
   // Thomas Albrecht, Marcel Luethi, Thomas Gerig, Thomas Vetter
   //
-  const MatrixType & matQ = m_pcaBasisMatrix;
-  const VectorType & mu = m_mean;
-
-  unsigned dim = m_representer->GetDimensions();
+  MatrixTypeDoublePrecision matM;
+  VectorTypeDoublePrecision rhs;
+  ComputePointValuesSystem(pointValuesWithCovariance, matM, rhs);
 
-  // build the part matrices with , considering only the points that are fixed
-  //
-  unsigned   numPrincipalComponents = this->GetNumberOfPrincipalComponents();
-  MatrixType matQg(pointValuesWithCovariance.size() * dim, numPrincipalComponents);
-  VectorType mug(pointValuesWithCovariance.size() * dim);
-  VectorType sg(pointValuesWithCovariance.size() * dim);
+  // the MAP solution for the latent variables (coefficients)
+  VectorType coeffs = matM.ldlt().solve(rhs).cast<ScalarType>();
 
-  MatrixType matLQg(pointValuesWithCovariance.size() * dim, numPrincipalComponents);
+  return coeffs;
+}
 
-  unsigned i = 0;
-  for (const auto & item : pointValuesWithCovariance)
+template <typename T>
+void
+StatisticalModel<T>::ComputePointValuesSystem(const PointValueWithCovarianceListType & pointValuesWithCovariance,
+                                              MatrixTypeDoublePrecision &              matM,
+                                              VectorTypeDoublePrecision &              rhs) const
+{
+  switch (m_representer->GetDimensions())
   {
-    VectorType val = m_representer->PointSampleToPointSampleVector(item.first.second);
-    unsigned   ptId = m_representer->GetPointIdForPoint(item.first.first);
+    case 1:
+      ComputePointValuesSystemImpl<1>(pointValuesWithCovariance, matM, rhs);
+      break;
+    case 2:
+      ComputePointValuesSystemImpl<2>(pointValuesWithCovariance, matM, rhs);
+      break;
+    case 3:
+      ComputePointValuesSystemImpl<3>(pointValuesWithCovariance, matM, rhs);
+      break;
+    default:
+      ComputePointValuesSystemImpl<Eigen::Dynamic>(pointValuesWithCovariance, matM, rhs);
+      break;
+  }
+}
 
-    // In the formulas, we actually need the precision matrix, which is the inverse of the covariance.
-    const MatrixType kPointPrecisionMatrix = item.second.inverse();
+template <typename T>
+template <int Dim>
+void
+StatisticalModel<T>::ComputePointValuesSystemImpl(const PointValueWithCovarianceListType & pointValuesWithCovariance,
+                                                  MatrixTypeDoublePrecision &              matM,
+                                                  VectorTypeDoublePrecision &              rhs) const
+{
+  using PointMatrixType = Eigen::Matrix<double, Dim, Dim>;
 
-    // Get the three rows pertaining to this point:
-    const MatrixType kQrowsForPtId = matQ.block(ptId * dim, 0, dim, numPrincipalComponents);
+  unsigned dim = m_representer->GetDimensions();
+  auto     numRows = pointValuesWithCovariance.size() * dim;
 
-    matQg.block(i * dim, 0, dim, numPrincipalComponents) = kQrowsForPtId;
-    mug.block(i * dim, 0, dim, 1) = mu.block(ptId * dim, 0, dim, 1);
-    sg.block(i * dim, 0, dim, 1) = val;
+  // gather the rows of the points and the covariances, which are stored contiguously as fixed-size matrices
+  std::vector<Eigen::Index>    rows;
+  std::vector<PointMatrixType> whitening;
+  VectorTypeDoublePrecision    residuals(numRows);
+  rows.reserve(numRows);
+  whitening.reserve(pointValuesWithCovariance.size());
 
-    matLQg.block(i * dim, 0, dim, numPrincipalComponents) = kPointPrecisionMatrix * kQrowsForPtId;
-    i++;
-  }
+  for (const auto & item : pointValuesWithCovariance)
+  {
+    unsigned ptId = m_representer->GetPointIdForPoint(item.first.first);
+    if (item.second.rows() != dim || item.second.cols() != dim)
+    {
+      throw StatisticalModelException("The covariance of a point value must be a dim x dim matrix",
+                                      Status::INVALID_DATA_ERROR);
+    }
 
-  VectorType         d2 = m_pcaVariance.array();
-  const MatrixType & matQgT = matQg.transpose();
+    residuals.segment(rows.size(), dim) =
+      m_representer->PointSampleToPointSampleVector(item.first.second).template cast<double>();
+    for (unsigned d = 0; d < dim; d++)
+    {
+      unsigned idx = m_representer->MapPointIdToInternalIdx(ptId, d);
+      if (static_cast<Eigen::Index>(idx) >= m_mean->rows())
+      {
+        throw StatisticalModelException("Invalid point id in the point values", Status::OUT_OF_RANGE_ERROR);
+      }
+      rows.push_back(idx);
+    }
+    whitening.emplace_back(item.second.template cast<double>());
+  }
 
-  MatrixType matM = matQgT * matLQg;
-  matM.diagonal() += VectorType::Ones(matQg.cols());
+  // For 2x2 and 3x3 matrices, Eigen computes the inverse in closed form (cofactors). The rows of the basis and
+  // the residuals are then whitened with the factor C of the precision matrix L = C C^T, such that
+  // Q_g^T L Q_g = (C^T Q_g)^T (C^T Q_g).
+  for (auto & matC : whitening)
+  {
+    PointMatrixType precision = matC.inverse();
+    matC = precision.llt().matrixU();
+  }
 
-  MatrixTypeDoublePrecision matMinv = matM.cast<double>().inverse();
+  const auto                basis = GetSharedBasis();
+  MatrixTypeDoublePrecision matQg(rows.size(), basis.cols());
+  for (std::size_t i = 0; i < rows.size(); ++i)
+  {
+    matQg.row(i) = basis.row(rows[i]).template cast<double>();
+    residuals(i) -= static_cast<double>((*m_mean)(rows[i]));
+  }
+  if (m_hasBasisTransform)
+  {
+    residuals -= matQg * m_meanOffset.cast<double>();
+    matQg = matQg * m_basisTransform.cast<double>();
+  }
 
-  // the MAP solution for the latent variables (coefficients)
-  VectorType coeffs = matMinv.cast<ScalarType>() * matLQg.transpose() * (sg - mug);
+  for (std::size_t i = 0; i < whitening.size(); ++i)
+  {
+    const PointMatrixType & matCt = whitening[i];
+    auto                    firstRow = i * dim;
+    residuals.template segment<Dim>(firstRow, dim) = matCt * residuals.template segment<Dim>(firstRow, dim);
+    for (Eigen::Index j = 0; j < matQg.cols(); ++j)
+    {
+      matQg.col(j).template segment<Dim>(firstRow, dim) = matCt * matQg.col(j).template segment<Dim>(firstRow, dim);
+    }
+  }
 
-  return coeffs;
+  auto numComponents = GetNumberOfPrincipalComponents();
+  matM = MatrixTypeDoublePrecision::Identity(numComponents, numComponents);
+  matM.template selfadjointView<Eigen::Lower>().rankUpdate(matQg.transpose());
+  matM = matM.template selfadjointView<Eigen::Lower>();
+  rhs = matQg.transpose() * residuals;
 }
 
 
@@ -462,7 +643,12 @@ template <typename T>
 const VectorType &
 StatisticalModel<T>::GetMeanVector() const
 {
-  return m_mean;
+  if (!m_hasBasisTransform)
+  {
+    return *m_mean;
+  }
+  std::call_once(m_flatMeanFlag, [this]() { m_flatMean = *m_mean + GetSharedBasis() * m_meanOffset; });
+  return m_flatMean;
 }
 
 template <typename T>
@@ -477,19 +663,50 @@ template <typename T>
 const MatrixType &
 StatisticalModel<T>::GetPCABasisMatrix() const
 {
-  return m_pcaBasisMatrix;
+  if (!m_hasBasisTransform && m_numberOfBasisColumns == m_pcaBasisMatrix->cols())
+  {
+    return *m_pcaBasisMatrix;
+  }
+  std::call_once(m_flatBasisFlag, [this]() {
+    if (m_hasBasisTransform)
+    {
+      m_flatBasis = GetSharedBasis() * m_basisTransform;
+    }
+    else
+    {
+      m_flatBasis = GetSharedBasis();
+    }
+  });
+  return m_flatBasis;
 }
 
 template <typename T>
 MatrixType
 StatisticalModel<T>::GetOrthonormalPCABasisMatrix() const
 {
-  // we can recover the orthonormal matrix by undoing the scaling with the pcaVariance
-  // (c.f. the method SetParameters)
+  MatrixType orthonormalBasis(m_pcaBasisMatrix->rows(), GetNumberOfPrincipalComponents());
+  ComputeOrthonormalPCABasisRows(0, orthonormalBasis.rows(), orthonormalBasis);
+  return orthonormalBasis;
+}
 
+template <typename T>
+void
+StatisticalModel<T>::ComputeOrthonormalPCABasisRows(unsigned               firstRow,
+                                                    unsigned               numRows,
+                                                    Eigen::Ref<MatrixType> rows) const
+{
+  // we can recover the orthonormal matrix by undoing the scaling with the pcaVariance
   assert(m_pcaVariance.maxCoeff() > 1e-8);
   VectorType d = m_pcaVariance.array().sqrt();
-  return m_pcaBasisMatrix * DiagMatrixType(d).inverse();
+  if (m_hasBasisTransform)
+  {
+    // the explicit basis of a derived model is not computed
+    rows.noalias() = GetSharedBasis().middleRows(firstRow, numRows) * (m_basisTransform * DiagMatrixType(d).inverse());
+  }
+  else
+  {
+    rows.noalias() = GetSharedBasis().middleRows(firstRow, numRows) * DiagMatrixType(d).inverse();
+  }
 }
 
 
@@ -513,7 +730,7 @@ template <typename T>
 unsigned int
 StatisticalModel<T>::GetNumberOfPrincipalComponents() const
 {
-  return m_pcaBasisMatrix.cols();
+  return m_hasBasisTransform ? m_basisTransform.cols() : m_numberOfBasisColumns;
 }
 
 template <typename T>
@@ -537,10 +754,7 @@ StatisticalModel<T>::GetJacobian(unsigned ptId) const
   for (unsigned i = 0; i < dims; i++)
   {
     unsigned idx = m_representer->MapPointIdToInternalIdx(ptId, i);
-    for (unsigned j = 0; j < GetNumberOfPrincipalComponents(); j++)
-    {
-      matJ(i, j) += m_pcaBasisMatrix(idx, j);
-    }
+    matJ.row(i) += GetBasisRows(idx, 1);
   }
   return matJ;
 }
@@ -549,16 +763,59 @@ template <typename T>
 void
 StatisticalModel<T>::CheckAndUpdateCachedParameters() const
 {
-
-  if (!m_cachedValuesValid)
-  {
-    VectorType vI = VectorType::Ones(m_pcaBasisMatrix.cols());
-    MatrixType matM = m_pcaBasisMatrix.transpose() * m_pcaBasisMatrix;
+  // computed once, such that concurrent calls on a const model are safe
+  std::call_once(m_matMInverseFlag, [this]() {
+    VectorType vI = VectorType::Ones(GetNumberOfPrincipalComponents());
+    auto       basis = GetSharedBasis();
+    MatrixType matM = basis.transpose() * basis;
+    if (m_hasBasisTransform)
+    {
+      matM = m_basisTransform.transpose() * matM * m_basisTransform;
+    }
     matM.diagonal() += m_noiseVariance * vI;
 
     m_matMInverse = matM.inverse();
+  });
+}
+
+template <typename T>
+VectorType
+StatisticalModel<T>::ToRootCoefficients(const VectorType & coefficients) const
+{
+  if (!m_hasBasisTransform)
+  {
+    return coefficients;
+  }
+  return m_meanOffset + m_basisTransform * coefficients;
+}
+
+template <typename T>
+typename MatrixType::ConstColsBlockXpr
+StatisticalModel<T>::GetSharedBasis() const
+{
+  return m_pcaBasisMatrix->leftCols(m_numberOfBasisColumns);
+}
+
+template <typename T>
+VectorType
+StatisticalModel<T>::GetMeanRows(unsigned firstRow, unsigned numRows) const
+{
+  if (!m_hasBasisTransform)
+  {
+    return m_mean->segment(firstRow, numRows);
+  }
+  return m_mean->segment(firstRow, numRows) + GetSharedBasis().middleRows(firstRow, numRows) * m_meanOffset;
+}
+
+template <typename T>
+MatrixType
+StatisticalModel<T>::GetBasisRows(unsigned firstRow, unsigned numRows) const
+{
+  if (!m_hasBasisTransform)
+  {
+    return GetSharedBasis().middleRows(firstRow, numRows);
   }
-  m_cachedValuesValid = true;
+  return GetSharedBasis().middleRows(firstRow, numRows) * m_basisTransform;
 }
 
 } // namespace statismo
@@ -41,6 +41,9 @@
 #include "statismo/core/SafeContainer.h"
 #include "statismo/core/Exceptions.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <thread>
 #include <mutex>
 #include <deque>
@@ -227,10 +230,19 @@ private:
 class ThreadPool final : public NonCopyable
 {
 public:
+  /**
+   * \brief Behaviour of idle worker threads
+   *
+   * YIELD and WAIT_FOR keep polling the queues, which gives the lowest latency but
+   * burns cpu while the pool is idle. BLOCK puts idle workers to sleep until a task
+   * is submitted, which is the mode to use for long-lived pools shared between
+   * several computations.
+   */
   enum class WaitingMode
   {
     YIELD = 0,
-    WAIT_FOR = 1
+    WAIT_FOR = 1,
+    BLOCK = 2
   };
 
   using TaskType = FunctionWrapper;
@@ -239,7 +251,8 @@ public:
     : m_waitMode{ m }
     , m_waitTime{ waitTime }
   {
-    const auto kThreadCount = std::min(std::thread::hardware_concurrency(), maxThreads);
+    // hardware_concurrency may return 0 when the value is not computable
+    const auto kThreadCount = std::max(1U, std::min(std::thread::hardware_concurrency(), maxThreads));
 
     for (std::remove_cv_t<decltype(kThreadCount)> i = 0; i < kThreadCount; ++i)
     {
@@ -264,7 +277,23 @@ public:
     : ThreadPool{ maxThreads, WaitingMode::YIELD, 0 }
   {}
 
-  virtual ~ThreadPool() { m_isDone = true; } // NOLINT
+  virtual ~ThreadPool() // NOLINT
+  {
+    {
+      std::lock_guard<std::mutex> lock{ m_wakeMutex };
+      m_isDone = true;
+    }
+    m_wakeCond.notify_all();
+  }
+
+  /**
+   * \brief Get the number of worker threads
+   */
+  std::size_t
+  GetNumberOfThreads() const
+  {
+    return m_queues.size();
+  }
 
   template <typename F>
   std::future<std::invoke_result_t<F>>
@@ -282,6 +311,12 @@ public:
       m_poolQueue.Push(std::move(task));
     }
 
+    {
+      std::lock_guard<std::mutex> lock{ m_wakeMutex };
+      ++m_pendingTasks;
+    }
+    m_wakeCond.notify_one();
+
     return res;
   }
 
@@ -331,6 +366,7 @@ private:
 
     if (PopTaskFromLocalQueue(t) || PopTaskFromPoolQueue(t) || PopTaskFromOtherLocalQueues(t))
     {
+      --m_pendingTasks;
       t();
     }
     else
@@ -339,16 +375,24 @@ private:
       {
         std::this_thread::yield();
       }
-      else
+      else if (m_waitMode == WaitingMode::WAIT_FOR)
       {
         std::this_thread::sleep_for(std::chrono::milliseconds(m_waitTime));
       }
+      else
+      {
+        std::unique_lock<std::mutex> lock{ m_wakeMutex };
+        m_wakeCond.wait(lock, [this]() { return m_isDone || m_pendingTasks > 0; });
+      }
     }
   }
 
   std::atomic_bool                                m_isDone{ false };
   WaitingMode                                     m_waitMode{ WaitingMode::YIELD };
   unsigned                                        m_waitTime{ 0 };
+  std::atomic<long>                               m_pendingTasks{ 0 };
+  std::mutex                                      m_wakeMutex;
+  std::condition_variable                         m_wakeCond;
   SafeQueue<TaskType>                             m_poolQueue;
   std::vector<std::unique_ptr<WorkStealingQueue>> m_queues;
   std::vector<RaiiThread>                         m_threads;
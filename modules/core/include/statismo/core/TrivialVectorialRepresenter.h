@@ -47,6 +47,7 @@
 #include <H5Cpp.h>
 
 #include <memory>
+#include <vector>
 
 namespace statismo
 {
@@ -181,6 +182,15 @@ public:
     return point.ptId;
   }
 
+  TrivialVectorialRepresenter *
+  CloneForPoints(const std::vector<unsigned> & pointIds) const override
+  {
+    // the points are indices, which are renumbered
+    auto rep = TrivialVectorialRepresenter::Create(pointIds.size());
+    rep->SetLogger(this->GetLogger());
+    return rep;
+  }
+
 protected:
   static std::string
   GetNameImpl()
@@ -0,0 +1,153 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Author: Marcel Luethi (marcel.luethi@unibas.ch)
+ *
+ * Copyright (c) 2011 University of Basel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "statismo/core/MappedFile.h"
+#include "statismo/core/Exceptions.h"
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace statismo
+{
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string & filename)
+{
+  auto file = CreateFileA(
+    filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    throw StatisticalModelException(("could not open file " + filename).c_str(), Status::IO_ERROR);
+  }
+  m_fileHandle = file;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size))
+  {
+    CloseHandle(file);
+    throw StatisticalModelException(("could not get the size of file " + filename).c_str(), Status::IO_ERROR);
+  }
+  m_size = static_cast<std::size_t>(size.QuadPart);
+  if (m_size == 0)
+  {
+    return;
+  }
+
+  m_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mappingHandle != nullptr)
+  {
+    m_data = static_cast<const char *>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+  }
+  if (m_data == nullptr)
+  {
+    if (m_mappingHandle != nullptr)
+    {
+      CloseHandle(m_mappingHandle);
+    }
+    CloseHandle(file);
+    throw StatisticalModelException(("could not map file " + filename).c_str(), Status::IO_ERROR);
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_data != nullptr)
+  {
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mappingHandle);
+  }
+  CloseHandle(m_fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string & filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw StatisticalModelException(("could not open file " + filename).c_str(), Status::IO_ERROR);
+  }
+
+  struct stat fileStatus;
+  if (fstat(fd, &fileStatus) != 0)
+  {
+    close(fd);
+    throw StatisticalModelException(("could not get the size of file " + filename).c_str(), Status::IO_ERROR);
+  }
+  m_size = static_cast<std::size_t>(fileStatus.st_size);
+
+  if (m_size > 0)
+  {
+    // the mapping stays valid once the file is closed
+    int flags = MAP_PRIVATE;
+#  ifdef MAP_POPULATE
+    // the files are read completely, populating the mapping at once avoids a page fault per page
+    flags |= MAP_POPULATE;
+#  endif
+    void * data = mmap(nullptr, m_size, PROT_READ, flags, fd, 0);
+    if (data == MAP_FAILED) // NOLINT
+    {
+      close(fd);
+      throw StatisticalModelException(("could not map file " + filename).c_str(), Status::IO_ERROR);
+    }
+    m_data = static_cast<const char *>(data);
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_data != nullptr)
+  {
+    munmap(const_cast<char *>(m_data), m_size); // NOLINT
+  }
+}
+
+#endif
+
+} // namespace statismo
@@ -110,13 +110,13 @@ ModelInfo::Save(const H5::H5Location & publicFg) const
 }
 
 void
-ModelInfo::Load(const H5::H5Location & publicFg)
+ModelInfo::Load(const H5::H5Location & publicFg, ModelInfoLoadFlags flags)
 {
   using namespace H5;
   auto publicModelGroup = publicFg.openGroup("./modelinfo");
   try
   {
-    if (HDF5Utils::ExistsObjectWithName(publicModelGroup, "scores"))
+    if (HasFlag(flags, ModelInfoLoadFlags::SCORES) && HDF5Utils::ExistsObjectWithName(publicModelGroup, "scores"))
     {
       HDF5Utils::ReadMatrix(publicModelGroup, "./scores", m_scores);
     }
@@ -138,6 +138,11 @@ ModelInfo::Load(const H5::H5Location & publicFg)
   }
 
   m_builderInfo.clear();
+  if (!HasFlag(flags, ModelInfoLoadFlags::BUILDER_INFO))
+  {
+    return;
+  }
+
   auto numEntries = publicModelGroup.getNumObjs();
 
   for (unsigned i = 0; i < numEntries; i++)
@@ -236,17 +241,8 @@ BuilderInfo::Save(const H5::H5Location & modelBuilderGroup) const
     HDF5Utils::WriteString(modelBuilderGroup, "./builderName", m_modelBuilderName);
     HDF5Utils::WriteString(modelBuilderGroup, "./buildTime", m_buildtime);
 
-    auto dataInfoGroup = modelBuilderGroup.createGroup("./dataInfo");
-    for (const auto & it : m_dataInfo)
-    {
-      HDF5Utils::WriteString(dataInfoGroup, it.first.c_str(), it.second);
-    }
-
-    auto parameterGroup = modelBuilderGroup.createGroup("./parameters");
-    for (const auto & it : m_parameterInfo)
-    {
-      HDF5Utils::WriteString(parameterGroup, it.first.c_str(), it.second);
-    }
+    WriteKeyValueList(modelBuilderGroup, "./dataInfoList", m_dataInfo);
+    WriteKeyValueList(modelBuilderGroup, "./parameterList", m_parameterInfo);
   }
   catch (const H5::Exception & e)
   {
@@ -263,11 +259,21 @@ BuilderInfo::Load(const H5::H5Location & modelBuilderGroup)
   m_modelBuilderName = HDF5Utils::ReadString(modelBuilderGroup, "./builderName");
   m_buildtime = HDF5Utils::ReadString(modelBuilderGroup, "./buildTime");
 
-  auto dataInfoGroup = modelBuilderGroup.openGroup("./dataInfo");
-  FillKeyValueListFromInfoGroup(dataInfoGroup, m_dataInfo);
+  // files of version 0.9 and earlier hold a string dataset per entry; the layout is detected rather than read from
+  // the version, as the binary format carries the model info of converted files unchanged
+  if (HDF5Utils::ExistsObjectWithName(modelBuilderGroup, "dataInfoList"))
+  {
+    ReadKeyValueList(modelBuilderGroup, "./dataInfoList", m_dataInfo);
+    ReadKeyValueList(modelBuilderGroup, "./parameterList", m_parameterInfo);
+  }
+  else
+  {
+    auto dataInfoGroup = modelBuilderGroup.openGroup("./dataInfo");
+    FillKeyValueListFromInfoGroup(dataInfoGroup, m_dataInfo);
 
-  auto parameterGroup = modelBuilderGroup.openGroup("./parameters");
-  FillKeyValueListFromInfoGroup(parameterGroup, m_parameterInfo);
+    auto parameterGroup = modelBuilderGroup.openGroup("./parameters");
+    FillKeyValueListFromInfoGroup(parameterGroup, m_parameterInfo);
+  }
 }
 
 const BuilderInfo::DataInfoList &
@@ -295,5 +301,34 @@ BuilderInfo::FillKeyValueListFromInfoGroup(const H5::H5Location & group, KeyValu
   }
 }
 
+void
+BuilderInfo::WriteKeyValueList(const H5::H5Location & group, const char * name, const KeyValueList & keyValueList)
+{
+  std::vector<std::string> strings;
+  strings.reserve(2 * keyValueList.size());
+  for (const auto & it : keyValueList)
+  {
+    strings.push_back(it.first);
+    strings.push_back(it.second);
+  }
+  HDF5Utils::WriteStringList(group, name, strings);
+}
+
+void
+BuilderInfo::ReadKeyValueList(const H5::H5Location & group, const char * name, KeyValueList & keyValueList)
+{
+  auto strings = HDF5Utils::ReadStringList(group, name);
+  if (strings.size() % 2 != 0)
+  {
+    throw StatisticalModelException((std::string("Invalid key value list: ") + name).c_str(),
+                                    Status::INVALID_DATA_ERROR);
+  }
+
+  keyValueList.clear();
+  for (std::size_t i = 0; i < strings.size(); i += 2)
+  {
+    keyValueList.emplace_back(std::move(strings[i]), std::move(strings[i + 1]));
+  }
+}
 
 } // namespace statismo
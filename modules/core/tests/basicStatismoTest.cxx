@@ -36,18 +36,60 @@
  */
 
 #include "StatismoUnitTest.h"
+#include "statismo/core/BinaryModelIO.h"
+#include "statismo/core/BuildCheckpoint.h"
+#include "statismo/core/ConditionalModelBuilder.h"
 #include "statismo/core/Exceptions.h"
 
 #include "statismo/core/DataManager.h"
+#include "statismo/core/DataManagerWithSurrogates.h"
+#include "statismo/core/IncrementalPosteriorModel.h"
+#include "statismo/core/ModelCache.h"
 #include "statismo/core/PCAModelBuilder.h"
+#include "statismo/core/PosteriorModelBuilder.h"
+#include "statismo/core/ReducedVarianceModelBuilder.h"
 #include "statismo/core/StatisticalModel.h"
 #include "statismo/core/IO.h"
 #include "statismo/core/TrivialVectorialRepresenter.h"
+#include "statismo/core/Utils.h"
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <random>
+#include <thread>
 
 namespace
 {
+// fills a data manager with numSamples normally distributed samples, which are drawn from a generator seeded with seed
+statismo::UniquePtrType<statismo::BasicDataManager<statismo::VectorType>>
+CreateRandomDataManager(const statismo::TrivialVectorialRepresenter * representer,
+                        unsigned                                      numSamples,
+                        unsigned                                      seed = 0)
+{
+  auto dataManager = statismo::BasicDataManager<statismo::VectorType>::SafeCreate(representer);
+  auto dim = representer->GetDomain().GetNumberOfPoints();
+
+  std::minstd_rand                gen{ seed };
+  std::normal_distribution<float> dis;
+  for (unsigned i = 0; i < numSamples; ++i)
+  {
+    statismo::VectorType sample = statismo::VectorType::NullaryExpr(dim, [&]() { return dis(gen); });
+    dataManager->AddDataset(sample, "sample" + std::to_string(i));
+  }
+
+  return dataManager;
+}
+
+// builds a PCA model of the samples of CreateRandomDataManager
+statismo::UniquePtrType<statismo::StatisticalModel<statismo::VectorType>>
+BuildRandomModel(const statismo::TrivialVectorialRepresenter * representer, unsigned numSamples, unsigned seed = 0)
+{
+  auto dataManager = CreateRandomDataManager(representer, numSamples, seed);
+  return statismo::PCAModelBuilder<statismo::VectorType>::SafeCreate()->BuildNewModel(dataManager->GetData(), 0.1);
+}
+
 int
 Test1()
 {
@@ -86,6 +128,1136 @@ Test1()
 
   return EXIT_SUCCESS;
 }
+
+int
+TestPCACheckpoint()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using ModelBuilderType = statismo::PCAModelBuilder<statismo::VectorType>;
+
+  const std::string kFilename = "pcaModelBuilderCheckpoint.h5";
+  const auto        kInterval = std::chrono::milliseconds(0);
+  const unsigned    kDim = 600;
+  const unsigned    kNumSamples = 5;
+  statismo::utils::RemoveFile(kFilename);
+
+  auto representer = RepresenterType::SafeCreate(kDim);
+  auto dataManager = CreateRandomDataManager(representer.get(), kNumSamples);
+
+  statismo::MatrixType samples(kNumSamples, kDim);
+  unsigned             i = 0;
+  for (const auto & item : dataManager->GetData())
+  {
+    samples.row(i++) = item->GetSampleVector();
+  }
+
+  auto builder = ModelBuilderType::SafeCreate();
+  auto model = builder->BuildNewModel(dataManager->GetData(), 0);
+
+  // the gram matrix is accumulated by blocks when checkpointing
+  builder->SetCheckpoint(statismo::BuildCheckpoint::SafeCreateStd(kFilename, kInterval));
+  auto checkpointedModel = builder->BuildNewModel(dataManager->GetData(), 0);
+  builder->SetCheckpoint(nullptr);
+  STATISMO_ASSERT_LTE((checkpointedModel->GetPCAVarianceVector() - model->GetPCAVarianceVector()).norm(),
+                      1e-4 * model->GetPCAVarianceVector().norm());
+
+  // simulate an interrupted build, where only the first block of variables was added
+  statismo::MatrixType matX0 = samples.rowwise() - samples.colwise().mean();
+
+  // the key only depends on the values, not on the storage of the matrix
+  Eigen::Matrix<statismo::ScalarType, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rowMajorX0 = matX0;
+  STATISMO_ASSERT_EQ(statismo::BuildCheckpoint::HashMatrix(matX0), statismo::BuildCheckpoint::HashMatrix(rowMajorX0));
+  {
+    auto                 checkpoint = statismo::BuildCheckpoint::SafeCreateStd(kFilename, kInterval);
+    statismo::MatrixType partialGram = matX0.leftCols(256) * matX0.leftCols(256).transpose();
+    checkpoint->WriteMatrix<statismo::ScalarType>("gram", partialGram);
+    checkpoint->WriteIndices("gramNextItem", { 256 });
+  }
+
+  builder->SetCheckpoint(statismo::BuildCheckpoint::SafeCreateStd(kFilename, kInterval));
+  auto resumedModel = builder->BuildNewModel(dataManager->GetData(), 0);
+  STATISMO_ASSERT_LTE((resumedModel->GetPCAVarianceVector() - checkpointedModel->GetPCAVarianceVector()).norm(),
+                      1e-5 * model->GetPCAVarianceVector().norm());
+  statismo::MatrixType basisDifference =
+    resumedModel->GetPCABasisMatrix().cwiseAbs() - checkpointedModel->GetPCABasisMatrix().cwiseAbs();
+  STATISMO_ASSERT_LTE(basisDifference.norm(), 1e-3);
+
+  builder->SetCheckpoint(nullptr);
+  statismo::utils::RemoveFile(kFilename);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestPCAProgress()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using ModelBuilderType = statismo::PCAModelBuilder<statismo::VectorType>;
+  using DataManagerType = statismo::BasicDataManager<statismo::VectorType>;
+
+  const unsigned kDim = 3;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           dataManager = DataManagerType::SafeCreate(representer.get());
+
+  statismo::VectorType dataset1(kDim), dataset2(kDim), dataset3(kDim);
+  dataset1 << 1, 0, 0;
+  dataset2 << 0, 2, 0;
+  dataset3 << 0, 0, 4;
+  dataManager->AddDataset(dataset1, "dataset1");
+  dataManager->AddDataset(dataset2, "dataset2");
+  dataManager->AddDataset(dataset3, "dataset3");
+
+  auto                     builder = ModelBuilderType::SafeCreate();
+  std::vector<std::string> stages;
+  builder->SetProgressCallback([&](const statismo::BuildProgress & progress) {
+    if (progress.completedUnits == progress.totalUnits)
+    {
+      stages.push_back(progress.stage);
+    }
+    return true;
+  });
+  builder->BuildNewModel(dataManager->GetData(), 0.01);
+
+  std::vector<std::string> expectedStages{ "Sample matrix", "Gram matrix", "Decomposition", "Scores" };
+  STATISMO_ASSERT_TRUE(stages == expectedStages);
+
+  // cancel the build before the decomposition
+  builder->SetProgressCallback(
+    [](const statismo::BuildProgress & progress) { return progress.stage != "Gram matrix"; });
+  auto status = statismo::Status::SUCCESS;
+  try
+  {
+    builder->BuildNewModel(dataManager->GetData(), 0.01);
+  }
+  catch (const statismo::StatisticalModelException & e)
+  {
+    status = e.GetStatus();
+  }
+  STATISMO_ASSERT_TRUE(status == statismo::Status::CANCELLED);
+
+  // the decomposition is reported before it runs, so that it can be cancelled
+  std::vector<std::string> startedStages;
+  builder->SetProgressCallback([&](const statismo::BuildProgress & progress) {
+    if (progress.completedUnits == 0)
+    {
+      startedStages.push_back(progress.stage);
+    }
+    return progress.stage != "Decomposition";
+  });
+  status = statismo::Status::SUCCESS;
+  try
+  {
+    builder->BuildNewModel(dataManager->GetData(), 0.01);
+  }
+  catch (const statismo::StatisticalModelException & e)
+  {
+    status = e.GetStatus();
+  }
+  STATISMO_ASSERT_TRUE(status == statismo::Status::CANCELLED);
+  std::vector<std::string> expectedStartedStages{ "Sample matrix", "Gram matrix", "Decomposition" };
+  STATISMO_ASSERT_TRUE(startedStages == expectedStartedStages);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestPosteriorScores()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using PosteriorModelBuilderType = statismo::PosteriorModelBuilder<statismo::VectorType>;
+
+  const unsigned kDim = 50;
+  const unsigned kNumSamples = 10;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  PosteriorModelBuilderType::PointValueListType pointValues;
+  pointValues.emplace_back(3, 1.0f);
+  pointValues.emplace_back(17, -2.0f);
+  pointValues.emplace_back(42, 0.5f);
+
+  auto posteriorModel = PosteriorModelBuilderType::SafeCreate()->BuildNewModelFromModel(model.get(), pointValues, 0.1);
+
+  // the batched scores must agree with projecting each reconstructed training sample into the posterior model
+  const auto & inputScores = model->GetModelInfo().GetScoresMatrix();
+  const auto & scores = posteriorModel->GetModelInfo().GetScoresMatrix();
+  STATISMO_ASSERT_EQ(scores.rows(), static_cast<long>(posteriorModel->GetNumberOfPrincipalComponents()));
+  STATISMO_ASSERT_EQ(scores.cols(), inputScores.cols());
+  for (unsigned i = 0; i < inputScores.cols(); ++i)
+  {
+    statismo::VectorType expected =
+      posteriorModel->ComputeCoefficientsForSampleVector(model->DrawSampleVector(inputScores.col(i)));
+    STATISMO_ASSERT_LT((scores.col(i) - expected).norm(), 1e-3 * std::max(1.0f, expected.norm()));
+  }
+
+  // the posterior mean is the reconstruction of the MAP coefficients and interpolates the constraints
+  const auto & mean = posteriorModel->GetMeanVector();
+  STATISMO_ASSERT_LT(std::abs(mean(3) - 1.0f), 0.5f);
+  STATISMO_ASSERT_LT(std::abs(mean(17) + 2.0f), 0.5f);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestIncrementalPosterior()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using PosteriorModelBuilderType = statismo::PosteriorModelBuilder<statismo::VectorType>;
+  using IncrementalPosteriorModelType = statismo::IncrementalPosteriorModel<statismo::VectorType>;
+
+  const unsigned kDim = 50;
+  const unsigned kNumSamples = 10;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  auto checkEqual = [&](const IncrementalPosteriorModelType &               incremental,
+                        const PosteriorModelBuilderType::PointValueListType & pointValues) {
+    auto expected = PosteriorModelBuilderType::SafeCreate()->BuildNewModelFromModel(model.get(), pointValues, 0.1);
+    auto posteriorModel = incremental.BuildPosteriorModel();
+
+    STATISMO_ASSERT_LT((posteriorModel->GetMeanVector() - expected->GetMeanVector()).norm(), 1e-3);
+    STATISMO_ASSERT_LT((posteriorModel->GetPCAVarianceVector() - expected->GetPCAVarianceVector()).norm(), 1e-3);
+    STATISMO_ASSERT_LT((posteriorModel->GetModelInfo().GetScoresMatrix() - expected->GetModelInfo().GetScoresMatrix())
+                         .norm(),
+                       1e-2);
+
+    for (unsigned ptId : { 0u, 3u, 17u })
+    {
+      STATISMO_ASSERT_LT((incremental.ComputeMeanAtPoint(ptId) - expected->GetMeanVector().segment(ptId, 1)).norm(),
+                         1e-3);
+      STATISMO_ASSERT_LT(
+        (incremental.ComputeCovarianceAtPoint(ptId) - expected->GetCovarianceAtPoint(ptId, ptId)).norm(), 1e-3);
+    }
+    return EXIT_SUCCESS;
+  };
+
+  auto incremental = IncrementalPosteriorModelType::SafeCreate(model.get());
+
+  PosteriorModelBuilderType::PointValueListType pointValues;
+  pointValues.emplace_back(3, 1.0f);
+  pointValues.emplace_back(17, -2.0f);
+  pointValues.emplace_back(42, 0.5f);
+
+  std::vector<IncrementalPosteriorModelType::LandmarkIdType> ids;
+  for (const auto & pv : pointValues)
+  {
+    ids.push_back(incremental->AddLandmark(pv.first, pv.second, 0.1));
+  }
+  STATISMO_ASSERT_EQ(incremental->GetNumberOfLandmarks(), 3u);
+  STATISMO_ASSERT_EQ(checkEqual(*incremental, pointValues), EXIT_SUCCESS);
+
+  // removing a landmark is the same as never having added it
+  incremental->RemoveLandmark(ids[1]);
+  pointValues.erase(std::next(std::begin(pointValues)));
+  STATISMO_ASSERT_EQ(checkEqual(*incremental, pointValues), EXIT_SUCCESS);
+
+  // many updates trigger the recomputation of the inverse
+  for (unsigned i = 0; i < 100; ++i)
+  {
+    incremental->RemoveLandmark(incremental->AddLandmark(statismo::PointIdType(i % kDim), 3.0f, 0.1));
+  }
+  STATISMO_ASSERT_EQ(checkEqual(*incremental, pointValues), EXIT_SUCCESS);
+
+  bool exceptionCaught = false;
+  try
+  {
+    incremental->RemoveLandmark(ids[1]);
+  }
+  catch (const statismo::StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  incremental->ClearLandmarks();
+  STATISMO_ASSERT_LT(incremental->GetCoefficients().norm(), 1e-6);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestDerivedModels()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using PosteriorModelBuilderType = statismo::PosteriorModelBuilder<statismo::VectorType>;
+  using ReducedVarianceModelBuilderType = statismo::ReducedVarianceModelBuilder<statismo::VectorType>;
+  using StatisticalModelType = statismo::StatisticalModel<statismo::VectorType>;
+
+  const unsigned kDim = 50;
+  const unsigned kNumSamples = 10;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  std::minstd_rand                gen{ 1 };
+  std::normal_distribution<float> dis;
+
+  STATISMO_ASSERT_FALSE(model->IsDerived());
+
+  PosteriorModelBuilderType::PointValueListType pointValues;
+  pointValues.emplace_back(3, 1.0f);
+  pointValues.emplace_back(17, -2.0f);
+  auto posteriorModel = PosteriorModelBuilderType::SafeCreate()->BuildNewModelFromModel(model.get(), pointValues, 0.1);
+
+  // a model derived from a derived model refers to the basis of the first model
+  auto reducedModel = ReducedVarianceModelBuilderType::SafeCreate()->BuildNewModelWithLeadingComponents(
+    posteriorModel.get(), posteriorModel->GetNumberOfPrincipalComponents() - 2);
+  STATISMO_ASSERT_TRUE(posteriorModel->IsDerived());
+  STATISMO_ASSERT_TRUE(reducedModel->IsDerived());
+
+  // the derived models do not depend on the lifetime of the models they were derived from
+  model.reset();
+  posteriorModel.reset();
+
+  // compare the factorized evaluations with those of an explicit copy of the model
+  auto explicitModel = StatisticalModelType::SafeCreate(representer.get(),
+                                                        reducedModel->GetMeanVector(),
+                                                        reducedModel->GetOrthonormalPCABasisMatrix(),
+                                                        reducedModel->GetPCAVarianceVector(),
+                                                        reducedModel->GetNoiseVariance());
+  STATISMO_ASSERT_FALSE(explicitModel->IsDerived());
+  STATISMO_ASSERT_EQ(reducedModel->GetNumberOfPrincipalComponents(), explicitModel->GetNumberOfPrincipalComponents());
+
+  statismo::VectorType coefficients =
+    statismo::VectorType::NullaryExpr(reducedModel->GetNumberOfPrincipalComponents(), [&]() { return dis(gen); });
+  statismo::VectorType sample = reducedModel->DrawSampleVector(coefficients);
+  STATISMO_ASSERT_LT((sample - explicitModel->DrawSampleVector(coefficients)).norm(), 1e-4);
+  STATISMO_ASSERT_LT((reducedModel->ComputeCoefficientsForSampleVector(sample) -
+                      explicitModel->ComputeCoefficientsForSampleVector(sample))
+                       .norm(),
+                     1e-3);
+  STATISMO_ASSERT_LT(
+    std::abs(reducedModel->DrawSampleAtPoint(coefficients, 5) - explicitModel->DrawSampleAtPoint(coefficients, 5)),
+    1e-4);
+  STATISMO_ASSERT_LT((reducedModel->GetJacobian(5) - explicitModel->GetJacobian(5)).norm(), 1e-4);
+  STATISMO_ASSERT_LT((reducedModel->GetCovarianceAtPoint(5, 9) - explicitModel->GetCovarianceAtPoint(5, 9)).norm(),
+                     1e-4);
+  STATISMO_ASSERT_LT((reducedModel->GetPCABasisMatrix() - explicitModel->GetPCABasisMatrix()).norm(), 1e-4);
+  statismo::MatrixType orthonormalRows(7, reducedModel->GetNumberOfPrincipalComponents());
+  reducedModel->ComputeOrthonormalPCABasisRows(10, 7, orthonormalRows);
+  STATISMO_ASSERT_LT((orthonormalRows - explicitModel->GetOrthonormalPCABasisMatrix().middleRows(10, 7)).norm(), 1e-4);
+
+  // the model is flattened when it is saved
+  const std::string kFilename{ "derivedModel.h5" };
+  statismo::IO<statismo::VectorType>::SaveStatisticalModel(reducedModel.get(), kFilename);
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto loadedModel = statismo::IO<statismo::VectorType>::LoadStatisticalModel(newRepresenter.get(), kFilename);
+  statismo::utils::RemoveFile(kFilename);
+
+  STATISMO_ASSERT_FALSE(loadedModel->IsDerived());
+  STATISMO_ASSERT_LT((loadedModel->DrawSampleVector(coefficients) - sample).norm(), 1e-4);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestTruncatedModelViews()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using ReducedVarianceModelBuilderType = statismo::ReducedVarianceModelBuilder<statismo::VectorType>;
+  using StatisticalModelType = statismo::StatisticalModel<statismo::VectorType>;
+
+  const unsigned kDim = 50;
+  const unsigned kNumSamples = 10;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  std::minstd_rand                gen{ 1 };
+  std::normal_distribution<float> dis;
+
+  auto reducedModelBuilder = ReducedVarianceModelBuilderType::SafeCreate();
+
+  // several truncation levels of the same model share its mean
+  auto reducedModel = reducedModelBuilder->BuildNewModelWithLeadingComponents(model.get(), 5);
+  auto moreReducedModel = reducedModelBuilder->BuildNewModelWithLeadingComponents(reducedModel.get(), 3);
+  STATISMO_ASSERT_TRUE(reducedModel->IsDerived());
+  STATISMO_ASSERT_TRUE(moreReducedModel->IsDerived());
+  STATISMO_ASSERT_EQ(reducedModel->GetNumberOfPrincipalComponents(), 5u);
+  STATISMO_ASSERT_EQ(moreReducedModel->GetNumberOfPrincipalComponents(), 3u);
+  STATISMO_ASSERT_EQ(reducedModel->GetMeanVector().data(), model->GetMeanVector().data());
+  STATISMO_ASSERT_EQ(moreReducedModel->GetMeanVector().data(), model->GetMeanVector().data());
+
+  model.reset();
+  reducedModel.reset();
+
+  // compare the evaluations of the view with those of an explicit copy of the model
+  auto explicitModel = StatisticalModelType::SafeCreate(representer.get(),
+                                                        moreReducedModel->GetMeanVector(),
+                                                        moreReducedModel->GetOrthonormalPCABasisMatrix(),
+                                                        moreReducedModel->GetPCAVarianceVector(),
+                                                        moreReducedModel->GetNoiseVariance());
+
+  statismo::VectorType coefficients = statismo::VectorType::NullaryExpr(3, [&]() { return dis(gen); });
+  statismo::VectorType sample = moreReducedModel->DrawSampleVector(coefficients);
+  STATISMO_ASSERT_LT((sample - explicitModel->DrawSampleVector(coefficients)).norm(), 1e-4);
+  STATISMO_ASSERT_LT((moreReducedModel->ComputeCoefficientsForSampleVector(sample) -
+                      explicitModel->ComputeCoefficientsForSampleVector(sample))
+                       .norm(),
+                     1e-3);
+  STATISMO_ASSERT_LT((moreReducedModel->GetJacobian(5) - explicitModel->GetJacobian(5)).norm(), 1e-4);
+  STATISMO_ASSERT_LT(
+    (moreReducedModel->GetCovarianceAtPoint(5, 9) - explicitModel->GetCovarianceAtPoint(5, 9)).norm(), 1e-4);
+  STATISMO_ASSERT_LT((moreReducedModel->GetPCABasisMatrix() - explicitModel->GetPCABasisMatrix()).norm(), 1e-4);
+
+  // the model is flattened when it is saved
+  const std::string kFilename{ "truncatedModel.h5" };
+  statismo::IO<statismo::VectorType>::SaveStatisticalModel(moreReducedModel.get(), kFilename);
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto loadedModel = statismo::IO<statismo::VectorType>::LoadStatisticalModel(newRepresenter.get(), kFilename);
+  statismo::utils::RemoveFile(kFilename);
+
+  STATISMO_ASSERT_EQ(loadedModel->GetNumberOfPrincipalComponents(), 3u);
+  STATISMO_ASSERT_LT((loadedModel->DrawSampleVector(coefficients) - sample).norm(), 1e-4);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestPointValuesSystem()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using ReducedVarianceModelBuilderType = statismo::ReducedVarianceModelBuilder<statismo::VectorType>;
+  using StatisticalModelType = statismo::StatisticalModel<statismo::VectorType>;
+
+  const unsigned kDim = 50;
+  const unsigned kNumSamples = 10;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  std::minstd_rand                gen{ 1 };
+  std::normal_distribution<float> dis;
+
+  auto reducedModel = ReducedVarianceModelBuilderType::SafeCreate()->BuildNewModelWithLeadingComponents(model.get(), 5);
+
+  StatisticalModelType::PointValueWithCovarianceListType pointValues;
+  for (unsigned ptId : { 2u, 11u, 23u, 40u })
+  {
+    pointValues.emplace_back(std::make_pair(statismo::PointIdType(ptId), dis(gen)),
+                             statismo::MatrixType::Constant(1, 1, 0.05f * (ptId % 3 + 1)));
+  }
+
+  for (const auto * m : { model.get(), reducedModel.get() })
+  {
+    // reference: the normal equations assembled from the explicit basis
+    const auto &                        basis = m->GetPCABasisMatrix();
+    statismo::MatrixTypeDoublePrecision expectedM =
+      statismo::MatrixTypeDoublePrecision::Identity(basis.cols(), basis.cols());
+    statismo::VectorTypeDoublePrecision expectedRhs = statismo::VectorTypeDoublePrecision::Zero(basis.cols());
+    for (const auto & item : pointValues)
+    {
+      unsigned                            ptId = representer->GetPointIdForPoint(item.first.first);
+      double                              precision = 1.0 / item.second(0, 0);
+      statismo::VectorTypeDoublePrecision row = basis.row(ptId).transpose().cast<double>();
+      expectedM += precision * row * row.transpose();
+      expectedRhs += precision * row * (item.first.second - m->GetMeanVector()(ptId));
+    }
+
+    statismo::MatrixTypeDoublePrecision matM;
+    statismo::VectorTypeDoublePrecision rhs;
+    m->ComputePointValuesSystem(pointValues, matM, rhs);
+    STATISMO_ASSERT_LT((matM - expectedM).norm(), 1e-3 * expectedM.norm());
+    STATISMO_ASSERT_LT((rhs - expectedRhs).norm(), 1e-3 * std::max(1.0, expectedRhs.norm()));
+
+    statismo::VectorType coefficients = m->ComputeCoefficientsForPointValuesWithCovariance(pointValues);
+    STATISMO_ASSERT_LT((coefficients.cast<double>() - expectedM.ldlt().solve(expectedRhs)).norm(), 1e-3);
+  }
+
+  // the rows of every point value must lie in the model
+  pointValues.emplace_back(std::make_pair(statismo::PointIdType(kDim), 0.0f), statismo::MatrixType::Identity(1, 1));
+  auto status = statismo::Status::SUCCESS;
+  try
+  {
+    model->ComputeCoefficientsForPointValuesWithCovariance(pointValues);
+  }
+  catch (const statismo::StatisticalModelException & e)
+  {
+    status = e.GetStatus();
+  }
+  STATISMO_ASSERT_TRUE(status == statismo::Status::OUT_OF_RANGE_ERROR);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestConditionalModelEngine()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using ConditionalModelBuilderType = statismo::ConditionalModelBuilder<statismo::VectorType>;
+  using DataManagerType = statismo::DataManagerWithSurrogates<statismo::VectorType>;
+
+  const unsigned    kDim = 20;
+  const unsigned    kNumSamples = 15;
+  const std::string kTypesFilename{ "surrogateTypes.txt" };
+
+  // two continuous surrogates (e.g. age and weight)
+  {
+    std::ofstream typesFile(kTypesFilename);
+    typesFile << "1 1";
+  }
+
+  auto representer = RepresenterType::SafeCreate(kDim);
+  auto dataManager = DataManagerType::SafeCreate(representer.get(), kTypesFilename);
+
+  std::minstd_rand                gen{ 0 };
+  std::normal_distribution<float> dis;
+  statismo::VectorType            ageDirection = statismo::VectorType::NullaryExpr(kDim, [&]() { return dis(gen); });
+  statismo::VectorType weightDirection = statismo::VectorType::NullaryExpr(kDim, [&]() { return dis(gen); });
+  std::vector<std::string> filenames;
+  for (unsigned i = 0; i < kNumSamples; ++i)
+  {
+    float                age = 20 + 3 * dis(gen);
+    float                weight = 70 + 5 * dis(gen);
+    statismo::VectorType sample = statismo::VectorType::NullaryExpr(kDim, [&]() { return 0.1f * dis(gen); }) +
+                                  age * ageDirection + weight * weightDirection;
+
+    filenames.push_back("surrogates" + std::to_string(i) + ".txt");
+    {
+      std::ofstream surrogateFile(filenames.back());
+      surrogateFile << age << " " << weight;
+    }
+    dataManager->AddDatasetWithSurrogates(sample, "sample" + std::to_string(i), filenames.back());
+  }
+
+  auto builder = ConditionalModelBuilderType::SafeCreate();
+  ConditionalModelBuilderType::CondVariableValueVectorType conditioningInfo{ { true, 0.0f }, { true, 0.0f } };
+  auto engine = builder->BuildConditionalModelEngine(
+    dataManager->GetData(), dataManager->GetSurrogateTypeInfo(), conditioningInfo, 0.1f, 0.99);
+  STATISMO_ASSERT_EQ(engine->GetNumberOfConditioningVariables(), 2u);
+
+  for (auto [age, weight] : { std::make_pair(18.0f, 65.0f), std::make_pair(25.0f, 80.0f) })
+  {
+    statismo::VectorType conditions(2);
+    conditions << age, weight;
+    auto model = engine->BuildModel(conditions);
+
+    conditioningInfo = { { true, age }, { true, weight } };
+    auto expectedModel = builder->BuildNewModel(
+      dataManager->GetData(), dataManager->GetSurrogateTypeInfo(), conditioningInfo, 0.1f, 0.99);
+
+    STATISMO_ASSERT_TRUE(model->IsDerived());
+    STATISMO_ASSERT_EQ(model->GetNumberOfPrincipalComponents(), expectedModel->GetNumberOfPrincipalComponents());
+    STATISMO_ASSERT_LT((model->GetMeanVector() - expectedModel->GetMeanVector()).norm(), 1e-3);
+    STATISMO_ASSERT_LT((model->GetPCAVarianceVector() - expectedModel->GetPCAVarianceVector()).norm(), 1e-3);
+
+    // the conditional mean follows the linear trend of the data
+    statismo::VectorType expectedMean = age * ageDirection + weight * weightDirection;
+    STATISMO_ASSERT_LT((model->GetMeanVector() - expectedMean).norm(), 0.05 * expectedMean.norm());
+  }
+
+  bool exceptionCaught = false;
+  try
+  {
+    engine->BuildModel(statismo::VectorType::Zero(1));
+  }
+  catch (const statismo::StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  statismo::utils::RemoveFile(kTypesFilename);
+  for (const auto & filename : filenames)
+  {
+    statismo::utils::RemoveFile(filename);
+  }
+
+  return EXIT_SUCCESS;
+}
+int
+TestCompressedModelStorage()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+
+  const unsigned kDim = 200;
+  const unsigned kNumSamples = 10;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  if (!statismo::HDF5Utils::IsCompressionAvailable(statismo::HDF5Compression::DEFLATE))
+  {
+    return EXIT_SUCCESS;
+  }
+
+  statismo::HDF5StorageOptions options;
+  options.chunkColumns = 2;
+  options.shuffle = true;
+  options.compression = statismo::HDF5Compression::DEFLATE;
+
+  const std::string kFilename{ "compressedModel.h5" };
+  statismo::IO<statismo::VectorType>::SaveStatisticalModel(model.get(), kFilename, options);
+
+  {
+    H5::H5File file(kFilename.c_str(), H5F_ACC_RDONLY);
+    auto       properties = file.openDataSet("/model/pcaBasis").getCreatePlist();
+    hsize_t    chunk[2];
+    STATISMO_ASSERT_EQ(properties.getLayout(), H5D_CHUNKED);
+    properties.getChunk(2, chunk);
+    STATISMO_ASSERT_EQ(chunk[1], hsize_t{ 2 });
+    STATISMO_ASSERT_EQ(properties.getNfilters(), 2);
+  }
+
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto loadedModel = statismo::IO<statismo::VectorType>::LoadStatisticalModel(newRepresenter.get(), kFilename);
+  auto truncatedModel = statismo::IO<statismo::VectorType>::LoadStatisticalModel(newRepresenter.get(), kFilename, 3);
+  statismo::utils::RemoveFile(kFilename);
+
+  STATISMO_ASSERT_LT((loadedModel->GetMeanVector() - model->GetMeanVector()).norm(), 1e-5);
+  STATISMO_ASSERT_LT((loadedModel->GetPCABasisMatrix() - model->GetPCABasisMatrix()).norm(), 1e-5);
+  STATISMO_ASSERT_EQ(truncatedModel->GetNumberOfPrincipalComponents(), 3u);
+  STATISMO_ASSERT_LT((truncatedModel->GetPCABasisMatrix() - model->GetPCABasisMatrix().leftCols(3)).norm(), 1e-5);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestRegionOfInterestLoading()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using IOType = statismo::IO<statismo::VectorType>;
+
+  const unsigned kDim = 50;
+  const unsigned kNumSamples = 10;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  std::minstd_rand                gen{ 1 };
+  std::normal_distribution<float> dis;
+
+  const std::string kFilename{ "roiModel.h5" };
+  IOType::SaveStatisticalModel(model.get(), kFilename);
+
+  // the points are sorted and the duplicates removed
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto roiModel = IOType::LoadStatisticalModelForPoints(newRepresenter.get(), kFilename, { 40, 3, 17, 3 }, 5);
+  STATISMO_ASSERT_EQ(roiModel->GetRepresenter()->GetDomain().GetNumberOfPoints(), 3u);
+  STATISMO_ASSERT_EQ(roiModel->GetNumberOfPrincipalComponents(), 5u);
+
+  // the coefficients of the region model are those of the full model
+  statismo::VectorType coefficients = statismo::VectorType::NullaryExpr(5, [&]() { return dis(gen); });
+  statismo::VectorType fullCoefficients = statismo::VectorType::Zero(model->GetNumberOfPrincipalComponents());
+  fullCoefficients.topRows(5) = coefficients;
+  statismo::VectorType sample = model->DrawSampleVector(fullCoefficients);
+  statismo::VectorType roiSample = roiModel->DrawSampleVector(coefficients);
+  STATISMO_ASSERT_LT(std::abs(roiSample[0] - sample[3]), 1e-5);
+  STATISMO_ASSERT_LT(std::abs(roiSample[1] - sample[17]), 1e-5);
+  STATISMO_ASSERT_LT(std::abs(roiSample[2] - sample[40]), 1e-5);
+
+  statismo::VectorType lowerCorner(1);
+  statismo::VectorType upperCorner(1);
+  lowerCorner << 10;
+  upperCorner << 19;
+  auto boxModel = IOType::LoadStatisticalModelInBox(newRepresenter.get(), kFilename, lowerCorner, upperCorner);
+  STATISMO_ASSERT_EQ(boxModel->GetRepresenter()->GetDomain().GetNumberOfPoints(), 10u);
+  STATISMO_ASSERT_LT((boxModel->GetMeanVector() - model->GetMeanVector().segment(10, 10)).norm(), 1e-5);
+  STATISMO_ASSERT_LT(
+    (boxModel->GetPCABasisMatrix() - model->GetPCABasisMatrix().middleRows(10, 10)).norm(), 1e-5);
+  STATISMO_ASSERT_LT(
+    (boxModel->GetCovarianceAtPoint(2, 7) - model->GetCovarianceAtPoint(12, 17)).norm(), 1e-5);
+
+  // the rows can be read in any order
+  {
+    H5::H5File           file(kFilename.c_str(), H5F_ACC_RDONLY);
+    auto                 modelGroup = file.openGroup("/model");
+    statismo::MatrixType basis;
+    statismo::MatrixType rows;
+    statismo::HDF5Utils::ReadMatrix(modelGroup, "pcaBasis", basis);
+    statismo::HDF5Utils::ReadMatrixRows(modelGroup, "pcaBasis", { 9, 2, 3, 30 }, 4, rows);
+    STATISMO_ASSERT_EQ(rows.cols(), 4);
+    STATISMO_ASSERT_LT((rows.row(0) - basis.row(9).leftCols(4)).norm(), 1e-6);
+    STATISMO_ASSERT_LT((rows.row(1) - basis.row(2).leftCols(4)).norm(), 1e-6);
+    STATISMO_ASSERT_LT((rows.row(3) - basis.row(30).leftCols(4)).norm(), 1e-6);
+  }
+
+  bool exceptionCaught = false;
+  try
+  {
+    upperCorner << 5;
+    IOType::LoadStatisticalModelInBox(newRepresenter.get(), kFilename, lowerCorner, upperCorner);
+  }
+  catch (const statismo::StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  statismo::utils::RemoveFile(kFilename);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestWriteMatrixInRowBlocks()
+{
+  statismo::MatrixType matrix = statismo::MatrixType::Random(50, 4);
+
+  const std::string kFilename{ "rowBlocks.h5" };
+  statismo::HDF5StorageOptions chunked;
+  chunked.chunkRows = 5;
+  for (const auto & options : { statismo::HDF5StorageOptions(), chunked })
+  {
+    std::vector<unsigned> blocks;
+    {
+      H5::H5File file(kFilename.c_str(), H5F_ACC_TRUNC);
+      statismo::HDF5Utils::WriteMatrixInRowBlocks(
+        file,
+        "matrix",
+        matrix.rows(),
+        matrix.cols(),
+        [&](unsigned firstRow, unsigned numRows, Eigen::Ref<statismo::MatrixType> rows) {
+          blocks.push_back(numRows);
+          rows = matrix.middleRows(firstRow, numRows);
+        },
+        options,
+        7);
+    }
+
+    // the blocks are aligned with the chunks
+    STATISMO_ASSERT_EQ(blocks.front(), (options.IsChunked() ? 5u : 7u));
+
+    H5::H5File           file(kFilename.c_str(), H5F_ACC_RDONLY);
+    statismo::MatrixType readMatrix;
+    statismo::HDF5Utils::ReadMatrix(file, "matrix", readMatrix);
+    STATISMO_ASSERT_EQ(readMatrix.rows(), matrix.rows());
+    STATISMO_ASSERT_LT((readMatrix - matrix).norm(), 1e-6);
+  }
+  statismo::utils::RemoveFile(kFilename);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestModelCache()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using ModelCacheType = statismo::ModelCache<statismo::VectorType>;
+
+  const unsigned kDim = 50;
+  const unsigned kNumSamples = 10;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  const std::string kFilename{ "cachedModel.h5" };
+  statismo::IO<statismo::VectorType>::SaveStatisticalModel(model.get(), kFilename);
+
+  auto cache = ModelCacheType::SafeCreate();
+  auto newRepresenter = RepresenterType::SafeCreate();
+
+  // concurrent requests share a single load
+  std::vector<ModelCacheType::ModelPointerType> models(8);
+  std::vector<std::thread>                      threads;
+  for (unsigned i = 0; i < models.size(); ++i)
+  {
+    threads.emplace_back([&, i]() { models[i] = cache->GetModel(newRepresenter.get(), kFilename); });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+  for (const auto & cachedModel : models)
+  {
+    STATISMO_ASSERT_EQ(cachedModel.get(), models.front().get());
+  }
+  STATISMO_ASSERT_EQ(cache->GetStatistics().numberOfMisses, 1u);
+  STATISMO_ASSERT_EQ(cache->GetStatistics().numberOfHits, 7u);
+  STATISMO_ASSERT_LT((models.front()->GetMeanVector() - model->GetMeanVector()).norm(), 1e-5);
+
+  // the number of components is part of the key
+  auto truncatedModel = cache->GetModel(newRepresenter.get(), kFilename, 3);
+  STATISMO_ASSERT_EQ(truncatedModel->GetNumberOfPrincipalComponents(), 3u);
+  STATISMO_ASSERT_EQ(cache->GetStatistics().numberOfModels, 2u);
+
+  // the least recently used model is evicted, but stays valid
+  cache->SetMaximumNumberOfModels(1);
+  STATISMO_ASSERT_EQ(cache->GetStatistics().numberOfEvictions, 1u);
+  STATISMO_ASSERT_EQ(cache->GetStatistics().numberOfModels, 1u);
+  STATISMO_ASSERT_EQ(cache->GetModel(newRepresenter.get(), kFilename, 3).get(), truncatedModel.get());
+  STATISMO_ASSERT_EQ(models.front()->GetNumberOfPrincipalComponents(), model->GetNumberOfPrincipalComponents());
+
+  // a modified file is loaded again
+  std::filesystem::last_write_time(kFilename, std::filesystem::last_write_time(kFilename) + std::chrono::seconds(10));
+  auto reloadedModel = cache->GetModel(newRepresenter.get(), kFilename, 3);
+  STATISMO_ASSERT_TRUE(reloadedModel.get() != truncatedModel.get());
+
+  // concurrent misses on two files, while another thread saves a model
+  const std::string kOtherFilename{ "otherCachedModel.h5" };
+  const std::string kSavedFilename{ "savedCachedModel.h5" };
+  auto              otherModel = BuildRandomModel(representer.get(), kNumSamples, 1);
+  statismo::IO<statismo::VectorType>::SaveStatisticalModel(otherModel.get(), kOtherFilename);
+  cache->SetMaximumNumberOfModels(20);
+
+  auto                                          numMisses = cache->GetStatistics().numberOfMisses;
+  std::vector<ModelCacheType::ModelPointerType> missedModels(8);
+  threads.clear();
+  for (unsigned i = 0; i < missedModels.size(); ++i)
+  {
+    threads.emplace_back([&, i]() {
+      missedModels[i] = cache->GetModel(newRepresenter.get(), (i % 2 == 0) ? kFilename : kOtherFilename, 4 + i / 2);
+    });
+  }
+  threads.emplace_back(
+    [&]() { statismo::IO<statismo::VectorType>::SaveStatisticalModel(otherModel.get(), kSavedFilename); });
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+  STATISMO_ASSERT_EQ(cache->GetStatistics().numberOfMisses, numMisses + 8);
+  for (unsigned i = 0; i < missedModels.size(); ++i)
+  {
+    const auto & expectedModel = (i % 2 == 0) ? model : otherModel;
+    STATISMO_ASSERT_EQ(missedModels[i]->GetNumberOfPrincipalComponents(), 4 + i / 2);
+    STATISMO_ASSERT_LT((missedModels[i]->GetMeanVector() - expectedModel->GetMeanVector()).norm(), 1e-5);
+  }
+  auto savedModel = statismo::IO<statismo::VectorType>::LoadStatisticalModel(newRepresenter.get(), kSavedFilename);
+  STATISMO_ASSERT_LT((savedModel->GetMeanVector() - otherModel->GetMeanVector()).norm(), 1e-5);
+  statismo::utils::RemoveFile(kOtherFilename);
+  statismo::utils::RemoveFile(kSavedFilename);
+
+  statismo::utils::RemoveFile(kFilename);
+
+  bool exceptionCaught = false;
+  try
+  {
+    cache->GetModel(newRepresenter.get(), kFilename);
+  }
+  catch (const statismo::StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  cache->Clear();
+  STATISMO_ASSERT_EQ(cache->GetStatistics().numberOfModels, 0u);
+  STATISMO_ASSERT_EQ(cache->GetStatistics().size, 0u);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestAsyncModelLoading()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using IOType = statismo::IO<statismo::VectorType>;
+  using ModelPointerType = statismo::UniquePtrType<statismo::StatisticalModel<statismo::VectorType>>;
+
+  const unsigned kDim = 200;
+  const unsigned kNumSamples = 10;
+  const unsigned kNumModels = 4;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+
+  std::vector<std::string> filenames;
+  for (unsigned m = 0; m < kNumModels; ++m)
+  {
+    auto model = BuildRandomModel(representer.get(), kNumSamples, m);
+    filenames.push_back("asyncModel" + std::to_string(m) + ".h5");
+    IOType::SaveStatisticalModel(model.get(), filenames.back());
+  }
+
+  // each load needs its own representer
+  auto pool = std::make_shared<statismo::ThreadPool>(2, statismo::ThreadPool::WaitingMode::BLOCK, 0);
+  std::vector<statismo::UniquePtrType<RepresenterType>> representers;
+  std::vector<std::future<ModelPointerType>>            futures;
+  for (unsigned m = 0; m < kNumModels; ++m)
+  {
+    representers.push_back(RepresenterType::SafeCreate());
+    futures.push_back(IOType::LoadStatisticalModelAsync(
+      representers.back().get(), filenames[m], std::numeric_limits<unsigned>::max(), (m % 2 == 0) ? pool : nullptr));
+  }
+
+  for (unsigned m = 0; m < kNumModels; ++m)
+  {
+    auto model = futures[m].get();
+    auto newRepresenter = RepresenterType::SafeCreate();
+    auto expectedModel = IOType::LoadStatisticalModel(newRepresenter.get(), filenames[m]);
+    STATISMO_ASSERT_EQ(model->GetNumberOfPrincipalComponents(), expectedModel->GetNumberOfPrincipalComponents());
+    STATISMO_ASSERT_LT((model->GetMeanVector() - expectedModel->GetMeanVector()).norm(), 1e-5);
+    STATISMO_ASSERT_LT((model->GetPCABasisMatrix() - expectedModel->GetPCABasisMatrix()).norm(), 1e-5);
+    statismo::utils::RemoveFile(filenames[m]);
+  }
+
+  // errors are reported through the future
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto future = IOType::LoadStatisticalModelAsync(newRepresenter.get(), "nonExistingModel.h5");
+  bool exceptionCaught = false;
+  try
+  {
+    future.get();
+  }
+  catch (const statismo::StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestBinaryModelFormat()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using IOType = statismo::IO<statismo::VectorType>;
+  using BinaryIOType = statismo::BinaryModelIO<statismo::VectorType>;
+
+  const unsigned kDim = 300;
+  const unsigned kNumSamples = 15;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  auto isSameModel = [](const statismo::StatisticalModel<statismo::VectorType> & m1,
+                        const statismo::StatisticalModel<statismo::VectorType> & m2,
+                        unsigned                                                 numComponents) {
+    return m1.GetNumberOfPrincipalComponents() == numComponents &&
+           (m1.GetMeanVector() - m2.GetMeanVector()).norm() < 1e-5 &&
+           (m1.GetPCAVarianceVector() - m2.GetPCAVarianceVector().head(numComponents)).norm() < 1e-5 &&
+           (m1.GetPCABasisMatrix() - m2.GetPCABasisMatrix().leftCols(numComponents)).norm() < 1e-4 &&
+           std::abs(m1.GetNoiseVariance() - m2.GetNoiseVariance()) < 1e-6 &&
+           (m1.GetModelInfo().GetScoresMatrix() - m2.GetModelInfo().GetScoresMatrix()).norm() < 1e-4;
+  };
+
+  const std::string kFilename{ "binaryModel.bin" };
+  const std::string kHDF5Filename{ "binaryModel.h5" };
+  const std::string kConvertedFilename{ "convertedBinaryModel.bin" };
+  auto              numComponents = model->GetNumberOfPrincipalComponents();
+
+  BinaryIOType::SaveStatisticalModel(*model, kFilename);
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto loadedModel = BinaryIOType::LoadStatisticalModel(newRepresenter.get(), kFilename);
+  STATISMO_ASSERT_TRUE(isSameModel(*loadedModel, *model, numComponents));
+  STATISMO_ASSERT_EQ(loadedModel->GetRepresenter()->GetDimensions(), 1u);
+
+  auto truncatedModel = BinaryIOType::LoadStatisticalModel(newRepresenter.get(), kFilename, 3);
+  STATISMO_ASSERT_TRUE(isSameModel(*truncatedModel, *model, 3));
+
+  // binary -> hdf5 -> binary
+  statismo::BinaryModelFormat::ConvertToHDF5(kFilename, kHDF5Filename);
+  auto hdf5Model = IOType::LoadStatisticalModel(newRepresenter.get(), kHDF5Filename);
+  STATISMO_ASSERT_TRUE(isSameModel(*hdf5Model, *model, numComponents));
+
+  statismo::BinaryModelFormat::ConvertFromHDF5(kHDF5Filename, kConvertedFilename);
+  auto convertedModel = BinaryIOType::LoadStatisticalModel(newRepresenter.get(), kConvertedFilename);
+  STATISMO_ASSERT_TRUE(isSameModel(*convertedModel, *model, numComponents));
+
+  // the blocks are aligned
+  {
+    statismo::MappedFile file(kConvertedFilename);
+    const auto &         header = statismo::BinaryModelFormat::ReadHeader(file);
+    STATISMO_ASSERT_EQ(header.numberOfRows, uint64_t{ kDim });
+    STATISMO_ASSERT_EQ(header.pcaBasis.offset % statismo::BinaryModelFormat::kAlignment, uint64_t{ 0 });
+  }
+
+  // truncated and invalid files are rejected
+  std::filesystem::resize_file(kConvertedFilename, std::filesystem::file_size(kConvertedFilename) / 2);
+  bool exceptionCaught = false;
+  try
+  {
+    BinaryIOType::LoadStatisticalModel(newRepresenter.get(), kConvertedFilename);
+  }
+  catch (const statismo::StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  exceptionCaught = false;
+  try
+  {
+    BinaryIOType::LoadStatisticalModel(newRepresenter.get(), kHDF5Filename);
+  }
+  catch (const statismo::StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  statismo::utils::RemoveFile(kFilename);
+  statismo::utils::RemoveFile(kHDF5Filename);
+  statismo::utils::RemoveFile(kConvertedFilename);
+
+  return EXIT_SUCCESS;
+}
+
+
+int
+TestLegacyModelLoading()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using IOType = statismo::IO<statismo::VectorType>;
+
+  // embedded files are read back into memory unchanged, including null bytes
+  const std::string kFilename{ "legacyModel.h5" };
+  const std::string kBytes{ "# vtk DataFile\0\x01\xff binary", 29 };
+  {
+    H5::H5File file(kFilename, H5F_ACC_TRUNC);
+    statismo::HDF5Utils::DumpBufferToHDF5(kBytes, file, "reference");
+    statismo::HDF5Utils::DumpBufferToHDF5("", file, "emptyReference");
+    STATISMO_ASSERT_TRUE(statismo::HDF5Utils::GetBufferFromHDF5(file, "reference") == kBytes);
+    STATISMO_ASSERT_TRUE(statismo::HDF5Utils::GetBufferFromHDF5(file, "emptyReference").empty());
+  }
+
+  const unsigned kDim = 50;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+  auto           model = BuildRandomModel(representer.get(), 10);
+  IOType::SaveStatisticalModel(*model, kFilename);
+
+  // turn the file into a version 0.8 file, which has no version group and stores the scaled basis
+  {
+    H5::H5File file(kFilename, H5F_ACC_RDWR);
+    file.unlink("/version");
+    file.unlink("/model/pcaBasis");
+    statismo::HDF5Utils::WriteMatrix(file.openGroup("/model"), "./pcaBasis", model->GetPCABasisMatrix());
+  }
+
+  auto newRepresenter = RepresenterType::SafeCreate();
+  auto legacyModel = IOType::LoadStatisticalModel(newRepresenter.get(), kFilename);
+  STATISMO_ASSERT_LTE((legacyModel->GetMeanVector() - model->GetMeanVector()).norm(), 1e-5);
+  STATISMO_ASSERT_LTE((legacyModel->GetPCABasisMatrix() - model->GetPCABasisMatrix()).norm(), 1e-4);
+  STATISMO_ASSERT_LTE(
+    (legacyModel->GetOrthonormalPCABasisMatrix() - model->GetOrthonormalPCABasisMatrix()).norm(), 1e-4);
+
+  statismo::utils::RemoveFile(kFilename);
+
+  return EXIT_SUCCESS;
+}
+
+
+int
+TestMultiModelLoading()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using IOType = statismo::IO<statismo::VectorType>;
+  using ModelPointerType = statismo::UniquePtrType<statismo::StatisticalModel<statismo::VectorType>>;
+
+  const unsigned kDim = 100;
+  const unsigned kNumModels = 5;
+  auto           representer = RepresenterType::SafeCreate(kDim);
+
+  std::vector<ModelPointerType> models;
+  std::vector<std::string>      groupNames;
+  const std::string             kFilename{ "multiModel.h5" };
+  {
+    H5::H5File file(kFilename, H5F_ACC_TRUNC);
+    for (unsigned m = 0; m < kNumModels; ++m)
+    {
+      models.push_back(BuildRandomModel(representer.get(), 5 + m, m));
+      groupNames.push_back("/model" + std::to_string(m));
+      IOType::SaveStatisticalModel(*models.back(), file.createGroup(groupNames.back()));
+    }
+  }
+
+  // the models are the same whether they are created by the reading thread or by the pool
+  auto pool = std::make_shared<statismo::ThreadPool>(2, statismo::ThreadPool::WaitingMode::BLOCK, 0);
+  for (const auto & loadingPool : { statismo::SharedPtrType<statismo::ThreadPool>{}, pool })
+  {
+    auto newRepresenter = RepresenterType::SafeCreate();
+    auto loadedModels = IOType::LoadStatisticalModels(
+      newRepresenter.get(), kFilename, groupNames, std::numeric_limits<unsigned>::max(), loadingPool);
+    STATISMO_ASSERT_EQ(loadedModels.size(), models.size());
+    for (unsigned m = 0; m < kNumModels; ++m)
+    {
+      STATISMO_ASSERT_EQ(loadedModels[m]->GetNumberOfPrincipalComponents(),
+                         models[m]->GetNumberOfPrincipalComponents());
+      STATISMO_ASSERT_LT((loadedModels[m]->GetMeanVector() - models[m]->GetMeanVector()).norm(), 1e-5);
+      STATISMO_ASSERT_LT((loadedModels[m]->GetPCABasisMatrix() - models[m]->GetPCABasisMatrix()).norm(), 1e-4);
+    }
+  }
+
+  bool exceptionCaught = false;
+  try
+  {
+    auto newRepresenter = RepresenterType::SafeCreate();
+    IOType::LoadStatisticalModels(
+      newRepresenter.get(), kFilename, { "/model0", "/noModel" }, std::numeric_limits<unsigned>::max(), pool);
+  }
+  catch (const statismo::StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  statismo::utils::RemoveFile(kFilename);
+
+  return EXIT_SUCCESS;
+}
+
+
+int
+TestCompactModelInfo()
+{
+  using RepresenterType = statismo::TrivialVectorialRepresenter;
+  using IOType = statismo::IO<statismo::VectorType>;
+
+  const unsigned kNumSamples = 12;
+  auto           representer = RepresenterType::SafeCreate(20);
+  auto           model = BuildRandomModel(representer.get(), kNumSamples);
+
+  const std::string kFilename{ "compactModelInfo.h5" };
+  IOType::SaveStatisticalModel(model.get(), kFilename);
+
+  // the data info keeps its order (URI_10 follows URI_9), which the group of the previous format did not
+  const auto builderInfo = model->GetModelInfo().GetBuilderInfoList().front();
+  {
+    auto newRepresenter = RepresenterType::SafeCreate();
+    auto loadedModel = IOType::LoadStatisticalModel(newRepresenter.get(), kFilename);
+    auto loadedBuilderInfo = loadedModel->GetModelInfo().GetBuilderInfoList();
+    STATISMO_ASSERT_EQ(loadedBuilderInfo.size(), std::size_t{ 1 });
+    STATISMO_ASSERT_TRUE(loadedBuilderInfo.front().GetDataInfo() == builderInfo.GetDataInfo());
+    STATISMO_ASSERT_TRUE(loadedBuilderInfo.front().GetParameterInfo() == builderInfo.GetParameterInfo());
+    STATISMO_ASSERT_EQ(loadedModel->GetModelInfo().GetScoresMatrix().cols(), Eigen::Index{ kNumSamples });
+  }
+
+  // the scores and the builder info are only loaded if requested
+  {
+    auto newRepresenter = RepresenterType::SafeCreate();
+    auto loadedModel = IOType::LoadStatisticalModel(
+      newRepresenter.get(), kFilename, std::numeric_limits<unsigned>::max(), statismo::ModelInfoLoadFlags::NONE);
+    STATISMO_ASSERT_EQ(loadedModel->GetModelInfo().GetScoresMatrix().size(), Eigen::Index{ 0 });
+    STATISMO_ASSERT_TRUE(loadedModel->GetModelInfo().GetBuilderInfoList().empty());
+    STATISMO_ASSERT_LT((loadedModel->GetPCABasisMatrix() - model->GetPCABasisMatrix()).norm(), 1e-5);
+
+    H5::H5File          file(kFilename, H5F_ACC_RDONLY);
+    statismo::ModelInfo modelInfo;
+    modelInfo.Load(file, statismo::ModelInfoLoadFlags::BUILDER_INFO);
+    STATISMO_ASSERT_EQ(modelInfo.GetScoresMatrix().size(), Eigen::Index{ 0 });
+    STATISMO_ASSERT_EQ(modelInfo.GetBuilderInfoList().size(), std::size_t{ 1 });
+  }
+
+  // the string arrays of the builder info came with version 0.10, which released readers reject cleanly
+  {
+    H5::H5File file(kFilename, H5F_ACC_RDONLY);
+    STATISMO_ASSERT_EQ(statismo::HDF5Utils::ReadInt(file, "/version/minorVersion"),
+                       static_cast<int>(gk_currentFileVersionMinor));
+  }
+
+  // turn the file into a version 0.9 file, which stores the builder info with a string dataset per entry
+  {
+    H5::H5File file(kFilename, H5F_ACC_RDWR);
+    file.unlink("/version/minorVersion");
+    statismo::HDF5Utils::WriteInt(file.openGroup("/version"), "minorVersion", gk_previousFileVersionMinor);
+
+    auto builderGroup = file.openGroup("/modelinfo/modelBuilder-0");
+    builderGroup.unlink("dataInfoList");
+    builderGroup.unlink("parameterList");
+    auto dataInfoGroup = builderGroup.createGroup("dataInfo");
+    statismo::HDF5Utils::WriteString(dataInfoGroup, "URI_0", "sample0");
+    statismo::HDF5Utils::WriteString(dataInfoGroup, "URI_1", "sample1");
+    auto parameterGroup = builderGroup.createGroup("parameters");
+    statismo::HDF5Utils::WriteString(parameterGroup, "NoiseVariance", "0.1");
+  }
+  {
+    auto newRepresenter = RepresenterType::SafeCreate();
+    auto loadedModel = IOType::LoadStatisticalModel(newRepresenter.get(), kFilename);
+    auto loadedBuilderInfo = loadedModel->GetModelInfo().GetBuilderInfoList();
+    STATISMO_ASSERT_EQ(loadedBuilderInfo.size(), std::size_t{ 1 });
+    STATISMO_ASSERT_EQ(loadedBuilderInfo.front().GetDataInfo().size(), std::size_t{ 2 });
+    STATISMO_ASSERT_TRUE(loadedBuilderInfo.front().GetDataInfo().back().second == "sample1");
+    STATISMO_ASSERT_TRUE(loadedBuilderInfo.front().GetParameterInfo().front().first == "NoiseVariance");
+    STATISMO_ASSERT_LT((loadedModel->GetPCABasisMatrix() - model->GetPCABasisMatrix()).norm(), 1e-5);
+  }
+
+  statismo::utils::RemoveFile(kFilename);
+
+  return EXIT_SUCCESS;
+}
+
 } // namespace
 
 /**
@@ -99,7 +1271,25 @@ Test1()
 int basicStatismoTest([[maybe_unused]] int argc, [[maybe_unused]] char * argv[]) // NOLINT
 {
   auto res = statismo::Translate([]() {
-    return statismo::test::RunAllTests("basicStatismoTest", { { "Test1", Test1 } });
+    return statismo::test::RunAllTests("basicStatismoTest",
+                                       { { "Test1", Test1 },
+                                         { "TestPCACheckpoint", TestPCACheckpoint },
+                                         { "TestPCAProgress", TestPCAProgress },
+                                         { "TestPosteriorScores", TestPosteriorScores },
+                                         { "TestIncrementalPosterior", TestIncrementalPosterior },
+                                         { "TestDerivedModels", TestDerivedModels },
+                                         { "TestTruncatedModelViews", TestTruncatedModelViews },
+                                         { "TestPointValuesSystem", TestPointValuesSystem },
+                                         { "TestConditionalModelEngine", TestConditionalModelEngine },
+                                         { "TestCompressedModelStorage", TestCompressedModelStorage },
+                                         { "TestRegionOfInterestLoading", TestRegionOfInterestLoading },
+                                         { "TestWriteMatrixInRowBlocks", TestWriteMatrixInRowBlocks },
+                                         { "TestModelCache", TestModelCache },
+                                         { "TestAsyncModelLoading", TestAsyncModelLoading },
+                                         { "TestBinaryModelFormat", TestBinaryModelFormat },
+                                         { "TestLegacyModelLoading", TestLegacyModelLoading },
+                                         { "TestMultiModelLoading", TestMultiModelLoading },
+                                         { "TestCompactModelInfo", TestCompactModelInfo } });
   });
 
   return !CheckResultAndAssert(res, EXIT_SUCCESS);
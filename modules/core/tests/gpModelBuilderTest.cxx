@@ -0,0 +1,706 @@
+/*
+ * This file is part of the statismo library.
+ *
+ * Copyright (c) 2019 Laboratory of Medical Information Processing
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of the project's author nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "StatismoUnitTest.h"
+#include "statismo/core/BuildCheckpoint.h"
+#include "statismo/core/Exceptions.h"
+
+#include "statismo/core/KernelCombinators.h"
+#include "statismo/core/KernelExpressions.h"
+#include "statismo/core/KroneckerGPModelBuilder.h"
+#include "statismo/core/LowRankGPModelBuilder.h"
+#include "statismo/core/Nystrom.h"
+#include "statismo/core/RandUtils.h"
+#include "statismo/core/ThreadPool.h"
+#include "statismo/core/TrivialVectorialRepresenter.h"
+#include "statismo/core/Utils.h"
+
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <memory>
+
+using namespace statismo;
+
+namespace
+{
+using RepresenterType = TrivialVectorialRepresenter;
+using PointType = RepresenterType::PointType;
+using ModelBuilderType = LowRankGPModelBuilder<VectorType>;
+
+constexpr unsigned gk_numPoints = 200;
+
+// Gaussian kernel on the index of the points
+class IndexGaussianKernel : public ScalarValuedKernel<PointType>
+{
+public:
+  explicit IndexGaussianKernel(double sigma)
+    : m_sigma2(sigma * sigma)
+  {}
+
+  double
+  operator()(const PointType & x, const PointType & y) const override
+  {
+    double d = static_cast<double>(x.ptId) - static_cast<double>(y.ptId);
+    return std::exp(-d * d / m_sigma2);
+  }
+
+  std::string
+  GetKernelInfo() const override
+  {
+    return "IndexGaussianKernel";
+  }
+
+private:
+  double m_sigma2;
+};
+
+// Compactly supported (Wendland) kernel on the index of the points
+class IndexWendlandKernel : public ScalarValuedKernel<PointType>
+{
+public:
+  explicit IndexWendlandKernel(double support)
+    : m_support(support)
+  {}
+
+  double
+  operator()(const PointType & x, const PointType & y) const override
+  {
+    double r = std::fabs(static_cast<double>(x.ptId) - static_cast<double>(y.ptId)) / m_support;
+    return r < 1 ? std::pow(1 - r, 3) * (3 * r + 1) : 0;
+  }
+
+  std::string
+  GetKernelInfo() const override
+  {
+    return "IndexWendlandKernel";
+  }
+
+  double
+  GetSupportRadius() const override
+  {
+    return m_support;
+  }
+
+private:
+  double m_support;
+};
+
+// Tempering function increasing with the index of the points
+class IndexTemperingFunction : public TemperingFunction<PointType>
+{
+public:
+  double
+  operator()(const PointType & pt) const override
+  {
+    return 1.0 + static_cast<double>(pt.ptId) / gk_numPoints;
+  }
+};
+
+// Gaussian kernel along one axis of a grid
+class AxisGaussianKernel : public ScalarValuedKernel<double>
+{
+public:
+  explicit AxisGaussianKernel(double sigma)
+    : m_sigma2(sigma * sigma)
+  {}
+
+  double
+  operator()(const double & x, const double & y) const override
+  {
+    return std::exp(-(x - y) * (x - y) / m_sigma2);
+  }
+
+  std::string
+  GetKernelInfo() const override
+  {
+    return "AxisGaussianKernel";
+  }
+
+private:
+  double m_sigma2;
+};
+
+int
+TestTiledEigenfunctions()
+{
+  rand::RandGen(0);
+
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexGaussianKernel            gk{ 20 };
+  UncorrelatedMatrixValuedKernel mk{ &gk, representer->GetDimensions() };
+
+  auto nystrom = Nystrom<VectorType>::SafeCreateStd(representer.get(), mk, 10, 50);
+  auto points = representer->GetDomain().GetDomainPoints();
+
+  MatrixType tile = nystrom->ComputeEigenfunctionsAtPoints(points, 10, 30);
+  STATISMO_ASSERT_EQ(20, tile.rows());
+  STATISMO_ASSERT_EQ(10, tile.cols());
+
+  for (unsigned i = 10; i < 30; ++i)
+  {
+    MatrixType single = nystrom->ComputeEigenfunctionsAtPoint(points[i]);
+    STATISMO_ASSERT_LTE((tile.row(i - 10) - single.row(0)).norm(), 1e-4 * single.norm());
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestBuildWithSharedPool()
+{
+  rand::RandGen(0);
+
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexGaussianKernel            gk{ 20 };
+  UncorrelatedMatrixValuedKernel mk{ &gk, representer->GetDimensions() };
+
+  auto pool = std::make_shared<ThreadPool>(2, ThreadPool::WaitingMode::BLOCK, 0);
+
+  auto builder1 = ModelBuilderType::SafeCreate(representer.get());
+  builder1->SetThreadPool(pool);
+  builder1->SetTileSize(7);
+
+  auto builder2 = ModelBuilderType::SafeCreate(representer.get());
+  builder2->SetThreadPool(pool);
+
+  // the pool is reused by several builds
+  for (unsigned i = 0; i < 2; ++i)
+  {
+    auto model1 = builder1->BuildNewZeroMeanModel(mk, 30, 100);
+    auto model2 = builder2->BuildNewZeroMeanModel(mk, 30, 100);
+
+    STATISMO_ASSERT_EQ(30U, model1->GetNumberOfPrincipalComponents());
+    STATISMO_ASSERT_EQ(30U, model2->GetNumberOfPrincipalComponents());
+    STATISMO_ASSERT_EQ(static_cast<long>(gk_numPoints), model1->GetPCABasisMatrix().rows());
+
+    // the model must approximate the kernel
+    auto cov = model1->GetCovarianceAtPoint(50, 55);
+    STATISMO_ASSERT_LTE(std::fabs(cov(0, 0) - gk(PointType{ 50 }, PointType{ 55 })), 1e-3);
+  }
+
+  auto builder3 = ModelBuilderType::SafeCreate(representer.get());
+  builder3->SetNumberOfThreads(1);
+  auto model3 = builder3->BuildNewZeroMeanModel(mk, 30, 100);
+  STATISMO_ASSERT_EQ(30U, model3->GetNumberOfPrincipalComponents());
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestCompactlySupportedKernel()
+{
+  rand::RandGen(0);
+
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexWendlandKernel            wk{ 30 };
+  UncorrelatedMatrixValuedKernel mk{ &wk, representer->GetDimensions() };
+  ScaledKernel<PointType>        sk{ &mk, 2 };
+  STATISMO_ASSERT_DOUBLE_EQ(30.0, sk.GetSupportRadius());
+
+  IndexGaussianKernel gk{ 20 };
+  STATISMO_ASSERT_FALSE(std::isfinite(gk.GetSupportRadius()));
+
+  // the kernel matrix is assembled from the neighbouring points only
+  auto builder = ModelBuilderType::SafeCreate(representer.get());
+  auto model = builder->BuildNewZeroMeanModel(mk, 60, gk_numPoints);
+  STATISMO_ASSERT_EQ(60U, model->GetNumberOfPrincipalComponents());
+
+  for (unsigned d : { 0U, 5U, 20U, 40U })
+  {
+    auto cov = model->GetCovarianceAtPoint(100, 100 + d);
+    STATISMO_ASSERT_LTE(std::fabs(cov(0, 0) - wk(PointType{ 100 }, PointType{ 100 + d })), 0.05);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestSpatiallyVaryingKernelTable()
+{
+  rand::RandGen(0);
+
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexGaussianKernel            gk{ 20 };
+  UncorrelatedMatrixValuedKernel mk{ &gk, representer->GetDimensions() };
+  IndexTemperingFunction         eta;
+
+  rand::RandGen().seed(0);
+  SpatiallyVaryingKernel<VectorType> tableKernel{ representer.get(), mk, eta, 20, 100, true, true };
+
+  // same Nystrom points, the eigenfunctions only differ by the randomized SVD
+  rand::RandGen().seed(0);
+  SpatiallyVaryingKernel<VectorType> kernelRef{ representer.get(), mk, eta, 20, 100, false };
+
+  // points outside of the domain go through the cache
+  for (unsigned i : { 0U, 42U, 199U, 250U })
+  {
+    for (unsigned j : { 3U, 42U, 120U, 300U })
+    {
+      auto v = tableKernel(PointType{ i }, PointType{ j });
+      auto vref = kernelRef(PointType{ i }, PointType{ j });
+      STATISMO_ASSERT_LTE(std::fabs(v(0, 0) - vref(0, 0)), 1e-3);
+    }
+  }
+
+  // the domain point ids read the table rows directly
+  STATISMO_ASSERT_TRUE(tableKernel.AcceptsPointIdsOf(representer->GetDomain()));
+  MatrixType res(1, 1);
+  for (unsigned i : { 0U, 42U, 199U })
+  {
+    for (unsigned j : { 3U, 42U, 120U })
+    {
+      tableKernel.EvaluateAtDomainPoints(PointType{ i }, i, PointType{ j }, j, res);
+      STATISMO_ASSERT_DOUBLE_EQ(tableKernel(PointType{ i }, PointType{ j })(0, 0), res(0, 0));
+    }
+  }
+
+  // concurrent evaluations give the same values as sequential ones
+  std::vector<std::future<double>> futures;
+  for (unsigned t = 0; t < 4; ++t)
+  {
+    futures.emplace_back(std::async(std::launch::async, [&tableKernel, t]() {
+      double sum = 0;
+      for (unsigned i = 0; i < gk_numPoints; ++i)
+      {
+        sum += tableKernel(PointType{ i }, PointType{ (i * (t + 1)) % (gk_numPoints + 10) })(0, 0);
+      }
+      return sum;
+    }));
+  }
+  for (unsigned t = 0; t < 4; ++t)
+  {
+    double sumRef = 0;
+    for (unsigned i = 0; i < gk_numPoints; ++i)
+    {
+      sumRef += tableKernel(PointType{ i }, PointType{ (i * (t + 1)) % (gk_numPoints + 10) })(0, 0);
+    }
+    STATISMO_ASSERT_DOUBLE_EQ(sumRef, futures[t].get());
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestKernelExpressions()
+{
+  rand::RandGen().seed(0);
+
+  IndexGaussianKernel gk{ 20 };
+  IndexWendlandKernel wk{ 30 };
+
+  // runtime combinators
+  UncorrelatedMatrixValuedKernel<PointType> gk3{ &gk, 3 };
+  UncorrelatedMatrixValuedKernel<PointType> wk3{ &wk, 3 };
+  ScaledKernel<PointType>                   scaledGk3{ &gk3, 2 };
+  ScaledKernel<PointType>                   scaledWk3{ &wk3, 0.5 };
+  SumKernel<PointType>                      sum{ &scaledGk3, &scaledWk3 };
+  ProductKernel<PointType>                  prod{ &gk3, &wk3 };
+
+  // compile-time expressions
+  auto gkExpr = MakeUncorrelatedKernelExpression<3>(gk);
+  auto wkExpr = MakeUncorrelatedKernelExpression<3>(wk);
+  auto sumExpr = 2.0 * gkExpr + wkExpr * 0.5;
+  auto prodExpr = gkExpr * MakeKernelExpression<3>(wk3);
+
+  STATISMO_ASSERT_FALSE(std::isfinite(sumExpr.GetSupportRadius()));
+  STATISMO_ASSERT_DOUBLE_EQ(30.0, prodExpr.GetSupportRadius());
+  STATISMO_ASSERT_EQ(sum.GetKernelInfo(), sumExpr.GetKernelInfo());
+
+  auto       kernel = MakeMatrixValuedKernel(sumExpr);
+  MatrixType res = MatrixType::Zero(6, 6);
+  STATISMO_ASSERT_EQ(3U, kernel->GetDimension());
+
+  for (unsigned i : { 0U, 10U, 50U })
+  {
+    for (unsigned j : { 5U, 10U, 70U })
+    {
+      PointType x{ i };
+      PointType y{ j };
+      STATISMO_ASSERT_LTE((MatrixType(sumExpr(x, y)) - sum(x, y)).norm(), 1e-6);
+      STATISMO_ASSERT_LTE((MatrixType(prodExpr(x, y)) - prod(x, y)).norm(), 1e-6);
+      STATISMO_ASSERT_LTE(((*kernel)(x, y) - sum(x, y)).norm(), 1e-6);
+
+      // evaluation into a block of a larger matrix
+      kernel->Evaluate(x, y, res.block(3, 3, 3, 3));
+      STATISMO_ASSERT_LTE((res.block(3, 3, 3, 3) - sum(x, y)).norm(), 1e-6);
+    }
+  }
+
+  // the type-erased kernel can be used by the builders
+  auto representer = RepresenterType::SafeCreate(gk_numPoints);
+  auto gpKernel = MakeMatrixValuedKernel(2.0 * MakeUncorrelatedKernelExpression<1>(gk));
+  auto model = ModelBuilderType::SafeCreate(representer.get())->BuildNewZeroMeanModel(*gpKernel, 30, 100);
+  auto cov = model->GetCovarianceAtPoint(50, 55);
+  STATISMO_ASSERT_LTE(std::fabs(cov(0, 0) - 2 * gk(PointType{ 50 }, PointType{ 55 })), 2e-3);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestStatisticalModelKernelPointIds()
+{
+  rand::RandGen().seed(0);
+
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexGaussianKernel            gk{ 20 };
+  UncorrelatedMatrixValuedKernel mk{ &gk, representer->GetDimensions() };
+  auto model = ModelBuilderType::SafeCreate(representer.get())->BuildNewZeroMeanModel(mk, 30, 100);
+
+  StatisticalModelKernel<VectorType> smk{ model.get() };
+  ScaledKernel<PointType>            scaledGk{ &mk, 0.5 };
+  SumKernel<PointType>               sum{ &smk, &scaledGk };
+
+  // the model holds a copy of the representer, the domains are compared point-wise
+  STATISMO_ASSERT_TRUE(smk.AcceptsPointIdsOf(model->GetDomain()));
+  STATISMO_ASSERT_TRUE(smk.AcceptsPointIdsOf(representer->GetDomain()));
+  STATISMO_ASSERT_TRUE(sum.AcceptsPointIdsOf(representer->GetDomain()));
+  auto otherRepresenter = RepresenterType::SafeCreate(gk_numPoints + 1);
+  STATISMO_ASSERT_FALSE(sum.AcceptsPointIdsOf(otherRepresenter->GetDomain()));
+
+  MatrixType res(1, 1);
+  for (unsigned i : { 0U, 50U, 199U })
+  {
+    for (unsigned j : { 3U, 50U, 120U })
+    {
+      sum.EvaluateAtDomainPoints(PointType{ i }, i, PointType{ j }, j, res);
+      STATISMO_ASSERT_LTE((res - sum(PointType{ i }, PointType{ j })).norm(), 1e-6);
+    }
+  }
+
+  // the builders evaluate the kernel from the point ids
+  auto nystrom = Nystrom<VectorType>::SafeCreateStd(representer.get(), sum, 10, 50);
+  auto points = representer->GetDomain().GetDomainPoints();
+
+  MatrixType fromIds = nystrom->ComputeEigenfunctionsAtDomainPoints(points, 20, 60);
+  MatrixType fromPoints = nystrom->ComputeEigenfunctionsAtPoints(points, 20, 60);
+  STATISMO_ASSERT_LTE((fromIds - fromPoints).norm(), 1e-4 * fromPoints.norm());
+
+  return EXIT_SUCCESS;
+}
+
+// fraction of the total variance of the process retained by the first components of model
+double
+ComputeRetainedVariance(const StatisticalModel<VectorType> & model, const VectorType & referenceVariance)
+{
+  return model.GetPCAVarianceVector().sum() / referenceVariance.sum();
+}
+
+int
+TestAdaptiveRankBuild()
+{
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexGaussianKernel            gk{ 10 };
+  UncorrelatedMatrixValuedKernel mk{ &gk, representer->GetDimensions() };
+  auto                           builder = ModelBuilderType::SafeCreate(representer.get());
+
+  // all the variance of the process, the kernel has a unit diagonal
+  VectorType referenceVariance =
+    builder->BuildNewZeroMeanModel(mk, 100, gk_numPoints)->GetPCAVarianceVector();
+  STATISMO_ASSERT_LTE(std::fabs(referenceVariance.sum() - gk_numPoints), 0.01 * gk_numPoints);
+
+  AdaptiveRankParameters params;
+  params.retainedVariance = 0.95;
+  params.initialNumComponents = 2;
+  params.initialNumPointsForNystrom = 10;
+
+  auto model = builder->BuildNewZeroMeanModelToTargetVariance(mk, params);
+  auto numComponents = model->GetNumberOfPrincipalComponents();
+  STATISMO_ASSERT_GT(numComponents, 2U);
+  STATISMO_ASSERT_LT(numComponents, 100U);
+  STATISMO_ASSERT_GTE(ComputeRetainedVariance(*model, referenceVariance), 0.93);
+  STATISMO_ASSERT_LTE(referenceVariance.head(numComponents - 1).sum() / referenceVariance.sum(), 0.97);
+
+  // a higher target needs more components
+  params.retainedVariance = 0.999;
+  auto largerModel = builder->BuildNewZeroMeanModelToTargetVariance(mk, params);
+  STATISMO_ASSERT_GT(largerModel->GetNumberOfPrincipalComponents(), numComponents);
+  STATISMO_ASSERT_GTE(ComputeRetainedVariance(*largerModel, referenceVariance), 0.99);
+
+  // the same, expressed as an error on the trace
+  params.retainedVariance = 1;
+  params.traceError = 0.05 * gk_numPoints;
+  auto traceErrorModel = builder->BuildNewZeroMeanModelToTargetVariance(mk, params);
+  STATISMO_ASSERT_GTE(ComputeRetainedVariance(*traceErrorModel, referenceVariance), 0.93);
+
+  // the limits are respected
+  params.traceError = 0;
+  params.maxNumComponents = 5;
+  auto limitedModel = builder->BuildNewZeroMeanModelToTargetVariance(mk, params);
+  STATISMO_ASSERT_EQ(limitedModel->GetNumberOfPrincipalComponents(), 5U);
+
+  params.retainedVariance = 1.5;
+  bool exceptionCaught = false;
+  try
+  {
+    builder->BuildNewZeroMeanModelToTargetVariance(mk, params);
+  }
+  catch (const StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestAdaptiveRankBuildCompactSupport()
+{
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexWendlandKernel            wk{ 30 };
+  UncorrelatedMatrixValuedKernel mk{ &wk, representer->GetDimensions() };
+  auto                           builder = ModelBuilderType::SafeCreate(representer.get());
+
+  VectorType referenceVariance =
+    builder->BuildNewZeroMeanModel(mk, 100, gk_numPoints)->GetPCAVarianceVector();
+
+  AdaptiveRankParameters params;
+  params.retainedVariance = 0.95;
+  params.initialNumComponents = 2;
+  params.initialNumPointsForNystrom = 10;
+
+  auto model = builder->BuildNewZeroMeanModelToTargetVariance(mk, params);
+  STATISMO_ASSERT_GTE(ComputeRetainedVariance(*model, referenceVariance), 0.93);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestCheckpointResume()
+{
+  const std::string kFilename = "gpModelBuilderCheckpoint.h5";
+  const auto        kInterval = std::chrono::milliseconds(0);
+  utils::RemoveFile(kFilename);
+
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexGaussianKernel            gk{ 20 };
+  UncorrelatedMatrixValuedKernel mk{ &gk, representer->GetDimensions() };
+  auto                           builder = ModelBuilderType::SafeCreate(representer.get());
+  builder->SetTileSize(16);
+
+  builder->SetCheckpoint(BuildCheckpoint::SafeCreateStd(kFilename, kInterval));
+  auto model = builder->BuildNewZeroMeanModel(mk, 20, 100);
+  builder->SetCheckpoint(nullptr);
+
+  // simulate an interrupted build, where only some tiles of the basis were stored
+  {
+    auto checkpoint = BuildCheckpoint::SafeCreateStd(kFilename, kInterval);
+    checkpoint->WriteIndices("basisTiles", { 0, 1, 3 });
+    checkpoint->WriteRows("basis", gk_numPoints, 2 * 16, MatrixType::Zero(16, 20));
+  }
+
+  // the Nystrom approximation is not recomputed, even though the random points would differ
+  rand::RandGen().seed(42);
+  builder->SetCheckpoint(BuildCheckpoint::SafeCreateStd(kFilename, kInterval));
+  auto resumedModel = builder->BuildNewZeroMeanModel(mk, 20, 100);
+  STATISMO_ASSERT_TRUE(resumedModel->GetPCABasisMatrix() == model->GetPCABasisMatrix());
+  STATISMO_ASSERT_TRUE(resumedModel->GetPCAVarianceVector() == model->GetPCAVarianceVector());
+
+  // the state of another build is discarded
+  auto otherModel = builder->BuildNewZeroMeanModel(mk, 10, 100);
+  STATISMO_ASSERT_EQ(otherModel->GetNumberOfPrincipalComponents(), 10U);
+  auto otherAdaptiveModel = builder->BuildNewZeroMeanModelToTargetVariance(mk, AdaptiveRankParameters{});
+  STATISMO_ASSERT_GT(otherAdaptiveModel->GetNumberOfPrincipalComponents(), 0U);
+
+  builder->SetCheckpoint(nullptr);
+  utils::RemoveFile(kFilename);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestProgressAndCancellation()
+{
+  auto                           representer = RepresenterType::SafeCreate(gk_numPoints);
+  IndexGaussianKernel            gk{ 20 };
+  UncorrelatedMatrixValuedKernel mk{ &gk, representer->GetDimensions() };
+  auto                           builder = ModelBuilderType::SafeCreate(representer.get());
+  builder->SetTileSize(10);
+
+  std::vector<BuildProgress> reports;
+  builder->SetProgressCallback([&](const BuildProgress & progress) {
+    reports.push_back(progress);
+    return true;
+  });
+  builder->BuildNewZeroMeanModel(mk, 20, 100);
+
+  STATISMO_ASSERT_EQ(reports.front().stage, std::string("Nystrom approximation"));
+  STATISMO_ASSERT_EQ(reports.back().stage, std::string("Basis"));
+  STATISMO_ASSERT_EQ(reports.back().completedUnits, std::size_t{ gk_numPoints / 10 });
+  STATISMO_ASSERT_EQ(reports.back().totalUnits, std::size_t{ gk_numPoints / 10 });
+  for (std::size_t i = 1; i < reports.size(); ++i)
+  {
+    STATISMO_ASSERT_TRUE(reports[i].elapsed >= reports[i - 1].elapsed);
+  }
+
+  // cancel the build after some tiles
+  std::size_t numReports = 0;
+  builder->SetProgressCallback([&](const BuildProgress & progress) {
+    ++numReports;
+    return progress.stage != "Basis" || progress.completedUnits < 3;
+  });
+
+  Status status = Status::SUCCESS;
+  try
+  {
+    builder->BuildNewZeroMeanModel(mk, 20, 100);
+  }
+  catch (const StatisticalModelException & e)
+  {
+    status = e.GetStatus();
+  }
+  STATISMO_ASSERT_TRUE(status == Status::CANCELLED);
+  STATISMO_ASSERT_LT(numReports, reports.size());
+
+  // cancel the build on the first report of the basis stage, before any tile is computed
+  std::size_t numBasisReports = 0;
+  builder->SetProgressCallback([&](const BuildProgress & progress) {
+    numBasisReports += (progress.stage == "Basis") ? 1 : 0;
+    return progress.stage != "Basis";
+  });
+
+  status = Status::SUCCESS;
+  try
+  {
+    builder->BuildNewZeroMeanModel(mk, 20, 100);
+  }
+  catch (const StatisticalModelException & e)
+  {
+    status = e.GetStatus();
+  }
+  STATISMO_ASSERT_TRUE(status == Status::CANCELLED);
+  STATISMO_ASSERT_EQ(numBasisReports, std::size_t{ 1 });
+
+  // the pool is released and can be used by the next build
+  builder->SetProgressCallback(nullptr);
+  auto model = builder->BuildNewZeroMeanModel(mk, 20, 100);
+  STATISMO_ASSERT_EQ(model->GetNumberOfPrincipalComponents(), 20U);
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestKroneckerBuild()
+{
+  // 12 x 10 grid with a spacing of 0.5 along the first axis
+  constexpr unsigned kNx = 12;
+  constexpr unsigned kNy = 10;
+
+  KroneckerGPModelBuilder<VectorType>::GridType grid(2);
+  for (unsigned i = 0; i < kNx; ++i)
+  {
+    grid[0].push_back(0.5 * i);
+  }
+  for (unsigned i = 0; i < kNy; ++i)
+  {
+    grid[1].push_back(i);
+  }
+
+  auto               representer = RepresenterType::SafeCreate(kNx * kNy);
+  AxisGaussianKernel gx{ 2 };
+  AxisGaussianKernel gy{ 3 };
+
+  auto builder = KroneckerGPModelBuilder<VectorType>::SafeCreate(representer.get());
+
+  // with all the components, the model covariance is the kernel itself
+  auto fullModel = builder->BuildNewZeroMeanModel({ &gx, &gy }, grid, kNx * kNy);
+  for (unsigned p : { 0U, 17U, 64U })
+  {
+    for (unsigned q : { 3U, 17U, 119U })
+    {
+      auto cov = fullModel->GetCovarianceAtPoint(p, q);
+      auto k = gx(grid[0][p % kNx], grid[0][q % kNx]) * gy(grid[1][p / kNx], grid[1][q / kNx]);
+      STATISMO_ASSERT_LTE(std::fabs(cov(0, 0) - k), 1e-4);
+    }
+  }
+
+  // the leading eigenvalues are the ones of the full kernel matrix
+  MatrixTypeDoublePrecision k(kNx * kNy, kNx * kNy);
+  for (unsigned p = 0; p < kNx * kNy; ++p)
+  {
+    for (unsigned q = 0; q < kNx * kNy; ++q)
+    {
+      k(p, q) = gx(grid[0][p % kNx], grid[0][q % kNx]) * gy(grid[1][p / kNx], grid[1][q / kNx]);
+    }
+  }
+  VectorTypeDoublePrecision eigenvalues = Eigen::SelfAdjointEigenSolver<MatrixTypeDoublePrecision>(k).eigenvalues();
+
+  auto model = builder->BuildNewZeroMeanModel({ &gx, &gy }, grid, 15);
+  STATISMO_ASSERT_EQ(15U, model->GetNumberOfPrincipalComponents());
+  for (unsigned i = 0; i < 15; ++i)
+  {
+    STATISMO_ASSERT_LTE(std::fabs(model->GetPCAVarianceVector()(i) - eigenvalues(kNx * kNy - 1 - i)), 1e-3);
+  }
+
+  // the grid must match the domain
+  grid[1].pop_back();
+  bool exceptionCaught = false;
+  try
+  {
+    builder->BuildNewZeroMeanModel({ &gx, &gy }, grid, 15);
+  }
+  catch (const StatisticalModelException &)
+  {
+    exceptionCaught = true;
+  }
+  STATISMO_ASSERT_TRUE(exceptionCaught);
+
+  return EXIT_SUCCESS;
+}
+} // namespace
+
+/**
+ * This test case covers the gaussian process model building
+ */
+int gpModelBuilderTest([[maybe_unused]] int argc, [[maybe_unused]] char * argv[]) // NOLINT
+{
+  auto res = statismo::Translate([]() {
+    return statismo::test::RunAllTests("gpModelBuilderTest",
+                                       { { "TestTiledEigenfunctions", TestTiledEigenfunctions },
+                                         { "TestBuildWithSharedPool", TestBuildWithSharedPool },
+                                         { "TestKroneckerBuild", TestKroneckerBuild },
+                                         { "TestCompactlySupportedKernel", TestCompactlySupportedKernel },
+                                         { "TestSpatiallyVaryingKernelTable", TestSpatiallyVaryingKernelTable },
+                                         { "TestKernelExpressions", TestKernelExpressions },
+                                         { "TestStatisticalModelKernelPointIds", TestStatisticalModelKernelPointIds },
+                                         { "TestAdaptiveRankBuild", TestAdaptiveRankBuild },
+                                         { "TestAdaptiveRankBuildCompactSupport", TestAdaptiveRankBuildCompactSupport },
+                                         { "TestCheckpointResume", TestCheckpointResume },
+                                         { "TestProgressAndCancellation", TestProgressAndCancellation } });
+  });
+
+  return !CheckResultAndAssert(res, EXIT_SUCCESS);
+}
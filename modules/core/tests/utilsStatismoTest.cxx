@@ -39,6 +39,7 @@
 #include "statismo/core/Utils.h"
 #include "statismo/core/ThreadPool.h"
 #include "statismo/core/SafeContainer.h"
+#include "statismo/core/SpatialIndex.h"
 
 using namespace statismo;
 
@@ -90,6 +91,35 @@ TestThreadPool()
   return EXIT_SUCCESS;
 }
 
+int
+TestThreadPoolBlockingMode()
+{
+  ThreadPool t{ 2, ThreadPool::WaitingMode::BLOCK, 0 };
+
+  STATISMO_ASSERT_GTE(t.GetNumberOfThreads(), 1U);
+
+  // the workers sleep between the two batches and must be woken up by Submit
+  for (unsigned batch = 0; batch < 2; ++batch)
+  {
+    std::vector<std::future<unsigned>> futs;
+    for (unsigned i = 0; i < 100; ++i)
+    {
+      futs.emplace_back(t.Submit([i]() { return i; }));
+    }
+
+    unsigned sum{ 0 };
+    for (auto & f : futs)
+    {
+      sum += f.get();
+    }
+    STATISMO_ASSERT_EQ(4950U, sum);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  return EXIT_SUCCESS;
+}
+
 int
 TestSafeContainerQueue()
 {
@@ -161,6 +191,87 @@ TestSafeContainerMap()
 
   return EXIT_SUCCESS;
 }
+
+int
+TestSafeContainerShardedMap()
+{
+  statismo::SafeShardedUnorderedMap<std::string, int> myMap;
+
+  STATISMO_ASSERT_TRUE(myMap.Empty());
+  STATISMO_ASSERT_EQ(0U, myMap.Size());
+
+  // concurrent writers and readers
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&myMap, t]() {
+      for (int i = 0; i < 100; ++i)
+      {
+        myMap.Insert(std::make_pair("test" + std::to_string(t * 100 + i), t * 100 + i));
+        int val;
+        myMap.Find("test" + std::to_string(t * 100), val);
+      }
+    });
+  }
+  for (auto & t : threads)
+  {
+    t.join();
+  }
+
+  STATISMO_ASSERT_EQ(400U, myMap.Size());
+
+  int val;
+  STATISMO_ASSERT_TRUE(myMap.Find("test1", val));
+  STATISMO_ASSERT_EQ(1, val);
+
+  STATISMO_ASSERT_TRUE(myMap.Find("test399", val));
+  STATISMO_ASSERT_EQ(399, val);
+
+  STATISMO_ASSERT_FALSE(myMap.Find("test400", val));
+
+  return EXIT_SUCCESS;
+}
+
+int
+TestSpatialIndex()
+{
+  // local generator, so that the framework generator sequence used by the other tests is unchanged
+  std::minstd_rand                       gen{ 0 };
+  std::uniform_real_distribution<double> dist(-10, 10);
+
+  statismo::SpatialIndex::PointListType pts;
+  for (unsigned i = 0; i < 500; ++i)
+  {
+    statismo::VectorType pt(2);
+    pt << dist(gen), dist(gen);
+    pts.push_back(pt);
+  }
+
+  statismo::SpatialIndex index{ pts, 1.5 };
+  STATISMO_ASSERT_EQ(500U, index.GetNumberOfPoints());
+
+  // the radius can be larger than the cell size
+  for (double radius : { 0.5, 1.5, 4.0 })
+  {
+    for (unsigned q = 0; q < 20; ++q)
+    {
+      auto found = index.FindPointsInRadius(pts[q], radius);
+      std::sort(std::begin(found), std::end(found));
+
+      std::vector<unsigned> expected;
+      for (unsigned i = 0; i < pts.size(); ++i)
+      {
+        if ((pts[i] - pts[q]).norm() <= radius)
+        {
+          expected.push_back(i);
+        }
+      }
+      STATISMO_ASSERT_TRUE(found == expected);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
 } // namespace
 
 
@@ -174,8 +285,11 @@ int utilsStatismoTest([[maybe_unused]] int argc, [[maybe_unused]] char * argv[])
     return statismo::test::RunAllTests("utilsStatismoTest",
                                        { { "TestUtils", TestUtils },
                                          { "TestThreadPool", TestThreadPool },
+                                         { "TestThreadPoolBlockingMode", TestThreadPoolBlockingMode },
                                          { "TestSafeContainerQueue", TestSafeContainerQueue },
-                                         { "TestSafeContainerMap", TestSafeContainerMap } });
+                                         { "TestSafeContainerMap", TestSafeContainerMap },
+                                         { "TestSafeContainerShardedMap", TestSafeContainerShardedMap },
+                                         { "TestSpatialIndex", TestSpatialIndex } });
   });
 
   return !CheckResultAndAssert(res, EXIT_SUCCESS);